@@ -617,8 +617,7 @@ _solve()
     }
   }
 
-  m_u1.synchronize();
-  m_u2.synchronize();
+  synchronizeVariables(m_u1, m_u2);
 
   const bool do_print = (allNodes().size() < 200);
   if (do_print) {
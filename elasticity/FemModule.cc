@@ -11,23 +11,80 @@
 /*---------------------------------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
 
+#include <arcane/utils/ApplicationInfo.h>
+#include <arcane/utils/CommandLineArguments.h>
+#include <arcane/utils/ParameterList.h>
+
 #include <arcane/ITimeLoopMng.h>
 #include <arcane/IMesh.h>
 #include <arcane/IItemFamily.h>
 #include <arcane/ItemGroup.h>
 #include <arcane/ICaseMng.h>
+#include <arcane/core/IApplication.h>
+#include <arcane/core/ItemGenericInfoListView.h>
+#include <arcane/core/UnstructuredMeshConnectivity.h>
+
+#include <arcane/accelerator/core/IAcceleratorMng.h>
+#include <arcane/accelerator/RunCommandEnumerate.h>
+#include <arcane/accelerator/VariableViews.h>
+#include <arcane/accelerator/NumArrayViews.h>
+#include <arcane/accelerator/Atomic.h>
 
 #include "IDoFLinearSystemFactory.h"
 #include "Fem_axl.h"
 #include "FemUtils.h"
 #include "DoFLinearSystem.h"
 #include "FemDoFsOnNodes.h"
+#include "FemGeometryCache.h"
+#include "CsrFormatMatrix.h"
+#include "BsrFormatMatrix.h"
 
 /*---------------------------------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
 
 using namespace Arcane;
 using namespace Arcane::FemUtils;
+namespace ax = Arcane::Accelerator;
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
+namespace
+{
+  /*!
+   * \brief Compute the 2x2 block of the elementary matrix of a TRIA3 cell
+   * which couples the nodes \a i and \a j.
+   *
+   * \a gi and \a gj are the gradients of the shape functions of the nodes and
+   * \a area is the (positive) area of the cell. The row of the block is the
+   * component of the test function and the column the component of the
+   * unknown. This is the same matrix as _computeElementMatrixTRIA3().
+   */
+  ARCCORE_HOST_DEVICE inline void
+  _computeElementBlockTRIA3(Real2 gi, Real2 gj, Real area, Real lambda, Real mu, Real block[2][2])
+  {
+    block[0][0] = area * ((lambda + 2 * mu) * gi.x * gj.x + mu * gi.y * gj.y);
+    block[0][1] = area * (lambda * gi.x * gj.y + mu * gi.y * gj.x);
+    block[1][0] = area * (lambda * gi.y * gj.x + mu * gi.x * gj.y);
+    block[1][1] = area * ((lambda + 2 * mu) * gi.y * gj.y + mu * gi.x * gj.x);
+  }
+
+  /*!
+   * \brief Index of \a column in \a columns between \a begin and \a end or (-1) if not found.
+   *
+   * The column is always found if the structure of the matrix has been
+   * computed from the mesh. The callers check the index anyway so that a
+   * wrong structure can not write outside of the values.
+   */
+  template <typename ColumnView> ARCCORE_HOST_DEVICE inline Int32
+  _findColumnIndex(const ColumnView& columns, Int32 begin, Int32 end, Int32 column)
+  {
+    for (Int32 k = begin; k < end; ++k)
+      if (columns[k] == column)
+        return k;
+    return (-1);
+  }
+} // namespace
 
 /*---------------------------------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
@@ -42,6 +99,9 @@ class FemModule
   explicit FemModule(const ModuleBuildInfo& mbi)
   : ArcaneFemObject(mbi)
   , m_dofs_on_nodes(mbi.subDomain()->traceMng())
+  , m_geometry(mbi.subDomain()->traceMng())
+  , m_csr_matrix(mbi.subDomain())
+  , m_bsr_matrix(mbi.subDomain())
   {
     ICaseMng* cm = mbi.subDomain()->caseMng();
     cm->setTreatWarningAsError(true);
@@ -72,12 +132,31 @@ class FemModule
 
   DoFLinearSystem m_linear_system;
   FemDoFsOnNodes m_dofs_on_nodes;
+  FemGeometryCache m_geometry;
+  CsrFormat m_csr_matrix;
+  BsrFormat m_bsr_matrix;
+
+  bool m_use_legacy = true;
+  bool m_use_csr_gpu = false;
+  bool m_use_nodewise_csr = false;
+  bool m_use_bsr_gpu = false;
+  bool m_use_nodewise_bsr = false;
+  bool m_check_bsr_multiply = false;
 
  private:
 
   void _doStationarySolve();
   void _getMaterialParameters();
+  void _handleFlags();
   void _assembleBilinearOperatorTRIA3();
+  void _assembleAcceleratorBilinearOperatorTRIA3();
+  void _assembleCsrGpuBilinearOperatorTRIA3(RunQueue* queue);
+  void _assembleNodeWiseCsrBilinearOperatorTRIA3(RunQueue* queue);
+  void _assembleBsrGpuBilinearOperatorTRIA3(RunQueue* queue);
+  void _assembleNodeWiseBsrBilinearOperatorTRIA3(RunQueue* queue);
+  void _applyPenaltyToCsrMatrix(RunQueue* queue, Real penalty, bool is_add);
+  void _applyPenaltyToBsrMatrix(RunQueue* queue, Real penalty, bool is_add);
+  void _checkBsrMultiply(RunQueue* queue);
   void _solve();
   void _initBoundaryconditions();
   void _assembleLinearOperator();
@@ -118,6 +197,7 @@ startInit()
 
   m_dofs_on_nodes.initialize(mesh(), 2);
 
+  _handleFlags();
   _initBoundaryconditions();
 }
 
@@ -131,7 +211,10 @@ _doStationarySolve()
   _getMaterialParameters();
 
   // Assemble the FEM bilinear operator (LHS - matrix A)
-  _assembleBilinearOperatorTRIA3();
+  if (m_use_legacy)
+    _assembleBilinearOperatorTRIA3();
+  else
+    _assembleAcceleratorBilinearOperatorTRIA3();
 
   // Assemble the FEM linear operator (RHS - vector b)
   _assembleLinearOperator();
@@ -162,6 +245,45 @@ _getMaterialParameters()
 /*---------------------------------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
 
+void FemModule::
+_handleFlags()
+{
+  ParameterList parameter_list = this->subDomain()->application()->applicationInfo().commandLineArguments().parameters();
+  if (parameter_list.getParameterOrNull("CSR_GPU") == "TRUE" || options()->csrGpu()) {
+    m_use_csr_gpu = true;
+    m_use_legacy = false;
+    info() << "CSR_GPU: The CSR matrix is assembled on accelerator by iterating on the cells";
+  }
+  if (parameter_list.getParameterOrNull("NWCSR") == "TRUE" || options()->nwcsr()) {
+    m_use_nodewise_csr = true;
+    m_use_legacy = false;
+    info() << "NWCSR: The CSR matrix is assembled on accelerator by iterating on the nodes";
+  }
+  if (parameter_list.getParameterOrNull("BSR_GPU") == "TRUE" || options()->bsrGpu()) {
+    m_use_bsr_gpu = true;
+    m_use_legacy = false;
+    info() << "BSR_GPU: The BSR matrix is assembled on accelerator by iterating on the cells";
+  }
+  if (parameter_list.getParameterOrNull("NWBSR") == "TRUE" || options()->nwbsr()) {
+    m_use_nodewise_bsr = true;
+    m_use_legacy = false;
+    info() << "NWBSR: The BSR matrix is assembled on accelerator by iterating on the nodes";
+  }
+  if (parameter_list.getParameterOrNull("CHECK_BSR_MULTIPLY") == "TRUE" || options()->checkBsrMultiply()) {
+    m_check_bsr_multiply = true;
+    info() << "CHECK_BSR_MULTIPLY: The product of the BSR matrix is compared to the one of the CSR matrix";
+  }
+  const Int32 nb_method = (m_use_csr_gpu ? 1 : 0) + (m_use_nodewise_csr ? 1 : 0) +
+  (m_use_bsr_gpu ? 1 : 0) + (m_use_nodewise_bsr ? 1 : 0);
+  if (nb_method > 1)
+    ARCANE_FATAL("Only one of CSR_GPU, NWCSR, BSR_GPU and NWBSR assembly methods can be used at a time");
+  if (m_use_legacy)
+    info() << "DOK: The legacy assembly with matrixAddValue() will be used";
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
 void FemModule::
 _initBoundaryconditions()
 {
@@ -309,6 +431,9 @@ _assembleLinearOperator()
     //
     //  - For RHS vector b the term that corresponds to the Dirichlet DOF
     //           b_{i} = b_{i} * P
+    //
+    //  With the accelerator assemblies, the LHS part has already been
+    //  applied to the CSR or BSR matrix before its translation.
     //----------------------------------------------
 
     info() << "Applying Dirichlet boundary condition via "
@@ -320,7 +445,8 @@ _assembleLinearOperator()
       NodeLocalId node_id = *inode;
       if (m_u1_fixed[node_id]) {
         DoFLocalId dof_id1 = node_dof.dofId(node_id, 0);
-        m_linear_system.matrixSetValue(dof_id1, dof_id1, Penalty);
+        if (m_use_legacy)
+          m_linear_system.matrixSetValue(dof_id1, dof_id1, Penalty);
         {
           Real u1_dirichlet = Penalty * m_U[node_id].x;
           rhs_values[dof_id1] = u1_dirichlet;
@@ -328,7 +454,8 @@ _assembleLinearOperator()
       }
       if (m_u2_fixed[node_id]) {
         DoFLocalId dof_id2 = node_dof.dofId(node_id, 1);
-        m_linear_system.matrixSetValue(dof_id2, dof_id2, Penalty);
+        if (m_use_legacy)
+          m_linear_system.matrixSetValue(dof_id2, dof_id2, Penalty);
         {
           Real u2_dirichlet = Penalty * m_U[node_id].y;
           rhs_values[dof_id2] = u2_dirichlet;
@@ -359,7 +486,8 @@ _assembleLinearOperator()
       NodeLocalId node_id = *inode;
       if (m_u1_fixed[node_id]) {
         DoFLocalId dof_id1 = node_dof.dofId(node_id, 0);
-        m_linear_system.matrixAddValue(dof_id1, dof_id1, Penalty);
+        if (m_use_legacy)
+          m_linear_system.matrixAddValue(dof_id1, dof_id1, Penalty);
         {
           Real u1_dirichlet = Penalty * m_U[node_id].x;
           rhs_values[dof_id1] = u1_dirichlet;
@@ -367,7 +495,8 @@ _assembleLinearOperator()
       }
       if (m_u2_fixed[node_id]) {
         DoFLocalId dof_id2 = node_dof.dofId(node_id, 1);
-        m_linear_system.matrixAddValue(dof_id2, dof_id2, Penalty);
+        if (m_use_legacy)
+          m_linear_system.matrixAddValue(dof_id2, dof_id2, Penalty);
         {
           Real u2_dirichlet = Penalty * m_U[node_id].y;
           rhs_values[dof_id2] = u2_dirichlet;
@@ -904,6 +1033,426 @@ _assembleBilinearOperatorTRIA3()
   }
 }
 
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*!
+ * \brief Assemble the bilinear operator on accelerator.
+ *
+ * The values are written directly in a CSR (one row per DoF) or a BSR (one
+ * 2x2 block per pair of nodes) matrix which is then translated to the linear
+ * system. For the Penalty and WeakPenalty methods, the diagonal terms of the
+ * Dirichlet DoFs are also set in this matrix because the linear system may
+ * not allow to modify values after the translation.
+ */
+void FemModule::
+_assembleAcceleratorBilinearOperatorTRIA3()
+{
+  RunQueue* queue = acceleratorMng()->defaultQueue();
+  auto node_dof(m_dofs_on_nodes.nodeDoFConnectivityView());
+  IItemFamily* dof_family = m_dofs_on_nodes.dofFamily();
+
+  // Also checks that all the cells are Triangle3
+  m_geometry.computeCellGeometry(allCells(), m_node_coord, *queue);
+
+  const String dirichlet_method = options()->enforceDirichletMethod();
+  const bool has_penalty = (dirichlet_method == "Penalty" || dirichlet_method == "WeakPenalty");
+  const bool is_weak_penalty = (dirichlet_method == "WeakPenalty");
+
+  if (m_use_bsr_gpu || m_use_nodewise_bsr) {
+    m_bsr_matrix.initialize(dof_family, 2, mesh()->nodeFamily()->maxLocalId(), 0);
+    m_bsr_matrix.computeSparsity(mesh(), *queue);
+    if (m_use_bsr_gpu)
+      _assembleBsrGpuBilinearOperatorTRIA3(queue);
+    else
+      _assembleNodeWiseBsrBilinearOperatorTRIA3(queue);
+    if (has_penalty)
+      _applyPenaltyToBsrMatrix(queue, options()->penalty(), is_weak_penalty);
+    if (m_check_bsr_multiply)
+      _checkBsrMultiply(queue);
+    m_bsr_matrix.translateToLinearSystem(m_linear_system, node_dof);
+  }
+  else {
+    m_csr_matrix.computeSparsity(dof_family, mesh(), node_dof, 2, *queue);
+    if (m_use_csr_gpu)
+      _assembleCsrGpuBilinearOperatorTRIA3(queue);
+    else
+      _assembleNodeWiseCsrBilinearOperatorTRIA3(queue);
+    if (has_penalty)
+      _applyPenaltyToCsrMatrix(queue, options()->penalty(), is_weak_penalty);
+    m_csr_matrix.translateToLinearSystem(m_linear_system);
+  }
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*!
+ * \brief Cell-wise assembly in the CSR matrix.
+ *
+ * Each cell adds its 6x6 elementary matrix in the rows of its own nodes.
+ * As several cells share the same rows, the additions are atomic.
+ */
+void FemModule::
+_assembleCsrGpuBilinearOperatorTRIA3(RunQueue* queue)
+{
+  info() << "Assembly of the CSR matrix by iterating on the cells";
+  auto command = makeCommand(queue);
+
+  auto node_dof(m_dofs_on_nodes.nodeDoFConnectivityView());
+  auto in_row = ax::viewIn(command, m_csr_matrix.m_matrix_row);
+  auto in_rows_nb_column = ax::viewIn(command, m_csr_matrix.m_matrix_rows_nb_column);
+  auto in_column = ax::viewIn(command, m_csr_matrix.m_matrix_column);
+  auto in_out_value = ax::viewInOut(command, m_csr_matrix.m_matrix_value);
+  auto in_measure = ax::viewIn(command, m_geometry.m_cell_measure);
+  auto in_gradient_x = ax::viewIn(command, m_geometry.m_cell_gradient_x);
+  auto in_gradient_y = ax::viewIn(command, m_geometry.m_cell_gradient_y);
+
+  UnstructuredMeshConnectivityView connectivity_view;
+  connectivity_view.setMesh(mesh());
+  auto cnc = connectivity_view.cellNode();
+  ItemGenericInfoListView nodes_infos(mesh()->nodeFamily());
+
+  const Real c_lambda = lambda;
+  const Real c_mu = mu2 / 2;
+
+  command << RUNCOMMAND_ENUMERATE(Cell, cell, allCells())
+  {
+    const Int32 lid = cell.localId();
+    const Real area = math::abs(in_measure(lid));
+    for (Int32 i = 0; i < 3; ++i) {
+      NodeLocalId node1 = cnc.nodeId(cell, i);
+      if (!nodes_infos.isOwn(node1))
+        continue;
+      Real2 gi(in_gradient_x(lid, i), in_gradient_y(lid, i));
+      for (Int32 j = 0; j < 3; ++j) {
+        NodeLocalId node2 = cnc.nodeId(cell, j);
+        Real2 gj(in_gradient_x(lid, j), in_gradient_y(lid, j));
+        Real block[2][2];
+        _computeElementBlockTRIA3(gi, gj, area, c_lambda, c_mu, block);
+        for (Int32 a = 0; a < 2; ++a) {
+          const Int32 row = node_dof.dofId(node1, a).localId();
+          const Int32 begin = in_row(row);
+          const Int32 end = begin + in_rows_nb_column(row);
+          for (Int32 b = 0; b < 2; ++b) {
+            Int32 index = _findColumnIndex(in_column, begin, end, node_dof.dofId(node2, b).localId());
+            if (index >= 0)
+              ax::doAtomic<ax::eAtomicOperation::Add>(in_out_value(index), block[a][b]);
+          }
+        }
+      }
+    }
+  };
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*!
+ * \brief Node-wise assembly in the CSR matrix.
+ *
+ * Each own node gathers the contributions of its cells to its two rows.
+ * A row is written by only one thread so no atomic operation is needed.
+ */
+void FemModule::
+_assembleNodeWiseCsrBilinearOperatorTRIA3(RunQueue* queue)
+{
+  info() << "Assembly of the CSR matrix by iterating on the nodes";
+  auto command = makeCommand(queue);
+
+  auto node_dof(m_dofs_on_nodes.nodeDoFConnectivityView());
+  auto in_row = ax::viewIn(command, m_csr_matrix.m_matrix_row);
+  auto in_rows_nb_column = ax::viewIn(command, m_csr_matrix.m_matrix_rows_nb_column);
+  auto in_column = ax::viewIn(command, m_csr_matrix.m_matrix_column);
+  auto in_out_value = ax::viewInOut(command, m_csr_matrix.m_matrix_value);
+  auto in_measure = ax::viewIn(command, m_geometry.m_cell_measure);
+  auto in_gradient_x = ax::viewIn(command, m_geometry.m_cell_gradient_x);
+  auto in_gradient_y = ax::viewIn(command, m_geometry.m_cell_gradient_y);
+
+  UnstructuredMeshConnectivityView connectivity_view;
+  connectivity_view.setMesh(mesh());
+  auto cnc = connectivity_view.cellNode();
+  auto nc = connectivity_view.nodeCell();
+
+  const Real c_lambda = lambda;
+  const Real c_mu = mu2 / 2;
+
+  command << RUNCOMMAND_ENUMERATE(Node, node, ownNodes())
+  {
+    for (CellLocalId cell : nc.cells(node)) {
+      const Int32 lid = cell.localId();
+      const Real area = math::abs(in_measure(lid));
+      Int32 i = 0;
+      while (cnc.nodeId(cell, i) != node)
+        ++i;
+      Real2 gi(in_gradient_x(lid, i), in_gradient_y(lid, i));
+      for (Int32 j = 0; j < 3; ++j) {
+        NodeLocalId node2 = cnc.nodeId(cell, j);
+        Real2 gj(in_gradient_x(lid, j), in_gradient_y(lid, j));
+        Real block[2][2];
+        _computeElementBlockTRIA3(gi, gj, area, c_lambda, c_mu, block);
+        for (Int32 a = 0; a < 2; ++a) {
+          const Int32 row = node_dof.dofId(node, a).localId();
+          const Int32 begin = in_row(row);
+          const Int32 end = begin + in_rows_nb_column(row);
+          for (Int32 b = 0; b < 2; ++b) {
+            Int32 index = _findColumnIndex(in_column, begin, end, node_dof.dofId(node2, b).localId());
+            if (index >= 0)
+              in_out_value(index) += block[a][b];
+          }
+        }
+      }
+    }
+  };
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*!
+ * \brief Cell-wise assembly in the BSR matrix.
+ *
+ * Same as _assembleCsrGpuBilinearOperatorTRIA3() but only one search is
+ * needed for the four values of a block.
+ */
+void FemModule::
+_assembleBsrGpuBilinearOperatorTRIA3(RunQueue* queue)
+{
+  info() << "Assembly of the BSR matrix by iterating on the cells";
+  auto command = makeCommand(queue);
+
+  auto in_block_row = ax::viewIn(command, m_bsr_matrix.m_block_row);
+  auto in_block_column = ax::viewIn(command, m_bsr_matrix.m_block_column);
+  auto in_out_block_value = ax::viewInOut(command, m_bsr_matrix.m_block_value);
+  auto in_measure = ax::viewIn(command, m_geometry.m_cell_measure);
+  auto in_gradient_x = ax::viewIn(command, m_geometry.m_cell_gradient_x);
+  auto in_gradient_y = ax::viewIn(command, m_geometry.m_cell_gradient_y);
+
+  UnstructuredMeshConnectivityView connectivity_view;
+  connectivity_view.setMesh(mesh());
+  auto cnc = connectivity_view.cellNode();
+  ItemGenericInfoListView nodes_infos(mesh()->nodeFamily());
+
+  const Real c_lambda = lambda;
+  const Real c_mu = mu2 / 2;
+
+  command << RUNCOMMAND_ENUMERATE(Cell, cell, allCells())
+  {
+    const Int32 lid = cell.localId();
+    const Real area = math::abs(in_measure(lid));
+    for (Int32 i = 0; i < 3; ++i) {
+      NodeLocalId node1 = cnc.nodeId(cell, i);
+      if (!nodes_infos.isOwn(node1))
+        continue;
+      Real2 gi(in_gradient_x(lid, i), in_gradient_y(lid, i));
+      const Int32 begin = in_block_row(node1.localId());
+      const Int32 end = in_block_row(node1.localId() + 1);
+      for (Int32 j = 0; j < 3; ++j) {
+        NodeLocalId node2 = cnc.nodeId(cell, j);
+        Real2 gj(in_gradient_x(lid, j), in_gradient_y(lid, j));
+        Real block[2][2];
+        _computeElementBlockTRIA3(gi, gj, area, c_lambda, c_mu, block);
+        const Int32 block_index = _findColumnIndex(in_block_column, begin, end, node2.localId());
+        if (block_index < 0)
+          continue;
+        const Int32 index = block_index * 4;
+        for (Int32 a = 0; a < 2; ++a)
+          for (Int32 b = 0; b < 2; ++b)
+            ax::doAtomic<ax::eAtomicOperation::Add>(in_out_block_value(index + a * 2 + b), block[a][b]);
+      }
+    }
+  };
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*!
+ * \brief Node-wise assembly in the BSR matrix.
+ *
+ * Each own node gathers the contributions of its cells to its block row.
+ */
+void FemModule::
+_assembleNodeWiseBsrBilinearOperatorTRIA3(RunQueue* queue)
+{
+  info() << "Assembly of the BSR matrix by iterating on the nodes";
+  auto command = makeCommand(queue);
+
+  auto in_block_row = ax::viewIn(command, m_bsr_matrix.m_block_row);
+  auto in_block_column = ax::viewIn(command, m_bsr_matrix.m_block_column);
+  auto in_out_block_value = ax::viewInOut(command, m_bsr_matrix.m_block_value);
+  auto in_measure = ax::viewIn(command, m_geometry.m_cell_measure);
+  auto in_gradient_x = ax::viewIn(command, m_geometry.m_cell_gradient_x);
+  auto in_gradient_y = ax::viewIn(command, m_geometry.m_cell_gradient_y);
+
+  UnstructuredMeshConnectivityView connectivity_view;
+  connectivity_view.setMesh(mesh());
+  auto cnc = connectivity_view.cellNode();
+  auto nc = connectivity_view.nodeCell();
+
+  const Real c_lambda = lambda;
+  const Real c_mu = mu2 / 2;
+
+  command << RUNCOMMAND_ENUMERATE(Node, node, ownNodes())
+  {
+    const Int32 begin = in_block_row(node.localId());
+    const Int32 end = in_block_row(node.localId() + 1);
+    for (CellLocalId cell : nc.cells(node)) {
+      const Int32 lid = cell.localId();
+      const Real area = math::abs(in_measure(lid));
+      Int32 i = 0;
+      while (cnc.nodeId(cell, i) != node)
+        ++i;
+      Real2 gi(in_gradient_x(lid, i), in_gradient_y(lid, i));
+      for (Int32 j = 0; j < 3; ++j) {
+        NodeLocalId node2 = cnc.nodeId(cell, j);
+        Real2 gj(in_gradient_x(lid, j), in_gradient_y(lid, j));
+        Real block[2][2];
+        _computeElementBlockTRIA3(gi, gj, area, c_lambda, c_mu, block);
+        const Int32 block_index = _findColumnIndex(in_block_column, begin, end, node2.localId());
+        if (block_index < 0)
+          continue;
+        const Int32 index = block_index * 4;
+        for (Int32 a = 0; a < 2; ++a)
+          for (Int32 b = 0; b < 2; ++b)
+            in_out_block_value(index + a * 2 + b) += block[a][b];
+      }
+    }
+  };
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*!
+ * \brief Set (or add if \a is_add is true) \a penalty to the diagonal terms
+ * of the Dirichlet DoFs of the CSR matrix.
+ */
+void FemModule::
+_applyPenaltyToCsrMatrix(RunQueue* queue, Real penalty, bool is_add)
+{
+  auto command = makeCommand(queue);
+
+  auto node_dof(m_dofs_on_nodes.nodeDoFConnectivityView());
+  auto in_row = ax::viewIn(command, m_csr_matrix.m_matrix_row);
+  auto in_rows_nb_column = ax::viewIn(command, m_csr_matrix.m_matrix_rows_nb_column);
+  auto in_column = ax::viewIn(command, m_csr_matrix.m_matrix_column);
+  auto in_out_value = ax::viewInOut(command, m_csr_matrix.m_matrix_value);
+  auto in_u1_fixed = ax::viewIn(command, m_u1_fixed);
+  auto in_u2_fixed = ax::viewIn(command, m_u2_fixed);
+
+  command << RUNCOMMAND_ENUMERATE(Node, node, ownNodes())
+  {
+    for (Int32 a = 0; a < 2; ++a) {
+      bool is_fixed = (a == 0) ? in_u1_fixed[node] : in_u2_fixed[node];
+      if (!is_fixed)
+        continue;
+      const Int32 row = node_dof.dofId(node, a).localId();
+      const Int32 begin = in_row(row);
+      Int32 index = _findColumnIndex(in_column, begin, begin + in_rows_nb_column(row), row);
+      if (index < 0)
+        continue;
+      if (is_add)
+        in_out_value(index) += penalty;
+      else
+        in_out_value(index) = penalty;
+    }
+  };
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*!
+ * \brief Set (or add if \a is_add is true) \a penalty to the diagonal terms
+ * of the Dirichlet DoFs of the BSR matrix.
+ */
+void FemModule::
+_applyPenaltyToBsrMatrix(RunQueue* queue, Real penalty, bool is_add)
+{
+  auto command = makeCommand(queue);
+
+  auto in_block_row = ax::viewIn(command, m_bsr_matrix.m_block_row);
+  auto in_block_column = ax::viewIn(command, m_bsr_matrix.m_block_column);
+  auto in_out_block_value = ax::viewInOut(command, m_bsr_matrix.m_block_value);
+  auto in_u1_fixed = ax::viewIn(command, m_u1_fixed);
+  auto in_u2_fixed = ax::viewIn(command, m_u2_fixed);
+
+  command << RUNCOMMAND_ENUMERATE(Node, node, ownNodes())
+  {
+    const Int32 row = node.localId();
+    const Int32 block_index = _findColumnIndex(in_block_column, in_block_row(row), in_block_row(row + 1), row);
+    if (block_index < 0)
+      return;
+    const Int32 index = block_index * 4;
+    for (Int32 a = 0; a < 2; ++a) {
+      bool is_fixed = (a == 0) ? in_u1_fixed[node] : in_u2_fixed[node];
+      if (!is_fixed)
+        continue;
+      if (is_add)
+        in_out_block_value(index + a * 3) += penalty;
+      else
+        in_out_block_value(index + a * 3) = penalty;
+    }
+  };
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*!
+ * \brief Check BsrFormat::multiply() against CsrFormat::multiply().
+ *
+ * The values of the BSR matrix are copied in the CSR matrix, which is not
+ * used by the BSR assembly, and the products of both matrices by the same
+ * vector are compared. The BSR vectors are indexed by node and the CSR
+ * vectors by DoF.
+ */
+void FemModule::
+_checkBsrMultiply(RunQueue* queue)
+{
+  auto node_dof(m_dofs_on_nodes.nodeDoFConnectivityView());
+  IItemFamily* dof_family = m_dofs_on_nodes.dofFamily();
+  const Int32 b = m_bsr_matrix.blockSize();
+  const Int32 nb_value = m_bsr_matrix.nbBlockRow() * b;
+
+  m_csr_matrix.computeSparsity(dof_family, mesh(), node_dof, b, *queue);
+  const Int32 nb_block_row = m_bsr_matrix.m_current_row + 1;
+  for (Int32 row = 0; row < nb_block_row; ++row) {
+    NodeLocalId row_node(row);
+    for (Int32 k = m_bsr_matrix.m_block_row(row), end = m_bsr_matrix.m_block_row(row + 1); k < end; ++k) {
+      NodeLocalId column_node(m_bsr_matrix.m_block_column(k));
+      for (Int32 i = 0; i < b; ++i)
+        for (Int32 j = 0; j < b; ++j)
+          m_csr_matrix.matrixSetValue(node_dof.dofId(row_node, i), node_dof.dofId(column_node, j),
+                                      m_bsr_matrix.m_block_value(k * b * b + i * b + j));
+    }
+  }
+
+  NumArray<Real, MDDim1> bsr_x(nb_value);
+  NumArray<Real, MDDim1> bsr_y(nb_value);
+  NumArray<Real, MDDim1> csr_x(dof_family->maxLocalId());
+  NumArray<Real, MDDim1> csr_y(dof_family->maxLocalId());
+  csr_x.fill(0.0);
+  ENUMERATE_ (Node, inode, allNodes()) {
+    Node node = *inode;
+    for (Int32 i = 0; i < b; ++i) {
+      const Real x = 1.0 + 0.1 * ((node.localId() * b + i) % 13);
+      bsr_x(node.localId() * b + i) = x;
+      csr_x(node_dof.dofId(node, i)) = x;
+    }
+  }
+
+  m_bsr_matrix.multiply(*queue, bsr_x.to1DSpan(), bsr_y.to1DSpan());
+  m_csr_matrix.multiply(*queue, csr_x.to1DSpan(), csr_y.to1DSpan());
+
+  Real max_y = 0.0;
+  Real max_diff = 0.0;
+  ENUMERATE_ (Node, inode, allNodes()) {
+    Node node = *inode;
+    for (Int32 i = 0; i < b; ++i) {
+      const Real y = csr_y(node_dof.dofId(node, i));
+      max_y = math::max(max_y, math::abs(y));
+      max_diff = math::max(max_diff, math::abs(y - bsr_y(node.localId() * b + i)));
+    }
+  }
+  info() << "CheckBsrMultiply max_y=" << max_y << " max_diff=" << max_diff;
+  if (max_diff > 1.0e-12 * max_y)
+    ARCANE_FATAL("BSR and CSR products are different max_diff={0} max_y={1}", max_diff, max_y);
+}
+
 /*---------------------------------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
 
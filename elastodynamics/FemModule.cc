@@ -23,6 +23,8 @@
 #include "FemUtils.h"
 #include "DoFLinearSystem.h"
 #include "FemDoFsOnNodes.h"
+#include "FemGeometryCache.h"
+#include "CentralDifferenceIntegrator.h"
 
 /*---------------------------------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
@@ -43,6 +45,8 @@ class FemModule
   explicit FemModule(const ModuleBuildInfo& mbi)
   : ArcaneFemObject(mbi)
   , m_dofs_on_nodes(mbi.subDomain()->traceMng())
+  , m_geometry(mbi.subDomain()->traceMng())
+  , m_explicit_integrator(mbi.subDomain()->traceMng())
   {
     ICaseMng* cm = mbi.subDomain()->caseMng();
     cm->setTreatWarningAsError(true);
@@ -103,6 +107,11 @@ class FemModule
 
   DoFLinearSystem m_linear_system;
   FemDoFsOnNodes m_dofs_on_nodes;
+  FemGeometryCache m_geometry;
+  CentralDifferenceIntegrator m_explicit_integrator;
+
+  // True if the time discretization is the explicit central difference scheme
+  bool m_is_explicit = false;
 
   // Struct to make sure we are using a CaseTable associated
   // to the right file
@@ -117,6 +126,9 @@ class FemModule
  private:
 
   void _doStationarySolve();
+  void _doExplicitStep();
+  void _initExplicitScheme();
+  void _assembleExplicitExternalForce(Real time);
   void _getParameters();
   void _updateVariables();
   void _updateTime();
@@ -124,11 +136,11 @@ class FemModule
   void _solve();
   void _assembleLinearOperator();
   FixedMatrix<6, 6> _computeElementMatrixTRIA3(Cell cell);
-  Real _computeAreaTriangle3(Cell cell);
-  Real _computeEdgeLength2(Face face);
   Real2 _computeDxDyOfRealTRIA3(Cell cell);
   void _applyDirichletBoundaryConditions();
   void _checkResultFile();
+  void _writeResultFile();
+  void _doLastTimeStepChecks(bool is_last_time_step);
   void _readCaseTables();
 };
 
@@ -141,11 +153,19 @@ compute()
   info() << "Module Fem COMPUTE";
 
   // Stop code after computations
-  if (t >= tmax)
+  const bool is_last_time_step = (t >= tmax);
+  if (is_last_time_step)
     subDomain()->timeLoopMng()->stopComputeLoop(true);
 
   info() << "Time iteration at t : " << t << " (s) ";
 
+  if (m_is_explicit) {
+    _doExplicitStep();
+    _updateTime();
+    _doLastTimeStepChecks(is_last_time_step);
+    return;
+  }
+
   m_linear_system.reset();
   m_linear_system.setLinearSystemFactory(options()->linearSystem());
   m_linear_system.initialize(subDomain(), m_dofs_on_nodes.dofFamily(), "Solver");
@@ -155,6 +175,8 @@ compute()
   _updateVariables();
 
   _updateTime();
+
+  _doLastTimeStepChecks(is_last_time_step);
 }
 
 /*---------------------------------------------------------------------------*/
@@ -167,6 +189,10 @@ startInit()
 
   m_dofs_on_nodes.initialize(mesh(), 2);
 
+  // The mesh does not move: the geometric factors are computed only once
+  m_geometry.computeCellGeometry(allCells(), m_node_coord, *acceleratorMng()->defaultQueue());
+  m_geometry.computeFaceGeometry(allFaces(), m_node_coord);
+
   _applyDirichletBoundaryConditions();
 
   // # get parameters
@@ -177,6 +203,9 @@ startInit()
   m_global_deltat.assign(dt);
 
   _readCaseTables();
+
+  if (m_is_explicit)
+    m_explicit_integrator.setFixedDoFs(m_u1_fixed, m_u2_fixed);
 }
 
 /*---------------------------------------------------------------------------*/
@@ -204,9 +233,81 @@ _doStationarySolve()
 
   // Solve for [u1,u2]
   _solve();
+}
 
-  // Check results TODO
-  // _checkResultFile();
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*!
+ * \brief Initialize the explicit central difference scheme.
+ *
+ * Compute the lumped mass and choose the time step from the CFL condition.
+ * The time step given in the dataset is used only if it is smaller.
+ */
+void FemModule::
+_initExplicitScheme()
+{
+  RunQueue* queue = acceleratorMng()->defaultQueue();
+  m_is_explicit = true;
+  m_explicit_integrator.initialize(mesh(), m_geometry, rho, lambda, mu, *queue);
+  dt = m_explicit_integrator.computeTimeStep(dt, options()->cfl(), m_node_coord, etak, *queue);
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*!
+ * \brief Do one step of the explicit central difference scheme.
+ *
+ * At the beginning of the step m_U, m_V and m_A are known at t-dt. No linear
+ * system is used: the acceleration is the ratio of the nodal forces and of
+ * the lumped mass.
+ */
+void FemModule::
+_doExplicitStep()
+{
+  RunQueue* queue = acceleratorMng()->defaultQueue();
+  auto compute_external_force = [&](Real time) { _assembleExplicitExternalForce(time); };
+  m_explicit_integrator.doStep(t, dt, m_U, m_V, m_A, m_dU, m_explicit_force, etam, etak,
+                               *queue, compute_external_force);
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*!
+ * \brief Compute the nodal external force at time \a time for the explicit scheme.
+ *
+ * The body force and the traction are lumped on the nodes.
+ */
+void FemModule::
+_assembleExplicitExternalForce(Real time)
+{
+  m_explicit_force.fill(Real3::zero());
+
+  m_explicit_integrator.addLumpedBodyForce(allCells(), Real3(f1, f2, 0.0), m_explicit_force);
+
+  // Index of the boundary condition. Needed to associate a CaseTable
+  Int32 boundary_condition_index = 0;
+  for (const auto& bs : options()->tractionBoundaryCondition()) {
+    FaceGroup group = bs->surface();
+    const CaseTableInfo& case_table_info = m_traction_case_table_list[boundary_condition_index];
+    ++boundary_condition_index;
+
+    Real3 trac = Real3::zero(); // traction in x, y and z
+    if (bs->tractionInputFile.isPresent()) {
+      CaseTable* inn = case_table_info.case_table;
+      if (!inn)
+        ARCANE_FATAL("CaseTable is null. Maybe there is a missing call to _readCaseTables()");
+      inn->value(time, trac);
+      trac.z = 0.0;
+    }
+    else {
+      if (bs->t1.isPresent())
+        trac.x = bs->t1();
+      if (bs->t2.isPresent())
+        trac.y = bs->t2();
+    }
+
+    m_explicit_integrator.addLumpedTraction(group, trac, m_explicit_force);
+  }
 }
 
 /*---------------------------------------------------------------------------*/
@@ -291,9 +392,17 @@ _getParameters()
 
     }
 
+  else if (options()->timeDiscretization == "Central-difference") {
+
+    info() << "Apply explicit time discretization via Central-difference ";
+
+    _initExplicitScheme();
+
+    }
+
   else {
 
-    ARCANE_FATAL("Only Newmark-beta | Generalized-alpha are supported for time-discretization ");
+    ARCANE_FATAL("Only Newmark-beta | Generalized-alpha | Central-difference are supported for time-discretization ");
 
     }
 }
@@ -645,7 +754,7 @@ _assembleLinearOperator()
   if ( options()->f1.isPresent()) {
     ENUMERATE_ (Cell, icell, allCells()) {
       Cell cell = *icell;
-      Real area = _computeAreaTriangle3(cell);
+      Real area = m_geometry.cellMeasure(cell);
       for (Node node : cell.nodes()) {
         if (!(m_u1_fixed[node]) && node.isOwn()) {
           DoFLocalId dof_id1 = node_dof.dofId(node, 0);
@@ -658,7 +767,7 @@ _assembleLinearOperator()
   if ( options()->f2.isPresent()) {
     ENUMERATE_ (Cell, icell, allCells()) {
       Cell cell = *icell;
-      Real area = _computeAreaTriangle3(cell);
+      Real area = m_geometry.cellMeasure(cell);
       for (Node node : cell.nodes()) {
         if (!(m_u2_fixed[node]) && node.isOwn()) {
           DoFLocalId dof_id2 = node_dof.dofId(node, 1);
@@ -670,11 +779,7 @@ _assembleLinearOperator()
 
   ENUMERATE_ (Cell, icell, allCells()) {
     Cell cell = *icell;
-    Real area = _computeAreaTriangle3(cell);
-
-    Real3 m0 = m_node_coord[cell.nodeId(0)];
-    Real3 m1 = m_node_coord[cell.nodeId(1)];
-    Real3 m2 = m_node_coord[cell.nodeId(2)];
+    Real area = m_geometry.cellMeasure(cell);
 
 /*
 
@@ -737,21 +842,21 @@ _assembleLinearOperator()
 
     // to construct dx(v) we use d(Phi0)/dx , d(Phi1)/dx , d(Phi1)/dx
     // here Phi_i are the basis functions at three nodes i=1:3
-    Real2 dPhi0(m1.y - m2.y, m2.x - m1.x);
-    Real2 dPhi1(m2.y - m0.y, m0.x - m2.x);
-    Real2 dPhi2(m0.y - m1.y, m1.x - m0.x);
+    Real3 dPhi0 = m_geometry.cellGradient(cell, 0);
+    Real3 dPhi1 = m_geometry.cellGradient(cell, 1);
+    Real3 dPhi2 = m_geometry.cellGradient(cell, 2);
 
     FixedMatrix<1, 3> DYV;
 
-    DYV(0,0) = dPhi0.y /(2.* area);
-    DYV(0,1) = dPhi1.y /(2.* area);
-    DYV(0,2) = dPhi2.y /(2.* area);
+    DYV(0,0) = dPhi0.y;
+    DYV(0,1) = dPhi1.y;
+    DYV(0,2) = dPhi2.y;
 
     FixedMatrix<1, 3> DXV;
 
-    DXV(0,0) = dPhi0.x /(2.* area);
-    DXV(0,1) = dPhi1.x /(2.* area);
-    DXV(0,2) = dPhi2.x /(2.* area);
+    DXV(0,0) = dPhi0.x;
+    DXV(0,1) = dPhi1.x;
+    DXV(0,2) = dPhi2.x;
 
 
     // to construct dx(u_n) we use d(Phi0)/dx , d(Phi1)/dx , d(Phi1)/dx
@@ -898,7 +1003,7 @@ $$
 
       ENUMERATE_ (Face, iface, group) {
         Face face = *iface;
-        Real length = _computeEdgeLength2(face);
+        Real length = m_geometry.faceMeasure(face);
         for (Node node : iface->nodes()) {
           if (!(m_u1_fixed[node]) && node.isOwn()) {
             DoFLocalId dof_id1 = node_dof.dofId(node, 0);
@@ -921,7 +1026,7 @@ $$
       if( bs->t1.isPresent() && bs->t2.isPresent()) {
         ENUMERATE_ (Face, iface, group) {
           Face face = *iface;
-          Real length = _computeEdgeLength2(face);
+          Real length = m_geometry.faceMeasure(face);
           for (Node node : iface->nodes()) {
             if (!(m_u1_fixed[node]) && node.isOwn()) {
               DoFLocalId dof_id1 = node_dof.dofId(node, 0);
@@ -939,7 +1044,7 @@ $$
       if( bs->t1.isPresent()) {
         ENUMERATE_ (Face, iface, group) {
           Face face = *iface;
-          Real length = _computeEdgeLength2(face);
+          Real length = m_geometry.faceMeasure(face);
           for (Node node : iface->nodes()) {
             if (!(m_u1_fixed[node]) && node.isOwn()) {
               DoFLocalId dof_id1 = node_dof.dofId(node, 0);
@@ -953,7 +1058,7 @@ $$
       if( bs->t2.isPresent()) {
         ENUMERATE_ (Face, iface, group) {
           Face face = *iface;
-          Real length = _computeEdgeLength2(face);
+          Real length = m_geometry.faceMeasure(face);
           for (Node node : iface->nodes()) {
             if (!(m_u2_fixed[node]) && node.isOwn()) {
               DoFLocalId dof_id2 = node_dof.dofId(node, 1);
@@ -989,29 +1094,6 @@ $$
 /*---------------------------------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
 
-Real FemModule::
-_computeAreaTriangle3(Cell cell)
-{
-  Real3 m0 = m_node_coord[cell.nodeId(0)];
-  Real3 m1 = m_node_coord[cell.nodeId(1)];
-  Real3 m2 = m_node_coord[cell.nodeId(2)];
-  return 0.5 * ((m1.x - m0.x) * (m2.y - m0.y) - (m2.x - m0.x) * (m1.y - m0.y));
-}
-
-/*---------------------------------------------------------------------------*/
-/*---------------------------------------------------------------------------*/
-
-Real FemModule::
-_computeEdgeLength2(Face face)
-{
-  Real3 m0 = m_node_coord[face.nodeId(0)];
-  Real3 m1 = m_node_coord[face.nodeId(1)];
-  return  math::sqrt((m1.x-m0.x)*(m1.x-m0.x) + (m1.y-m0.y)*(m1.y - m0.y));
-}
-
-/*---------------------------------------------------------------------------*/
-/*---------------------------------------------------------------------------*/
-
 FixedMatrix<6, 6> FemModule::
 _computeElementMatrixTRIA3(Cell cell)
 {
@@ -1023,15 +1105,12 @@ _computeElementMatrixTRIA3(Cell cell)
   //                 .     .
   //              1 o . . . o 2
   //------------------------------------------------
-  Real3 m0 = m_node_coord[cell.nodeId(0)];
-  Real3 m1 = m_node_coord[cell.nodeId(1)];
-  Real3 m2 = m_node_coord[cell.nodeId(2)];
-
-  Real area = _computeAreaTriangle3(cell);    // calculate area
+  Real area = m_geometry.cellMeasure(cell);    // area of the cell
 
-  Real2 dPhi0(m1.y - m2.y, m2.x - m1.x);
-  Real2 dPhi1(m2.y - m0.y, m0.x - m2.x);
-  Real2 dPhi2(m0.y - m1.y, m1.x - m0.x);
+  // dPhi_i = 2 * area * grad(Phi_i)
+  Real3 dPhi0 = m_geometry.cellGradient(cell, 0) * (2. * area);
+  Real3 dPhi1 = m_geometry.cellGradient(cell, 1) * (2. * area);
+  Real3 dPhi2 = m_geometry.cellGradient(cell, 2) * (2. * area);
 
   FixedMatrix<1, 6> b_matrix;
   FixedMatrix<6, 1> bT_matrix;
@@ -1416,10 +1495,7 @@ _solve()
   // Re-Apply boundary conditions because the solver has modified the value
   _applyDirichletBoundaryConditions();
 
-  m_dU.synchronize();
-  m_U.synchronize();
-  m_V.synchronize();
-  m_A.synchronize();
+  synchronizeVariables(m_dU, m_U, m_V, m_A);
 
   const bool do_print = (allNodes().size() < 200);
   if (do_print) {
@@ -1447,8 +1523,41 @@ _checkResultFile()
   if (filename.empty())
     return;
   const double epsilon = 1.0e-4;
-  // TODO
-  //Arcane::FemUtils::checkNodeResultFile(traceMng(), filename, m_U.x, epsilon);
+  Arcane::FemUtils::checkNodeResultFile(traceMng(), filename, m_U, epsilon);
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*!
+ * \brief Write the displacement in the file given by 'result-output-file'.
+ *
+ * The file can be used as the 'result-file' of another run, for example to
+ * compare the results of the explicit scheme in sequential and in parallel.
+ */
+void FemModule::
+_writeResultFile()
+{
+  String filename = options()->resultOutputFile();
+  if (filename.empty())
+    return;
+  Arcane::FemUtils::writeNodeResultFile(traceMng(), filename, m_U);
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*!
+ * \brief Write and check the displacement at the end of the last time step.
+ *
+ * For the implicit schemes m_U is updated from the solution of the linear
+ * system by _updateVariables().
+ */
+void FemModule::
+_doLastTimeStepChecks(bool is_last_time_step)
+{
+  if (!is_last_time_step)
+    return;
+  _writeResultFile();
+  _checkResultFile();
 }
 
 /*---------------------------------------------------------------------------*/
@@ -1,11 +1,11 @@
 ﻿// -*- tab-width: 2; indent-tabs-mode: nil; coding: utf-8-with-signature -*-
 //-----------------------------------------------------------------------------
-// Copyright 2000-2023 CEA (www.cea.fr) IFPEN (www.ifpenergiesnouvelles.com)
+// Copyright 2000-2024 CEA (www.cea.fr) IFPEN (www.ifpenergiesnouvelles.com)
 // See the top-level COPYRIGHT file for details.
 // SPDX-License-Identifier: Apache-2.0
 //-----------------------------------------------------------------------------
 /*---------------------------------------------------------------------------*/
-/* AlephDoFLinearSystem.cc                                     (C) 2022-2023 */
+/* AlephDoFLinearSystem.cc                                     (C) 2022-2024 */
 /*                                                                           */
 /* Linear system: Matrix A + Vector x + Vector b for Ax=b.                   */
 /*---------------------------------------------------------------------------*/
@@ -15,9 +15,12 @@
 
 #include <arcane/utils/FatalErrorException.h>
 #include <arcane/utils/NumArray.h>
+#include <arcane/utils/PlatformUtils.h>
 
 #include <arcane/VariableTypes.h>
 #include <arcane/IItemFamily.h>
+#include <arcane/IParallelMng.h>
+#include <arcane/Timer.h>
 
 #include <arcane/aleph/AlephTypesSolver.h>
 #include <arcane/aleph/Aleph.h>
@@ -38,7 +41,7 @@ enum class eSolverBackend
 
 #include "AlephDoFLinearSystemFactory_axl.h"
 
-#include <map>
+#include <algorithm>
 
 /*---------------------------------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
@@ -76,24 +79,94 @@ class AlephDoFLinearSystemImpl
     }
   };
 
-  struct RowColumnHash
+  /*!
+   * \brief List of values by Row/Column.
+   *
+   * Values are appended without any search. Before filling the matrix
+   * the list is sorted and values with the same Row/Column are merged.
+   * The list has to be sorted if we want to reuse the internal structure because
+   * the matrix filled has to be in the same order when we reuse it.
+   */
+  class RowColumnValueList
   {
-    size_t operator()(const RowColumn& s) const noexcept
+   public:
+
+    void add(RowColumn rc, Real value)
+    {
+      m_row_columns.add(rc);
+      m_values.add(value);
+      m_is_compacted = false;
+    }
+    void clear()
     {
-      std::size_t h1 = std::hash<Int32>{}(s.row_id);
-      std::size_t h2 = std::hash<Int32>{}(s.column_id);
+      m_row_columns.clear();
+      m_values.clear();
+      m_is_compacted = true;
+    }
+    Int32 size() const { return m_row_columns.size(); }
+    RowColumn rowColumn(Int32 i) const { return m_row_columns[i]; }
+    Real value(Int32 i) const { return m_values[i]; }
 
-      return h1 ^ (h2 << 1);
+    //! Index of \a rc in the list or (-1) if not found. The list has to be compacted.
+    Int32 indexOf(RowColumn rc) const
+    {
+      auto begin = m_row_columns.begin();
+      auto end = m_row_columns.end();
+      auto x = std::lower_bound(begin, end, rc);
+      if (x == end || !(*x == rc))
+        return (-1);
+      return static_cast<Int32>(x - begin);
     }
-  };
 
-  /*!
-   * \brief Map to store values by Row/Column.
-   *
-   * This map has to be sorted if we want to reuse the internal structure because
-   * the matrix filled has to be in the same order when we reuse it.
-   */
-  using RowColumnMap = std::map<RowColumn, Real>;
+    /*!
+     * \brief Sort the list by Row/Column and merge duplicated entries.
+     *
+     * If \a do_sum is true the values of duplicated entries are summed.
+     * Otherwise the last added value is kept.
+     */
+    void compact(bool do_sum)
+    {
+      if (m_is_compacted)
+        return;
+      const Int32 n = m_row_columns.size();
+      UniqueArray<Int32> permutation(n);
+      for (Int32 i = 0; i < n; ++i)
+        permutation[i] = i;
+      // Use a stable sort so that the order of the additions is kept
+      // for the same Row/Column and the result is deterministic.
+      std::stable_sort(permutation.begin(), permutation.end(),
+                       [&](Int32 a, Int32 b) { return m_row_columns[a] < m_row_columns[b]; });
+      UniqueArray<RowColumn> new_row_columns;
+      UniqueArray<Real> new_values;
+      new_row_columns.reserve(n);
+      new_values.reserve(n);
+      for (Int32 i = 0; i < n; ++i) {
+        Int32 index = permutation[i];
+        RowColumn rc = m_row_columns[index];
+        Real v = m_values[index];
+        Int32 last = new_row_columns.size() - 1;
+        if (last >= 0 && new_row_columns[last] == rc) {
+          if (do_sum)
+            new_values[last] += v;
+          else
+            new_values[last] = v;
+        }
+        else {
+          new_row_columns.add(rc);
+          new_values.add(v);
+        }
+      }
+      m_row_columns.swap(new_row_columns);
+      m_values.swap(new_values);
+      m_is_compacted = true;
+    }
+
+   private:
+
+    UniqueArray<RowColumn> m_row_columns;
+    UniqueArray<Real> m_values;
+    bool m_is_compacted = true;
+  };
 
  public:
 
@@ -129,9 +202,10 @@ class AlephDoFLinearSystemImpl
   void build()
   {
     _computeMatrixInfo();
+    _createMatrixAndVectors();
     m_aleph_params = _createAlephParam();
     m_dof_elimination_info.fill(ELIMINATE_NONE);
-    m_dof_elimination_info.fill(0.0);
+    m_dof_elimination_value.fill(0.0);
   }
 
   AlephParams* params() const { return m_aleph_params; }
@@ -152,6 +226,7 @@ class AlephDoFLinearSystemImpl
     // We need to compile Arcane with the needed library and link
     // the code with the associated aleph library (see CMakeLists.txt)
     // TODO: Linear algebra backend should be accessed from arc file.
+    Timer::Action ta(m_sub_domain->parallelMng()->timeStats(), "AlephComputeMatrixInfo");
     if (!m_aleph_kernel){
       info() << "Creating Aleph Kernel";
       // We can use less than the number of MPI ranks
@@ -159,10 +234,6 @@ class AlephDoFLinearSystemImpl
       Int32 nb_core = m_sub_domain->parallelMng()->commSize();
       m_aleph_kernel = new AlephKernel(m_sub_domain, solver_backend, nb_core);
     }
-    else{
-      //
-      m_need_destroy_matrix_and_vector = false;
-    }
 
     DoFGroup own_dofs = m_dof_family->allItems().own();
     //Int32 nb_node = own_nodes.size();
@@ -178,13 +249,30 @@ class AlephDoFLinearSystemImpl
     // Do not print informations about setting matrix if matrix is too big
     if (own_dofs.size()>200)
       m_do_print_filling = false;
+  }
 
+  /*!
+   * \brief Create the Aleph matrix and vectors.
+   *
+   * Aleph needs new matrix and vectors for each solve but the kernel and the
+   * indexing are kept. The solver structure is kept by Aleph when
+   * 'm_param_keep_solver_structure' is true but the preconditioner is
+   * built again for each solve because Aleph does not allow to reuse it.
+   */
+  void _createMatrixAndVectors()
+  {
+    if (m_has_matrix_and_vectors)
+      return;
+    if (m_aleph_matrix)
+      // Matrix and vectors of the previous steps are kept by the kernel.
+      m_need_destroy_matrix_and_vector = false;
     m_aleph_matrix = m_aleph_kernel->createSolverMatrix();
     m_aleph_rhs_vector = m_aleph_kernel->createSolverVector();
     m_aleph_solution_vector = m_aleph_kernel->createSolverVector();
     m_aleph_matrix->create();
     m_aleph_rhs_vector->create();
     m_aleph_solution_vector->create();
+    m_has_matrix_and_vectors = true;
   }
 
  public:
@@ -198,12 +286,7 @@ class AlephDoFLinearSystemImpl
     if (value == 0.0)
       return;
     if (m_use_value_map) {
-      RowColumn rc{ row.localId(), column.localId() };
-      auto x = m_values_map.find(rc);
-      if (x == m_values_map.end())
-        m_values_map.insert(std::make_pair(rc, value));
-      else
-        x->second += value;
+      m_values_map.add({ row.localId(), column.localId() }, value);
     }
     else {
       ItemInfoListView item_list_view(m_dof_family);
@@ -220,7 +303,7 @@ class AlephDoFLinearSystemImpl
       ARCANE_FATAL("Column is null");
     if (!m_use_value_map)
       ARCANE_FATAL("matrixSetValue() is only allowed if 'm_use_value_map' is true");
-    m_forced_set_values_map[{ row.localId(), column.localId() }] = value;
+    m_forced_set_values_map.add({ row.localId(), column.localId() }, value);
   }
 
   void eliminateRow(DoFLocalId row, Real value) override
@@ -248,21 +331,43 @@ class AlephDoFLinearSystemImpl
   void solve() override
   {
     UniqueArray<Real> aleph_result;
+    ITimeStats* tstat = m_sub_domain->parallelMng()->timeStats();
 
-    // _fillMatrix() may change the values of RHS vector
-    // with row or row-column elimination so we has to fill the RHS vector
-    // before the matrix.
-    _fillMatrix();
-    _fillRHSVector();
+    Real t0 = platform::getRealTime();
+    {
+      Timer::Action ta(tstat, "AlephCreateMatrix");
+      _createMatrixAndVectors();
+    }
 
-    info() << "[AlephFem] Assemble matrix ptr=" << m_aleph_matrix;
-    m_aleph_matrix->assemble();
-    m_aleph_rhs_vector->assemble();
+    Real t1 = platform::getRealTime();
+    {
+      Timer::Action ta(tstat, "AlephFillMatrix");
+      // _fillMatrix() may change the values of RHS vector
+      // with row or row-column elimination so we has to fill the RHS vector
+      // before the matrix.
+      _fillMatrix();
+      _fillRHSVector();
+
+      info() << "[AlephFem] Assemble matrix ptr=" << m_aleph_matrix;
+      m_aleph_matrix->assemble();
+      m_aleph_rhs_vector->assemble();
+    }
     auto* aleph_solution_vector = m_aleph_solution_vector;
     DoFGroup own_dofs = m_dof_family->allItems().own();
     const Int32 nb_dof = own_dofs.size();
+    // The first solve starts from zero. The next ones start from the solution
+    // of the previous solve (for time-dependent problems it is the solution
+    // of the previous time step).
     m_vector_zero.resize(nb_dof);
     m_vector_zero.fill(0.0);
+    if (m_nb_solve > 0) {
+      Int32 index = 0;
+      ENUMERATE_ (DoF, idof, own_dofs) {
+        m_vector_zero[index] = m_dof_variable[idof];
+        ++index;
+      }
+    }
+    m_aleph_params->setXoUser(m_nb_solve > 0);
 
     aleph_solution_vector->setLocalComponents(m_vector_zero);
     aleph_solution_vector->assemble();
@@ -271,14 +376,22 @@ class AlephDoFLinearSystemImpl
     Real residual_norm = 0.0;
     info() << "[AlephFem] BEGIN SOLVING WITH ALEPH solver_backend=" << (int)m_solver_backend;
 
-    m_aleph_matrix->solve(aleph_solution_vector,
-                          m_aleph_rhs_vector,
-                          nb_iteration,
-                          &residual_norm,
-                          m_aleph_params,
-                          false);
+    Real t2 = platform::getRealTime();
+    {
+      Timer::Action ta(tstat, "AlephSolve");
+      m_aleph_matrix->solve(aleph_solution_vector,
+                            m_aleph_rhs_vector,
+                            nb_iteration,
+                            &residual_norm,
+                            m_aleph_params,
+                            false);
+    }
+    Real t3 = platform::getRealTime();
     info() << "[AlephFem] END SOLVING WITH ALEPH r=" << residual_norm
            << " nb_iter=" << nb_iteration;
+    info() << "[AlephFem] Step=" << m_nb_solve << " time create=" << (t1 - t0)
+           << " fill=" << (t2 - t1) << " solve=" << (t3 - t2);
+    ++m_nb_solve;
     auto* rhs_vector = m_aleph_kernel->createSolverVector();
     auto* solution_vector = m_aleph_kernel->createSolverVector();
 
@@ -299,6 +412,9 @@ class AlephDoFLinearSystemImpl
 
       ++index;
     }
+
+    // Aleph needs new matrix and vectors for the next solve.
+    m_has_matrix_and_vectors = false;
   }
 
   VariableDoFReal& solutionVariable() override
@@ -320,22 +436,40 @@ class AlephDoFLinearSystemImpl
 #endif
   }
 
+  /*!
+   * \brief Clear the values of the matrix.
+   *
+   * The indexing of the DoFs and the Aleph kernel are kept. The matrix and
+   * vectors used by Aleph are created again in the next call to solve().
+   */
   void clearValues()
   {
     info() << "[Aleph] Clear values of current solver";
     m_dof_elimination_info.fill(ELIMINATE_NONE);
-    m_dof_elimination_info.fill(0.0);
+    m_dof_elimination_value.fill(0.0);
     m_values_map.clear();
     m_forced_set_values_map.clear();
-    _computeMatrixInfo();
+    m_csr_view = {};
+    m_has_csr_values = false;
+    m_has_matrix_and_vectors = false;
   }
 
+  /*!
+   * \brief Set the values of the matrix from a CSR matrix.
+   *
+   * The arrays referenced by \a csr_view have to remain valid until solve()
+   * is called. Forced values and eliminations are applied on the
+   * CSR values when filling the Aleph matrix.
+   */
   void setCSRValues(const CSRFormatView& csr_view) override
   {
-    ARCANE_THROW(NotImplementedException,"");
+    if (!m_use_value_map)
+      ARCANE_FATAL("setCSRValues() is only allowed if 'm_use_value_map' is true");
+    m_csr_view = csr_view;
+    m_has_csr_values = true;
   }
 
-  bool hasSetCSRValues() const { return false; }
+  bool hasSetCSRValues() const { return true; }
   void setRunner(Runner* r) override { m_runner = r; }
   Runner* runner() const { return m_runner; }
 
@@ -394,9 +528,9 @@ class AlephDoFLinearSystemImpl
   AlephParams* m_aleph_params = nullptr;
   eSolverBackend m_solver_backend = eSolverBackend::Hypre;
   //! List of (i,j) values added to the matrix
-  RowColumnMap m_values_map;
+  RowColumnValueList m_values_map;
   //! List of (i,j) whose value is fixed. This will override added values in m_values_map.
-  RowColumnMap m_forced_set_values_map;
+  RowColumnValueList m_forced_set_values_map;
   /*!
    * \brief True is we use 'm_values_map' to mix add and set.
    *
@@ -411,13 +545,25 @@ class AlephDoFLinearSystemImpl
   //! True is we need to manually destroy the matrix/vector
   bool m_need_destroy_matrix_and_vector = true;
 
+  //! True if matrix and vectors for the next solve are created
+  bool m_has_matrix_and_vectors = false;
+
+  //! Number of calls to solve()
+  Int32 m_nb_solve = 0;
+
+  //! Initial solution given to Aleph
   UniqueArray<Real> m_vector_zero;
 
+  //! Values of the matrix if setCSRValues() has been called
+  CSRFormatView m_csr_view;
+  bool m_has_csr_values = false;
+
   Runner* m_runner = nullptr;
 
  private:
 
   void _fillMatrix();
+  void _fillMatrixFromCSR(RowColumnValueList& row_column_elimination_list);
   void _fillRHSVector();
   void _setMatrixValue(DoF row, DoF column, Real value)
   {
@@ -480,12 +626,25 @@ _fillMatrix()
   if (!m_use_value_map)
     return;
 
-  RowColumnMap row_column_elimination_map;
+  m_values_map.compact(true);
+  m_forced_set_values_map.compact(false);
+
+  if (m_has_csr_values && m_values_map.size() != 0)
+    ARCANE_FATAL("Mixing setCSRValues() and matrixAddValue() is not supported");
+
+  // Values used for Row+Column elimination
+  RowColumnValueList row_column_elimination_list;
+
+  // Both lists are sorted so we can find the forced values
+  // by walking through them at the same time.
+  const Int32 nb_forced_value = m_forced_set_values_map.size();
+  Int32 forced_index = 0;
 
   DoFInfoListView item_list_view(m_dof_family);
-  for (const auto& rc_value : m_values_map) {
-    RowColumn rc = rc_value.first;
-    Real value = rc_value.second;
+  const Int32 nb_value = m_values_map.size();
+  for (Int32 i = 0; i < nb_value; ++i) {
+    RowColumn rc = m_values_map.rowColumn(i);
+    Real value = m_values_map.value(i);
     DoF dof_row = item_list_view[rc.row_id];
     DoF dof_column = item_list_view[rc.column_id];
 
@@ -493,7 +652,7 @@ _fillMatrix()
     Byte column_elimination_info = m_dof_elimination_info[dof_column];
 
     if (row_elimination_info == ELIMINATE_ROW_COLUMN || column_elimination_info == ELIMINATE_ROW_COLUMN) {
-      row_column_elimination_map[{ rc.row_id, rc.column_id }] = value;
+      row_column_elimination_list.add(rc, value);
       continue;
     }
 
@@ -502,22 +661,28 @@ _fillMatrix()
       continue;
 
     // Check if value is forced for current RowColumn
-    auto x = m_forced_set_values_map.find(rc);
-    if (x != m_forced_set_values_map.end()) {
+    while (forced_index < nb_forced_value && m_forced_set_values_map.rowColumn(forced_index) < rc)
+      ++forced_index;
+    if (forced_index < nb_forced_value && m_forced_set_values_map.rowColumn(forced_index) == rc) {
+      Real forced_value = m_forced_set_values_map.value(forced_index);
       info(4) << "FORCED VALUE R=" << rc.row_id << " C=" << rc.column_id
-              << " old=" << value << " new=" << x->second;
-      value = x->second;
+              << " old=" << value << " new=" << forced_value;
+      value = forced_value;
     }
 
     _setMatrixValue(dof_row, dof_column, value);
   }
 
+  if (m_has_csr_values)
+    _fillMatrixFromCSR(row_column_elimination_list);
+
   // Apply Row+Column elimination
   // Phase 1:
   // - substract values of the RHS vector if Row+Column elimination
-  for (const auto& rc_value : row_column_elimination_map) {
-    RowColumn rc = rc_value.first;
-    Real matrix_value = rc_value.second;
+  const Int32 nb_row_column_elimination = row_column_elimination_list.size();
+  for (Int32 index = 0; index < nb_row_column_elimination; ++index) {
+    RowColumn rc = row_column_elimination_list.rowColumn(index);
+    Real matrix_value = row_column_elimination_list.value(index);
     DoF dof_row = item_list_view[rc.row_id];
     DoF dof_column = item_list_view[rc.column_id];
     if (dof_row == dof_column)
@@ -557,6 +722,56 @@ _fillMatrix()
   }
 }
 
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*!
+ * \brief Fill the matrix with the values given by setCSRValues().
+ *
+ * Rows of the CSR matrix are the local ids of the DoFs. Eliminations and forced
+ * values are applied the same way as in _fillMatrix(). Values needed for
+ * Row+Column elimination are added to \a row_column_elimination_list.
+ */
+void AlephDoFLinearSystemImpl::
+_fillMatrixFromCSR(RowColumnValueList& row_column_elimination_list)
+{
+  Span<const Int32> rows = m_csr_view.rows();
+  Span<const Int32> rows_nb_column = m_csr_view.rowsNbColumn();
+  Span<const Int32> columns = m_csr_view.columns();
+  Span<const Real> values = m_csr_view.values();
+  const bool has_forced_values = m_forced_set_values_map.size() != 0;
+
+  DoFInfoListView item_list_view(m_dof_family);
+  const Int32 nb_row = rows_nb_column.size();
+  for (Int32 row_id = 0; row_id < nb_row; ++row_id) {
+    DoF dof_row = item_list_view[row_id];
+    Byte row_elimination_info = m_dof_elimination_info[dof_row];
+    if (row_elimination_info == ELIMINATE_ROW)
+      // Will be computed in _fillMatrix()
+      continue;
+    const Int32 row_begin = rows[row_id];
+    const Int32 row_end = row_begin + rows_nb_column[row_id];
+    for (Int32 j = row_begin; j < row_end; ++j) {
+      DoFLocalId column_lid(columns[j]);
+      Real value = values[j];
+      // Null columns are unused slots of the CSR structure.
+      if (column_lid.isNull() || value == 0.0)
+        continue;
+      DoF dof_column = item_list_view[column_lid];
+      RowColumn rc{ row_id, column_lid.localId() };
+      if (row_elimination_info == ELIMINATE_ROW_COLUMN || m_dof_elimination_info[dof_column] == ELIMINATE_ROW_COLUMN) {
+        row_column_elimination_list.add(rc, value);
+        continue;
+      }
+      if (has_forced_values) {
+        Int32 forced_index = m_forced_set_values_map.indexOf(rc);
+        if (forced_index >= 0)
+          value = m_forced_set_values_map.value(forced_index);
+      }
+      _setMatrixValue(dof_row, dof_column, value);
+    }
+  }
+}
+
 /*---------------------------------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
 
@@ -0,0 +1,278 @@
+﻿// -*- tab-width: 2; indent-tabs-mode: nil; coding: utf-8-with-signature -*-
+//-----------------------------------------------------------------------------
+// Copyright 2000-2024 CEA (www.cea.fr) IFPEN (www.ifpenergiesnouvelles.com)
+// See the top-level COPYRIGHT file for details.
+// SPDX-License-Identifier: Apache-2.0
+//-----------------------------------------------------------------------------
+/*---------------------------------------------------------------------------*/
+/* BsrFormatMatrix.cc                                          (C) 2022-2024 */
+/*                                                                           */
+/* Block CSR matrix for problems with several DoFs per node.                 */
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
+#include "BsrFormatMatrix.h"
+
+#include <arcane/IMesh.h>
+#include <arcane/ItemGroup.h>
+#include <arcane/core/UnstructuredMeshConnectivity.h>
+
+#include <arcane/accelerator/RunCommandLoop.h>
+#include <arcane/accelerator/RunCommandEnumerate.h>
+#include <arcane/accelerator/Scan.h>
+#include <arcane/accelerator/NumArrayViews.h>
+
+namespace Arcane::FemUtils
+{
+namespace ax = Arcane::Accelerator;
+
+namespace
+{
+  /*!
+   * \brief Block matrix-vector product for blocks of size N.
+   *
+   * The size is a template parameter so that the loops on the
+   * block entries are unrolled by the compiler.
+   */
+  template <int N> void
+  _multiplyBsr(RunQueue& queue, Int32 nb_block_row,
+               const NumArray<Int32, MDDim1>& block_row,
+               const NumArray<Int32, MDDim1>& block_column,
+               const NumArray<Real, MDDim1>& block_value,
+               Span<const Real> x, Span<Real> y)
+  {
+    auto command = makeCommand(queue);
+    auto in_block_row = ax::viewIn(command, block_row);
+    auto in_block_column = ax::viewIn(command, block_column);
+    auto in_block_value = ax::viewIn(command, block_value);
+    command << RUNCOMMAND_LOOP1(iter, nb_block_row)
+    {
+      auto [row] = iter();
+      Real sum[N] = {};
+      for (Int32 k = in_block_row(row), end = in_block_row(row + 1); k < end; ++k) {
+        const Int32 column = in_block_column(k);
+        const Int32 value_index = k * N * N;
+        for (Int32 i = 0; i < N; ++i)
+          for (Int32 j = 0; j < N; ++j)
+            sum[i] += in_block_value(value_index + i * N + j) * x[column * N + j];
+      }
+      for (Int32 i = 0; i < N; ++i)
+        y[row * N + i] = sum[i];
+    };
+  }
+} // namespace
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
+void BsrFormat::
+initialize(IItemFamily* dof_family, Int32 block_size, Int32 nb_block_row, Int32 nb_block_non_zero)
+{
+  info() << "Initialize BsrFormat: block_size=" << block_size << " nb_block_row=" << nb_block_row
+         << " nb_block_non_zero=" << nb_block_non_zero;
+  if (block_size < 1 || block_size > 3)
+    ARCANE_FATAL("Invalid block size '{0}'. Valid values are 1, 2 or 3", block_size);
+
+  m_block_size = block_size;
+  m_block_row.resize(nb_block_row + 1);
+  m_block_row.fill(0);
+  m_block_column.resize(nb_block_non_zero);
+  m_block_column.fill(-1);
+  m_block_value.resize(nb_block_non_zero * block_size * block_size);
+  m_block_value.fill(0.0);
+  m_dof_family = dof_family;
+  m_last_block = 0;
+  m_current_row = -1;
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
+void BsrFormat::
+computeSparsity(IMesh* mesh, RunQueue& queue)
+{
+  // A block (n1,n2) exists if the nodes n1 and n2 share a cell.
+  const Int32 nb_node = mesh->nodeFamily()->maxLocalId();
+  if (nb_node != nbBlockRow())
+    ARCANE_FATAL("Bad number of block rows '{0}' (expected '{1}')", nbBlockRow(), nb_node);
+
+  UnstructuredMeshConnectivityView connectivity_view;
+  connectivity_view.setMesh(mesh);
+  auto nc = connectivity_view.nodeCell();
+  auto cnc = connectivity_view.cellNode();
+
+  // Number of blocks of each row.
+  NumArray<Int32, MDDim1> rows_nb_block(nb_node);
+  rows_nb_block.fill(0);
+  {
+    auto command = makeCommand(queue);
+    auto out_rows_nb_block = ax::viewOut(command, rows_nb_block);
+    command << RUNCOMMAND_ENUMERATE(Node, node, mesh->allNodes())
+    {
+      Int32 nb_block = 0;
+      for (Int32 c = 0, nb_cell = nc.nbCell(node); c < nb_cell; ++c) {
+        CellLocalId cell = nc.cellId(node, c);
+        for (Int32 n = 0, nb_cell_node = cnc.nbNode(cell); n < nb_cell_node; ++n)
+          if (isFirstNodeNeighbour(node, c, n, nc, cnc))
+            ++nb_block;
+      }
+      out_rows_nb_block(node.localId()) = nb_block;
+    };
+  }
+
+  // Beginning of each row.
+  NumArray<Int32, MDDim1> rows_begin(nb_node);
+  ax::Scanner<Int32> scanner;
+  scanner.exclusiveSum(&queue, rows_nb_block, rows_begin);
+  m_last_block = (nb_node == 0) ? 0 : (rows_begin(nb_node - 1) + rows_nb_block(nb_node - 1));
+  m_current_row = nb_node - 1;
+  {
+    auto command = makeCommand(queue);
+    auto in_rows_begin = ax::viewIn(command, rows_begin);
+    auto out_block_row = ax::viewOut(command, m_block_row);
+    command << RUNCOMMAND_LOOP1(iter, nb_node)
+    {
+      auto [row] = iter();
+      out_block_row(row) = in_rows_begin(row);
+    };
+  }
+  m_block_row(nb_node) = m_last_block;
+
+  // Columns of each row.
+  m_block_column.resize(m_last_block);
+  m_block_value.resize(m_last_block * m_block_size * m_block_size);
+  m_block_value.fill(0.0);
+  {
+    auto command = makeCommand(queue);
+    auto in_block_row = ax::viewIn(command, m_block_row);
+    auto out_block_column = ax::viewInOut(command, m_block_column);
+    command << RUNCOMMAND_ENUMERATE(Node, node, mesh->allNodes())
+    {
+      const Int32 begin = in_block_row(node.localId());
+      Int32 end = begin;
+      for (Int32 c = 0, nb_cell = nc.nbCell(node); c < nb_cell; ++c) {
+        CellLocalId cell = nc.cellId(node, c);
+        for (Int32 n = 0, nb_cell_node = cnc.nbNode(cell); n < nb_cell_node; ++n) {
+          if (!isFirstNodeNeighbour(node, c, n, nc, cnc))
+            continue;
+          Int32 column = cnc.nodeId(cell, n).localId();
+          // Insertion sort of the columns of the row
+          Int32 k = end;
+          for (; k > begin && out_block_column(k - 1) > column; --k)
+            out_block_column(k) = out_block_column(k - 1);
+          out_block_column(k) = column;
+          ++end;
+        }
+      }
+    };
+  }
+  info() << "BsrFormat sparsity nb_block_row=" << nb_node << " nb_block_non_zero=" << m_last_block;
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
+void BsrFormat::
+multiply(RunQueue& queue, Span<const Real> x, Span<Real> y)
+{
+  // Rows after the last one given to setCoordinates() have no block.
+  const Int32 nb_block_row = m_current_row + 1;
+  if (nb_block_row < nbBlockRow())
+    y.subspan(nb_block_row * m_block_size, (nbBlockRow() - nb_block_row) * m_block_size).fill(0.0);
+  switch (m_block_size) {
+  case 1:
+    _multiplyBsr<1>(queue, nb_block_row, m_block_row, m_block_column, m_block_value, x, y);
+    break;
+  case 2:
+    _multiplyBsr<2>(queue, nb_block_row, m_block_row, m_block_column, m_block_value, x, y);
+    break;
+  case 3:
+    _multiplyBsr<3>(queue, nb_block_row, m_block_row, m_block_column, m_block_value, x, y);
+    break;
+  default:
+    ARCANE_FATAL("Invalid block size '{0}'", m_block_size);
+  }
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
+CSRFormatView BsrFormat::
+toCSRFormatView(IndexedNodeDoFConnectivityView node_dof)
+{
+  const Int32 b = m_block_size;
+  const Int32 nb_block_row = m_current_row + 1;
+  const Int32 nb_dof = m_dof_family->maxLocalId();
+  const Int32 nb_value = m_last_block * b * b;
+
+  m_csr_row.resize(nb_dof);
+  m_csr_row.fill(0);
+  m_csr_rows_nb_column.resize(nb_dof);
+  m_csr_rows_nb_column.fill(0);
+  m_csr_column.resize(nb_value);
+  m_csr_value.resize(nb_value);
+
+  // Each scalar row of a block row has b * (number of blocks) values.
+  // The scalar rows are stored in the order of the nodes. This is the order
+  // of the DoFs only if the DoFs of a node are created node by node, as
+  // FemDoFsOnNodes does, so check it.
+  Int32 index = 0;
+  for (Int32 row = 0; row < nb_block_row; ++row) {
+    const Int32 begin = m_block_row(row);
+    const Int32 end = m_block_row(row + 1);
+    const Int32 nb_block = end - begin;
+    if (nb_block == 0)
+      continue;
+    NodeLocalId node(row);
+    for (Int32 i = 0; i < b; ++i) {
+      DoFLocalId dof_row = node_dof.dofId(node, i);
+      if (dof_row.localId() != row * b + i)
+        ARCANE_FATAL("DoF '{0}' of node '{1}' has local id '{2}' (expected '{3}'). DoFs have to be created with FemDoFsOnNodes",
+                     i, row, dof_row.localId(), row * b + i);
+      m_csr_row(dof_row) = index;
+      m_csr_rows_nb_column(dof_row) = nb_block * b;
+      for (Int32 k = begin; k < end; ++k) {
+        NodeLocalId column_node(m_block_column(k));
+        for (Int32 j = 0; j < b; ++j) {
+          m_csr_column(index) = node_dof.dofId(column_node, j);
+          m_csr_value(index) = m_block_value(k * b * b + i * b + j);
+          ++index;
+        }
+      }
+    }
+  }
+
+  return { m_csr_row.to1DSpan(), m_csr_rows_nb_column.to1DSpan(),
+           m_csr_column.to1DSpan(), m_csr_value.to1DSpan() };
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
+void BsrFormat::
+translateToLinearSystem(DoFLinearSystem& linear_system, IndexedNodeDoFConnectivityView node_dof)
+{
+  info() << "TranslateToLinearSystem BSR this=" << this;
+  CSRFormatView csr_view = toCSRFormatView(node_dof);
+  if (linear_system.hasSetCSRValues()) {
+    linear_system.setCSRValues(csr_view);
+    return;
+  }
+
+  Span<const Int32> rows = csr_view.rows();
+  Span<const Int32> rows_nb_column = csr_view.rowsNbColumn();
+  Span<const Int32> columns = csr_view.columns();
+  Span<const Real> values = csr_view.values();
+  for (Int32 row = 0, nb_row = rows_nb_column.size(); row < nb_row; ++row) {
+    for (Int32 j = rows[row], end = rows[row] + rows_nb_column[row]; j < end; ++j)
+      linear_system.matrixAddValue(DoFLocalId(row), DoFLocalId(columns[j]), values[j]);
+  }
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
+} // namespace Arcane::FemUtils
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
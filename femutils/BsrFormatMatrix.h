@@ -0,0 +1,220 @@
+﻿// -*- tab-width: 2; indent-tabs-mode: nil; coding: utf-8-with-signature -*-
+//-----------------------------------------------------------------------------
+// Copyright 2000-2024 CEA (www.cea.fr) IFPEN (www.ifpenergiesnouvelles.com)
+// See the top-level COPYRIGHT file for details.
+// SPDX-License-Identifier: Apache-2.0
+//-----------------------------------------------------------------------------
+/*---------------------------------------------------------------------------*/
+/* BsrFormatMatrix.h                                           (C) 2022-2024 */
+/*                                                                           */
+/* Block CSR matrix for problems with several DoFs per node.                 */
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+#ifndef ARCANEFEM_FEMUTILS_BSRFORMATMATRIX_H
+#define ARCANEFEM_FEMUTILS_BSRFORMATMATRIX_H
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
+#include <arcane/utils/FatalErrorException.h>
+#include <arcane/utils/NumArray.h>
+#include <arcane/utils/TraceAccessor.h>
+
+#include <arcane/VariableTypes.h>
+#include <arcane/IItemFamily.h>
+#include <arcane/ISubDomain.h>
+#include <arcane/IndexedItemConnectivityView.h>
+
+#include <arcane/accelerator/core/RunQueue.h>
+
+#include "FemUtils.h"
+#include "DoFLinearSystem.h"
+
+namespace Arcane::FemUtils
+{
+using namespace Arcane;
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*!
+ * \brief Block CSR matrix.
+ *
+ * A block row corresponds to a node and each non-zero entry is a dense
+ * block of size blockSize()xblockSize() coupling all the DoFs of two nodes.
+ * Only one column index is stored per block.
+ *
+ * The values of a block are stored row by row. The block \a k of the matrix
+ * starts at m_block_value(k * blockSize() * blockSize()).
+ *
+ * Usage:
+ * \code
+ * BsrFormat bsr(subDomain());
+ * bsr.initialize(dof_family, 2, nb_node, nb_block_non_zero);
+ * bsr.computeSparsity(mesh, queue); // or call setCoordinates() for each block
+ * ...
+ * bsr.matrixAddBlock(node1, node2, K_block);
+ * bsr.translateToLinearSystem(linear_system, node_dof);
+ * \endcode
+ */
+class BsrFormat
+: public TraceAccessor
+{
+ public:
+
+  explicit BsrFormat(ISubDomain* sd)
+  : TraceAccessor(sd->traceMng())
+  {
+  }
+
+ public:
+
+  /*!
+   * \brief Initialize the matrix.
+   *
+   * \a block_size is the number of DoFs per node (2 or 3), \a nb_block_row is the
+   * number of nodes and \a nb_block_non_zero the number of non-zero blocks.
+   */
+  void initialize(IItemFamily* dof_family, Int32 block_size, Int32 nb_block_row, Int32 nb_block_non_zero);
+
+  /*!
+   * \brief Compute the structure of the matrix from the node-cell connectivity of \a mesh.
+   *
+   * The structure is computed on \a queue like CsrFormat::computeSparsity():
+   * the number of blocks of each row, an exclusive scan to get the beginning
+   * of the rows and the filling of the columns. Columns of a row are sorted.
+   */
+  void computeSparsity(IMesh* mesh, RunQueue& queue);
+
+  /*!
+   * \brief Add the block (row,column) in the structure of the matrix.
+   *
+   * Blocks have to be added row by row.
+   */
+  void setCoordinates(NodeLocalId row, NodeLocalId column)
+  {
+    Int32 row_lid = row.localId();
+    if (row_lid < m_current_row)
+      ARCANE_FATAL("Blocks have to be added row by row (row={0} current={1})", row_lid, m_current_row);
+    // Rows between the current one and 'row' have no block.
+    while (m_current_row < row_lid) {
+      ++m_current_row;
+      m_block_row(m_current_row + 1) = m_last_block;
+    }
+    m_block_column(m_last_block) = column.localId();
+    ++m_last_block;
+    m_block_row(row_lid + 1) = m_last_block;
+  }
+
+  //! Index of the block (\a row,\a column) or (-1) if not found.
+  Int32 blockIndex(NodeLocalId row, NodeLocalId column) const
+  {
+    Int32 begin = m_block_row(row.localId());
+    Int32 end = (row.localId() <= m_current_row) ? m_block_row(row.localId() + 1) : begin;
+    for (Int32 i = begin; i < end; ++i)
+      if (m_block_column(i) == column.localId())
+        return i;
+    return (-1);
+  }
+
+  //! Add \a value to the entry (\a i,\a j) of the block (\a row,\a column).
+  void matrixAddValue(NodeLocalId row, NodeLocalId column, Int32 i, Int32 j, Real value)
+  {
+    m_block_value(_valueIndex(row, column) + i * m_block_size + j) += value;
+  }
+
+  //! Set the entry (\a i,\a j) of the block (\a row,\a column) to \a value.
+  void matrixSetValue(NodeLocalId row, NodeLocalId column, Int32 i, Int32 j, Real value)
+  {
+    m_block_value(_valueIndex(row, column) + i * m_block_size + j) = value;
+  }
+
+  //! Add the values of \a block to the block (\a row,\a column).
+  template <int N>
+  void matrixAddBlock(NodeLocalId row, NodeLocalId column, const FixedMatrix<N, N>& block)
+  {
+    if (N != m_block_size)
+      ARCANE_FATAL("Bad block size '{0}' (expected '{1}')", N, m_block_size);
+    Int32 index = _valueIndex(row, column);
+    for (Int32 i = 0; i < N; ++i)
+      for (Int32 j = 0; j < N; ++j)
+        m_block_value(index + i * N + j) += block(i, j);
+  }
+
+  /*!
+   * \brief Compute y = A.x.
+   *
+   * \a x and \a y are stored by node: the value of the DoF \a i of the
+   * node \a n is at index n * blockSize() + i.
+   */
+  void multiply(RunQueue& queue, Span<const Real> x, Span<Real> y);
+
+  /*!
+   * \brief Convert the matrix to a scalar CSR matrix indexed by DoFs.
+   *
+   * \a node_dof gives the DoFs of each node. The CSR arrays are stored in
+   * this instance and the returned view is valid until the next call.
+   *
+   * The scalar rows are stored in the order of the nodes and the values of
+   * a row in the order of the column nodes. This is the order of the DoFs
+   * only because FemDoFsOnNodes creates the DoFs node by node (the DoF \a i
+   * of the node \a n has the local id n * blockSize() + i). Some backends
+   * need it: for example HYPRE_IJMatrixSetValues() needs the values of each
+   * row contiguous and in the order of the DoFs. This numbering is checked.
+   */
+  CSRFormatView toCSRFormatView(IndexedNodeDoFConnectivityView node_dof);
+
+  /*!
+   * \brief Fill \a linear_system with the values of the matrix.
+   *
+   * Use setCSRValues() if the linear system supports it and
+   * matrixAddValue() otherwise.
+   */
+  void translateToLinearSystem(DoFLinearSystem& linear_system, IndexedNodeDoFConnectivityView node_dof);
+
+  Int32 blockSize() const { return m_block_size; }
+  Int32 nbBlockRow() const { return m_block_row.extent0() - 1; }
+  Int32 nbBlockNonZero() const { return m_last_block; }
+
+  //! Set all the values to zero. The structure is kept.
+  void clearValues() { m_block_value.fill(0.0); }
+
+ public:
+
+  Int32 m_block_size = 0;
+  Int32 m_last_block = 0;
+  Int32 m_current_row = -1;
+  //! Index of the first block of each row. The size is nbBlockRow()+1.
+  NumArray<Int32, MDDim1> m_block_row;
+  //! Node local id of the column of each block
+  NumArray<Int32, MDDim1> m_block_column;
+  //! Values of the blocks
+  NumArray<Real, MDDim1> m_block_value;
+  IItemFamily* m_dof_family = nullptr;
+
+ private:
+
+  // Scalar CSR matrix used by toCSRFormatView()
+  NumArray<Int32, MDDim1> m_csr_row;
+  NumArray<Int32, MDDim1> m_csr_rows_nb_column;
+  NumArray<Int32, MDDim1> m_csr_column;
+  NumArray<Real, MDDim1> m_csr_value;
+
+ private:
+
+  Int32 _valueIndex(NodeLocalId row, NodeLocalId column) const
+  {
+    Int32 index = blockIndex(row, column);
+    if (index < 0)
+      ARCANE_FATAL("Block ({0},{1}) is not in the structure of the matrix", row.localId(), column.localId());
+    return index * m_block_size * m_block_size;
+  }
+};
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
+} // namespace Arcane::FemUtils
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
+#endif
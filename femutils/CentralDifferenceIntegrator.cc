@@ -0,0 +1,323 @@
+﻿// -*- tab-width: 2; indent-tabs-mode: nil; coding: utf-8-with-signature -*-
+//-----------------------------------------------------------------------------
+// Copyright 2000-2024 CEA (www.cea.fr) IFPEN (www.ifpenergiesnouvelles.com)
+// See the top-level COPYRIGHT file for details.
+// SPDX-License-Identifier: Apache-2.0
+//-----------------------------------------------------------------------------
+/*---------------------------------------------------------------------------*/
+/* CentralDifferenceIntegrator.cc                              (C) 2022-2024 */
+/*                                                                           */
+/* Explicit central difference time integrator for linear elastodynamics.    */
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
+#include "CentralDifferenceIntegrator.h"
+
+#include <arcane/utils/FatalErrorException.h>
+#include <arcane/utils/MathUtils.h>
+
+#include <arcane/IMesh.h>
+#include <arcane/IItemFamily.h>
+#include <arcane/IParallelMng.h>
+#include <arcane/core/UnstructuredMeshConnectivity.h>
+
+#include <arcane/accelerator/RunCommandEnumerate.h>
+#include <arcane/accelerator/NumArrayViews.h>
+#include <arcane/accelerator/VariableViews.h>
+#include <arcane/accelerator/Reduce.h>
+
+namespace Arcane::FemUtils
+{
+namespace ax = Arcane::Accelerator;
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
+void CentralDifferenceIntegrator::
+initialize(IMesh* mesh, const FemGeometryCache& geometry, Real rho,
+           Real lambda, Real mu, RunQueue& queue)
+{
+  if (mesh->dimension() != 2)
+    ARCANE_FATAL("The central difference integrator only supports 2D meshes");
+  if (!geometry.hasCellGeometry())
+    ARCANE_FATAL("The cell geometry has to be computed before initializing the integrator");
+  if (rho <= 0.0)
+    ARCANE_FATAL("The density has to be positive for an explicit scheme (rho={0})", rho);
+
+  m_mesh = mesh;
+  m_geometry = &geometry;
+  m_rho = rho;
+  m_lambda = lambda;
+  m_mu = mu;
+
+  const Int32 nb_node = mesh->nodeFamily()->maxLocalId();
+  m_lumped_mass.resize(nb_node);
+  m_fixed_mask.resize(nb_node);
+  m_fixed_mask.fill(0);
+
+  UnstructuredMeshConnectivityView connectivity_view;
+  connectivity_view.setMesh(mesh);
+  auto nc = connectivity_view.nodeCell();
+
+  auto command = makeCommand(queue);
+  auto in_measure = ax::viewIn(command, geometry.m_cell_measure);
+  auto out_mass = ax::viewOut(command, m_lumped_mass);
+
+  // Row-sum of the P1 mass matrix: each node gets a third of the mass of its cells
+  command << RUNCOMMAND_ENUMERATE(Node, node, mesh->allNodes())
+  {
+    Real mass = 0.0;
+    for (CellLocalId cell : nc.cells(node))
+      mass += math::abs(in_measure(cell.localId()));
+    out_mass(node.localId()) = rho * mass / 3.0;
+  };
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
+void CentralDifferenceIntegrator::
+setFixedDoFs(const VariableNodeBool& u1_fixed, const VariableNodeBool& u2_fixed)
+{
+  ENUMERATE_ (Node, inode, m_mesh->allNodes()) {
+    Int32 mask = 0;
+    if (u1_fixed[inode])
+      mask |= 1;
+    if (u2_fixed[inode])
+      mask |= 2;
+    m_fixed_mask(inode.localId()) = mask;
+  }
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
+Real CentralDifferenceIntegrator::
+computeStableTimeStep(const VariableNodeReal3& node_coord, Real etak, RunQueue& queue)
+{
+  const Real cp = math::sqrt((m_lambda + 2.0 * m_mu) / m_rho);
+
+  UnstructuredMeshConnectivityView connectivity_view;
+  connectivity_view.setMesh(m_mesh);
+  auto cnc = connectivity_view.cellNode();
+
+  auto command = makeCommand(queue);
+  ax::ReducerMin<Real> reducer(command);
+  auto in_node_coord = ax::viewIn(command, node_coord);
+  auto in_measure = ax::viewIn(command, m_geometry->m_cell_measure);
+
+  command << RUNCOMMAND_ENUMERATE(Cell, cell, m_mesh->allCells())
+  {
+    Real3 m0 = in_node_coord[cnc.nodeId(cell, 0)];
+    Real3 m1 = in_node_coord[cnc.nodeId(cell, 1)];
+    Real3 m2 = in_node_coord[cnc.nodeId(cell, 2)];
+    Real max_edge = math::max((m1 - m0).normL2(), math::max((m2 - m1).normL2(), (m0 - m2).normL2()));
+    // Smallest height of the triangle
+    Real h = 2.0 * math::abs(in_measure(cell.localId())) / max_edge;
+    reducer.min(h / cp);
+  };
+
+  Real local_dt = reducer.reduce();
+  Real stable_dt = m_mesh->parallelMng()->reduce(Parallel::ReduceMin, local_dt);
+  // The stiffness proportional damping reduces the stable time step:
+  // dt = 2/w (sqrt(1 + xi^2) - xi) with w = 2/dt and xi = etak.w/2
+  if (etak > 0.0)
+    stable_dt = math::sqrt(stable_dt * stable_dt + etak * etak) - etak;
+  info() << "CentralDifferenceIntegrator: cp=" << cp << " stable time step=" << stable_dt;
+  return stable_dt;
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
+Real CentralDifferenceIntegrator::
+computeTimeStep(Real dt, Real cfl, const VariableNodeReal3& node_coord, Real etak, RunQueue& queue)
+{
+  Real stable_dt = cfl * computeStableTimeStep(node_coord, etak, queue);
+  if (dt <= 0.0 || dt > stable_dt) {
+    if (dt > 0.0)
+      pwarning() << "The time step dt=" << dt << " is above the stable time step of the explicit scheme."
+                 << " Using dt=" << stable_dt;
+    dt = stable_dt;
+  }
+  info() << "Time step of the explicit scheme dt=" << dt;
+  return dt;
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
+void CentralDifferenceIntegrator::
+predict(Real dt, VariableNodeReal3& u, VariableNodeReal3& v,
+        const VariableNodeReal3& a, const VariableNodeReal3& prescribed_u,
+        RunQueue& queue)
+{
+  auto command = makeCommand(queue);
+  auto inout_u = ax::viewInOut(command, u);
+  auto inout_v = ax::viewInOut(command, v);
+  auto in_a = ax::viewIn(command, a);
+  auto in_prescribed_u = ax::viewIn(command, prescribed_u);
+  auto in_fixed_mask = ax::viewIn(command, m_fixed_mask);
+
+  // The update is pointwise so it is done on all the nodes to avoid a synchronization
+  command << RUNCOMMAND_ENUMERATE(Node, node, m_mesh->allNodes())
+  {
+    Real3 old_u = inout_u[node];
+    Real3 old_v = inout_v[node];
+    Real3 a_node = in_a[node];
+    Real3 v_half = old_v + (0.5 * dt) * a_node;
+    Real3 new_u = old_u + dt * v_half;
+    Int32 mask = in_fixed_mask(node.localId());
+    if (mask & 1) {
+      new_u.x = in_prescribed_u[node].x;
+      v_half.x = 0.0;
+    }
+    if (mask & 2) {
+      new_u.y = in_prescribed_u[node].y;
+      v_half.y = 0.0;
+    }
+    inout_u[node] = new_u;
+    inout_v[node] = v_half;
+  };
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*!
+ * Each own node gathers the internal force of its cells. For a P1 triangle
+ * the strain is constant in the cell and the contribution to the node i is
+ * area * sigma . grad(phi_i). The strain of a cell is computed again for
+ * each of its nodes, which avoids atomic operations.
+ */
+void CentralDifferenceIntegrator::
+computeAcceleration(const VariableNodeReal3& u, const VariableNodeReal3& v,
+                    const VariableNodeReal3& external_force, Real etam, Real etak,
+                    VariableNodeReal3& a, RunQueue& queue)
+{
+  const Real lambda = m_lambda;
+  const Real lambda_2mu = m_lambda + 2.0 * m_mu;
+  const Real mu = m_mu;
+
+  UnstructuredMeshConnectivityView connectivity_view;
+  connectivity_view.setMesh(m_mesh);
+  auto cnc = connectivity_view.cellNode();
+  auto nc = connectivity_view.nodeCell();
+
+  {
+    auto command = makeCommand(queue);
+    auto in_u = ax::viewIn(command, u);
+    auto in_v = ax::viewIn(command, v);
+    auto in_external_force = ax::viewIn(command, external_force);
+    auto in_measure = ax::viewIn(command, m_geometry->m_cell_measure);
+    auto in_gradient_x = ax::viewIn(command, m_geometry->m_cell_gradient_x);
+    auto in_gradient_y = ax::viewIn(command, m_geometry->m_cell_gradient_y);
+    auto in_mass = ax::viewIn(command, m_lumped_mass);
+    auto in_fixed_mask = ax::viewIn(command, m_fixed_mask);
+    auto out_a = ax::viewOut(command, a);
+
+    command << RUNCOMMAND_ENUMERATE(Node, node, m_mesh->ownNodes())
+    {
+      Real3 force = in_external_force[node];
+      for (CellLocalId cell : nc.cells(node)) {
+        Int32 lid = cell.localId();
+        Real eps_xx = 0.0;
+        Real eps_yy = 0.0;
+        Real gamma_xy = 0.0;
+        Int32 node_index = 0;
+        for (Int32 k = 0; k < 3; ++k) {
+          NodeLocalId node_k = cnc.nodeId(cell, k);
+          if (node_k == node)
+            node_index = k;
+          // Stiffness proportional damping acts on u + etak * v
+          Real3 u_k = in_u[node_k];
+          Real3 v_k = in_v[node_k];
+          Real3 w = u_k + etak * v_k;
+          Real gx = in_gradient_x(lid, k);
+          Real gy = in_gradient_y(lid, k);
+          eps_xx += w.x * gx;
+          eps_yy += w.y * gy;
+          gamma_xy += w.x * gy + w.y * gx;
+        }
+        Real sigma_xx = lambda_2mu * eps_xx + lambda * eps_yy;
+        Real sigma_yy = lambda * eps_xx + lambda_2mu * eps_yy;
+        Real sigma_xy = mu * gamma_xy;
+        Real area = math::abs(in_measure(lid));
+        Real gx = in_gradient_x(lid, node_index);
+        Real gy = in_gradient_y(lid, node_index);
+        force.x -= area * (sigma_xx * gx + sigma_xy * gy);
+        force.y -= area * (sigma_xy * gx + sigma_yy * gy);
+      }
+      Real3 v_node = in_v[node];
+      Real3 acc = force / in_mass(node.localId()) - etam * v_node;
+      Int32 mask = in_fixed_mask(node.localId());
+      if (mask & 1)
+        acc.x = 0.0;
+      if (mask & 2)
+        acc.y = 0.0;
+      out_a[node] = acc;
+    };
+  }
+
+  a.synchronize();
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
+void CentralDifferenceIntegrator::
+addLumpedBodyForce(const CellGroup& cells, Real3 body_force, VariableNodeReal3& force) const
+{
+  ENUMERATE_ (Cell, icell, cells) {
+    Cell cell = *icell;
+    Real area = math::abs(m_geometry->cellMeasure(cell));
+    for (Node node : cell.nodes())
+      force[node] += body_force * area / 3.;
+  }
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
+void CentralDifferenceIntegrator::
+addLumpedTraction(const FaceGroup& faces, Real3 traction, VariableNodeReal3& force) const
+{
+  ENUMERATE_ (Face, iface, faces) {
+    Face face = *iface;
+    Real length = m_geometry->faceMeasure(face);
+    for (Node node : face.nodes())
+      force[node] += traction * length / 2.;
+  }
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
+void CentralDifferenceIntegrator::
+correct(Real dt, VariableNodeReal3& v, const VariableNodeReal3& a, RunQueue& queue)
+{
+  auto command = makeCommand(queue);
+  auto inout_v = ax::viewInOut(command, v);
+  auto in_a = ax::viewIn(command, a);
+  auto in_fixed_mask = ax::viewIn(command, m_fixed_mask);
+
+  command << RUNCOMMAND_ENUMERATE(Node, node, m_mesh->allNodes())
+  {
+    Real3 old_v = inout_v[node];
+    Real3 a_node = in_a[node];
+    Real3 new_v = old_v + (0.5 * dt) * a_node;
+    Int32 mask = in_fixed_mask(node.localId());
+    if (mask & 1)
+      new_v.x = 0.0;
+    if (mask & 2)
+      new_v.y = 0.0;
+    inout_v[node] = new_v;
+  };
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
+} // namespace Arcane::FemUtils
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,196 @@
+﻿// -*- tab-width: 2; indent-tabs-mode: nil; coding: utf-8-with-signature -*-
+//-----------------------------------------------------------------------------
+// Copyright 2000-2024 CEA (www.cea.fr) IFPEN (www.ifpenergiesnouvelles.com)
+// See the top-level COPYRIGHT file for details.
+// SPDX-License-Identifier: Apache-2.0
+//-----------------------------------------------------------------------------
+/*---------------------------------------------------------------------------*/
+/* CentralDifferenceIntegrator.h                               (C) 2022-2024 */
+/*                                                                           */
+/* Explicit central difference time integrator for linear elastodynamics.    */
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+#ifndef ARCANEFEM_FEMUTILS_CENTRALDIFFERENCEINTEGRATOR_H
+#define ARCANEFEM_FEMUTILS_CENTRALDIFFERENCEINTEGRATOR_H
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
+#include <arcane/utils/NumArray.h>
+#include <arcane/utils/TraceAccessor.h>
+
+#include <arcane/VariableTypes.h>
+#include <arcane/ItemGroup.h>
+
+#include <arcane/accelerator/core/RunQueue.h>
+
+#include "FemGeometryCache.h"
+
+namespace Arcane::FemUtils
+{
+using namespace Arcane;
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*!
+ * \brief Explicit central difference integrator for 2D linear elasticity.
+ *
+ * The scheme is written in velocity Verlet form so that the displacement,
+ * the velocity and the acceleration are all known at the end of a step:
+ *
+ * \code
+ * v(n+1/2) = v(n) + dt/2 a(n)
+ * u(n+1)   = u(n) + dt v(n+1/2)
+ * a(n+1)   = M^-1 (f_ext(n+1) - K (u(n+1) + etak v(n+1/2))) - etam v(n+1/2)
+ * v(n+1)   = v(n+1/2) + dt/2 a(n+1)
+ * \endcode
+ *
+ * where M is the row-sum lumped mass matrix. The internal force K u is
+ * computed element by element: each node gathers the contribution of its
+ * cells, so no global matrix and no linear solver are needed and the
+ * result does not depend on the order of the cells.
+ *
+ * Only Triangle3 cells are supported. The gradients of the shape functions
+ * are read from a FemGeometryCache.
+ *
+ * Usage:
+ * \code
+ * CentralDifferenceIntegrator integrator(traceMng());
+ * integrator.initialize(mesh(), m_geometry, rho, lambda, mu, *queue);
+ * integrator.setFixedDoFs(m_u1_fixed, m_u2_fixed);
+ * dt = integrator.computeTimeStep(dt, cfl, m_node_coord, etak, *queue);
+ * ...
+ * auto compute_force = [&](Real time) {
+ *   force.fill(Real3::zero());
+ *   integrator.addLumpedBodyForce(allCells(), body_force, force);
+ *   integrator.addLumpedTraction(faces, traction, force);
+ * };
+ * integrator.doStep(t, dt, m_U, m_V, m_A, m_dU, force, etam, etak, *queue, compute_force);
+ * \endcode
+ *
+ * doStep() calls predict(), computeAcceleration() and correct(), which can
+ * also be called directly.
+ */
+class CentralDifferenceIntegrator
+: public TraceAccessor
+{
+ public:
+
+  explicit CentralDifferenceIntegrator(ITraceMng* tm)
+  : TraceAccessor(tm)
+  {
+  }
+
+ public:
+
+  //! Compute the lumped mass of the nodes of \a mesh and keep the material parameters
+  void initialize(IMesh* mesh, const FemGeometryCache& geometry, Real rho,
+                  Real lambda, Real mu, RunQueue& queue);
+
+  //! Set the components of the displacement which are prescribed
+  void setFixedDoFs(const VariableNodeBool& u1_fixed, const VariableNodeBool& u2_fixed);
+
+  /*!
+   * \brief Stable time step of the scheme, without safety factor.
+   *
+   * It is the minimum over all the sub-domains of h / cp where h is the
+   * smallest height of a cell and cp the pressure wave velocity. It is
+   * reduced when there is a stiffness proportional damping \a etak.
+   */
+  Real computeStableTimeStep(const VariableNodeReal3& node_coord, Real etak, RunQueue& queue);
+
+  /*!
+   * \brief Time step of the scheme.
+   *
+   * It is \a cfl times the stable time step. The time step \a dt given in
+   * the dataset is kept if it is positive and smaller.
+   */
+  Real computeTimeStep(Real dt, Real cfl, const VariableNodeReal3& node_coord, Real etak, RunQueue& queue);
+
+  /*!
+   * \brief Do one step of the scheme from \a time - \a dt to \a time.
+   *
+   * \a compute_external_force(t) has to fill \a external_force with the
+   * nodal external force at time t. When it is called for \a time, \a v is
+   * the velocity at the half step. Before the first step, it is also called
+   * for \a time - \a dt to compute the initial acceleration.
+   */
+  template <typename ExternalForceFunc>
+  void doStep(Real time, Real dt, VariableNodeReal3& u, VariableNodeReal3& v,
+              VariableNodeReal3& a, const VariableNodeReal3& prescribed_u,
+              const VariableNodeReal3& external_force, Real etam, Real etak,
+              RunQueue& queue, const ExternalForceFunc& compute_external_force)
+  {
+    if (!m_has_initial_acceleration) {
+      compute_external_force(time - dt);
+      computeAcceleration(u, v, external_force, etam, etak, a, queue);
+      m_has_initial_acceleration = true;
+    }
+
+    // v is now the velocity at the half step
+    predict(dt, u, v, a, prescribed_u, queue);
+
+    compute_external_force(time);
+    computeAcceleration(u, v, external_force, etam, etak, a, queue);
+
+    correct(dt, v, a, queue);
+  }
+
+  /*!
+   * \brief Compute the velocity at the half step and the displacement at the end of the step.
+   *
+   * The prescribed components are set to the value of \a prescribed_u
+   * with a zero velocity.
+   */
+  void predict(Real dt, VariableNodeReal3& u, VariableNodeReal3& v,
+               const VariableNodeReal3& a, const VariableNodeReal3& prescribed_u,
+               RunQueue& queue);
+
+  /*!
+   * \brief Compute the acceleration at the end of the step.
+   *
+   * \a v is the velocity at the half step and \a external_force the nodal
+   * external force at the end of the step. The acceleration is computed for
+   * the own nodes and then synchronized.
+   */
+  void computeAcceleration(const VariableNodeReal3& u, const VariableNodeReal3& v,
+                           const VariableNodeReal3& external_force, Real etam, Real etak,
+                           VariableNodeReal3& a, RunQueue& queue);
+
+  //! Compute the velocity at the end of the step
+  void correct(Real dt, VariableNodeReal3& v, const VariableNodeReal3& a, RunQueue& queue);
+
+  //! Add to \a force the body force \a body_force lumped on the nodes of \a cells
+  void addLumpedBodyForce(const CellGroup& cells, Real3 body_force, VariableNodeReal3& force) const;
+
+  //! Add to \a force the traction \a traction lumped on the nodes of \a faces
+  void addLumpedTraction(const FaceGroup& faces, Real3 traction, VariableNodeReal3& force) const;
+
+  Real lumpedMass(NodeLocalId node) const { return m_lumped_mass(node.localId()); }
+
+ public:
+
+  //! Row-sum lumped mass of each node
+  NumArray<Real, MDDim1> m_lumped_mass;
+  //! Prescribed components of each node (bit 0 for x, bit 1 for y)
+  NumArray<Int32, MDDim1> m_fixed_mask;
+
+ private:
+
+  IMesh* m_mesh = nullptr;
+  const FemGeometryCache* m_geometry = nullptr;
+  Real m_rho = 0.0;
+  Real m_lambda = 0.0;
+  Real m_mu = 0.0;
+  //! True when the acceleration at the initial time has been computed
+  bool m_has_initial_acceleration = false;
+};
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
+} // namespace Arcane::FemUtils
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
+#endif
@@ -0,0 +1,332 @@
+﻿// -*- tab-width: 2; indent-tabs-mode: nil; coding: utf-8-with-signature -*-
+//-----------------------------------------------------------------------------
+// Copyright 2000-2024 CEA (www.cea.fr) IFPEN (www.ifpenergiesnouvelles.com)
+// See the top-level COPYRIGHT file for details.
+// SPDX-License-Identifier: Apache-2.0
+//-----------------------------------------------------------------------------
+/*---------------------------------------------------------------------------*/
+/* CooFormatMatrix.cc                                          (C) 2022-2024 */
+/*                                                                           */
+/* Sort and reduction of the COO matrix.                                     */
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
+#include "CooFormatMatrix.h"
+
+#include <arcane/core/Concurrency.h>
+
+#include <arcane/accelerator/RunCommandLoop.h>
+#include <arcane/accelerator/Scan.h>
+
+#include <utility>
+
+namespace Arcane::FemUtils
+{
+
+namespace
+{
+  //! Number of bits of the digits of the radix sort
+  constexpr Int32 RADIX_NB_BIT = 8;
+  constexpr Int32 RADIX_SIZE = 1 << RADIX_NB_BIT;
+  constexpr UInt64 RADIX_MASK = RADIX_SIZE - 1;
+  //! Minimum number of values sorted by one iteration of the radix sort loops on the host
+  constexpr Int32 RADIX_MIN_BLOCK_SIZE = 4096;
+  //! Number of values sorted by one iteration of the radix sort loops on accelerator
+  constexpr Int32 RADIX_DEVICE_BLOCK_SIZE = 1024;
+
+  /*!
+   * \brief Number of blocks of the radix sort of \a n values.
+   *
+   * On accelerator, there is one block per RADIX_DEVICE_BLOCK_SIZE values so
+   * that the whole device is used. On the host, a few blocks per thread are
+   * enough and a block has at least RADIX_MIN_BLOCK_SIZE values.
+   */
+  Int32 _radixNbBlock(RunQueue& queue, Int32 n)
+  {
+    const auto policy = queue.executionPolicy();
+    Int32 nb_block = 1;
+    if (ax::isAcceleratorPolicy(policy))
+      nb_block = n / RADIX_DEVICE_BLOCK_SIZE;
+    else {
+      const Int32 nb_thread = (policy == ax::eExecutionPolicy::Thread) ? TaskFactory::nbAllowedThread() : 1;
+      nb_block = math::min(4 * nb_thread, n / RADIX_MIN_BLOCK_SIZE);
+    }
+    return math::max(1, nb_block);
+  }
+
+  //! Number of bits needed to store values in [0,n]
+  Int32 _nbBit(Int64 n)
+  {
+    Int32 nb_bit = 0;
+    while ((Int64(1) << nb_bit) <= n)
+      ++nb_bit;
+    return nb_bit;
+  }
+} // namespace
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*!
+ * \brief Compute the keys of the sort and the initial permutation.
+ *
+ * The key of the value (row,column) is (row << nb_column_bit) + column.
+ * Null rows are replaced by the number of DoFs so that these values are
+ * at the end after the sort.
+ *
+ * Returns the number of significant bits of the keys.
+ */
+Int32 CooFormat::
+_computeSortKeys(RunQueue& queue)
+{
+  const Int32 n = m_nnz;
+  const Int32 nb_dof = m_dof_family->maxLocalId();
+  const Int32 nb_column_bit = _nbBit(nb_dof);
+  const Int32 nb_key_bit = 2 * nb_column_bit;
+
+  m_sort_key.resize(n);
+  m_sort_index.resize(n);
+  auto command = makeCommand(queue);
+  auto in_row = ax::viewIn(command, m_matrix_row);
+  auto in_column = ax::viewIn(command, m_matrix_column);
+  auto out_key = ax::viewOut(command, m_sort_key);
+  auto out_index = ax::viewOut(command, m_sort_index);
+  command << RUNCOMMAND_LOOP1(iter, n)
+  {
+    auto [i] = iter();
+    Int32 row = in_row(i);
+    if (row < 0)
+      row = nb_dof;
+    out_key(i) = (static_cast<UInt64>(row) << nb_column_bit) + static_cast<UInt64>(in_column(i));
+    out_index(i) = i;
+  };
+  return nb_key_bit;
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*!
+ * \brief Stable LSD radix sort of m_sort_key.
+ *
+ * m_sort_index contains the permutation applied to the keys. The values
+ * are split in blocks. For each digit, a first loop computes the histogram
+ * of each block, the offsets of each (digit,block) are computed by a scan
+ * and a second loop moves the values of each block to their new position.
+ */
+void CooFormat::
+_radixSort(RunQueue& queue, Int32 nb_key_bit)
+{
+  const Int32 n = m_nnz;
+  const Int32 nb_block = _radixNbBlock(queue, n);
+  const Int32 block_size = (n + nb_block - 1) / nb_block;
+
+  m_sort_key_work.resize(n);
+  m_sort_index_work.resize(n);
+  m_sort_histogram.resize(nb_block * RADIX_SIZE);
+  m_sort_offset.resize(nb_block * RADIX_SIZE);
+  ax::Scanner<Int32> scanner;
+
+  NumArray<UInt64, MDDim1>* key = &m_sort_key;
+  NumArray<UInt64, MDDim1>* key_work = &m_sort_key_work;
+  NumArray<Int32, MDDim1>* index = &m_sort_index;
+  NumArray<Int32, MDDim1>* index_work = &m_sort_index_work;
+
+  for (Int32 shift = 0; shift < nb_key_bit; shift += RADIX_NB_BIT) {
+    // Histogram of the digits of each block. The histogram is stored by
+    // digit so that the blocks of the same digit are consecutive.
+    {
+      auto command = makeCommand(queue);
+      auto in_key = ax::viewIn(command, *key);
+      auto out_histogram = ax::viewOut(command, m_sort_histogram);
+      command << RUNCOMMAND_LOOP1(iter, nb_block)
+      {
+        auto [block] = iter();
+        Int32 histogram[RADIX_SIZE] = {};
+        Int32 begin = block * block_size;
+        Int32 end = math::min(n, begin + block_size);
+        for (Int32 i = begin; i < end; ++i)
+          ++histogram[(in_key(i) >> shift) & RADIX_MASK];
+        for (Int32 d = 0; d < RADIX_SIZE; ++d)
+          out_histogram(d * nb_block + block) = histogram[d];
+      };
+    }
+
+    // Offsets of each (digit,block). Blocks of the same digit are
+    // consecutive so the sort is stable.
+    scanner.exclusiveSum(&queue, m_sort_histogram, m_sort_offset);
+
+    // Move the values to their new position.
+    {
+      auto command = makeCommand(queue);
+      auto in_key = ax::viewIn(command, *key);
+      auto in_index = ax::viewIn(command, *index);
+      auto out_key = ax::viewOut(command, *key_work);
+      auto out_index = ax::viewOut(command, *index_work);
+      auto in_offset = ax::viewIn(command, m_sort_offset);
+      command << RUNCOMMAND_LOOP1(iter, nb_block)
+      {
+        auto [block] = iter();
+        Int32 offsets[RADIX_SIZE];
+        for (Int32 d = 0; d < RADIX_SIZE; ++d)
+          offsets[d] = in_offset(d * nb_block + block);
+        Int32 begin = block * block_size;
+        Int32 end = math::min(n, begin + block_size);
+        for (Int32 i = begin; i < end; ++i) {
+          UInt64 k = in_key(i);
+          Int32 position = offsets[(k >> shift) & RADIX_MASK]++;
+          out_key(position) = k;
+          out_index(position) = in_index(i);
+        }
+      };
+    }
+    std::swap(key, key_work);
+    std::swap(index, index_work);
+  }
+
+  // The result has to be in m_sort_key and m_sort_index.
+  if (key != &m_sort_key) {
+    m_sort_key.copy(*key);
+    m_sort_index.copy(*index);
+  }
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
+void CooFormat::
+sortAndReduce(RunQueue& queue)
+{
+  const Int32 n = m_nnz;
+  const Int32 nb_dof = m_dof_family->maxLocalId();
+  Int32 nb_key_bit = _computeSortKeys(queue);
+  _radixSort(queue, nb_key_bit);
+
+  // Values with a null row are at the end.
+  const Int32 nb_column_bit = nb_key_bit / 2;
+  const UInt64 first_null_key = static_cast<UInt64>(nb_dof) << nb_column_bit;
+  Int32 nb_valid = n;
+  while (nb_valid > 0 && m_sort_key(nb_valid - 1) >= first_null_key)
+    --nb_valid;
+
+  // Flag the first value of each segment of equal keys and compute the
+  // index of the segments with a scan.
+  NumArray<Int32, MDDim1> is_segment_begin(nb_valid);
+  NumArray<Int32, MDDim1> segment_index(nb_valid);
+  {
+    auto command = makeCommand(queue);
+    auto in_key = ax::viewIn(command, m_sort_key);
+    auto out_is_segment_begin = ax::viewOut(command, is_segment_begin);
+    command << RUNCOMMAND_LOOP1(iter, nb_valid)
+    {
+      auto [i] = iter();
+      out_is_segment_begin(i) = (i == 0 || in_key(i) != in_key(i - 1)) ? 1 : 0;
+    };
+  }
+  ax::Scanner<Int32> scanner;
+  scanner.exclusiveSum(&queue, is_segment_begin, segment_index);
+  const Int32 nb_segment = (nb_valid == 0) ? 0 : (segment_index(nb_valid - 1) + is_segment_begin(nb_valid - 1));
+
+  NumArray<Int32, MDDim1> segment_begin(nb_segment + 1);
+  segment_begin(nb_segment) = nb_valid;
+  {
+    auto command = makeCommand(queue);
+    auto in_is_segment_begin = ax::viewIn(command, is_segment_begin);
+    auto in_segment_index = ax::viewIn(command, segment_index);
+    auto out_segment_begin = ax::viewOut(command, segment_begin);
+    command << RUNCOMMAND_LOOP1(iter, nb_valid)
+    {
+      auto [i] = iter();
+      if (in_is_segment_begin(i))
+        out_segment_begin(in_segment_index(i)) = i;
+    };
+  }
+
+  // Sum the values of each segment.
+  NumArray<Int32, MDDim1> reduced_row(nb_segment);
+  NumArray<Int32, MDDim1> reduced_column(nb_segment);
+  NumArray<Real, MDDim1> reduced_value(nb_segment);
+  {
+    auto command = makeCommand(queue);
+    auto in_segment_begin = ax::viewIn(command, segment_begin);
+    auto in_index = ax::viewIn(command, m_sort_index);
+    auto in_row = ax::viewIn(command, m_matrix_row);
+    auto in_column = ax::viewIn(command, m_matrix_column);
+    auto in_value = ax::viewIn(command, m_matrix_value);
+    auto out_row = ax::viewOut(command, reduced_row);
+    auto out_column = ax::viewOut(command, reduced_column);
+    auto out_value = ax::viewOut(command, reduced_value);
+    command << RUNCOMMAND_LOOP1(iter, nb_segment)
+    {
+      auto [s] = iter();
+      Int32 begin = in_segment_begin(s);
+      Int32 end = in_segment_begin(s + 1);
+      Real sum = 0.0;
+      for (Int32 j = begin; j < end; ++j)
+        sum += in_value(in_index(j));
+      Int32 first_index = in_index(begin);
+      out_row(s) = in_row(first_index);
+      out_column(s) = in_column(first_index);
+      out_value(s) = sum;
+    };
+  }
+
+  info() << "COO sort and reduce nb_value=" << n << " nb_non_zero=" << nb_segment;
+  m_matrix_row.resize(nb_segment);
+  m_matrix_row.copy(reduced_row);
+  m_matrix_column.resize(nb_segment);
+  m_matrix_column.copy(reduced_column);
+  m_matrix_value.resize(nb_segment);
+  m_matrix_value.copy(reduced_value);
+  m_nnz = nb_segment;
+  m_last_value = nb_segment;
+  m_is_reduced = true;
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*!
+ * \brief Compute the beginning and the number of columns of each row.
+ *
+ * The matrix has to be sorted and reduced.
+ */
+void CooFormat::
+_computeCSRRows()
+{
+  const Int32 nb_dof = m_dof_family->maxLocalId();
+  m_csr_row.resize(nb_dof);
+  m_csr_row.fill(0);
+  m_csr_rows_nb_column.resize(nb_dof);
+  m_csr_rows_nb_column.fill(0);
+  for (Int32 i = 0; i < m_nnz; ++i)
+    ++m_csr_rows_nb_column(m_matrix_row(i));
+  Int32 offset = 0;
+  for (Int32 row = 0; row < nb_dof; ++row) {
+    m_csr_row(row) = offset;
+    offset += m_csr_rows_nb_column(row);
+  }
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
+void CooFormat::
+translateToLinearSystem(DoFLinearSystem& linear_system)
+{
+  if (m_is_reduced && linear_system.hasSetCSRValues()) {
+    _computeCSRRows();
+    CSRFormatView csr_view(m_csr_row.to1DSpan(), m_csr_rows_nb_column.to1DSpan(),
+                           m_matrix_column.to1DSpan(), m_matrix_value.to1DSpan());
+    linear_system.setCSRValues(csr_view);
+    return;
+  }
+  for (Int32 i = 0; i < m_nnz; i++) {
+    linear_system.matrixAddValue(DoFLocalId(m_matrix_row(i)), DoFLocalId(m_matrix_column(i)), m_matrix_value(i));
+  }
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
+} // namespace Arcane::FemUtils
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
@@ -1,11 +1,11 @@
-// -*- tab-width: 2; indent-tabs-mode: nil; coding: utf-8-with-signature -*-
+﻿// -*- tab-width: 2; indent-tabs-mode: nil; coding: utf-8-with-signature -*-
 //-----------------------------------------------------------------------------
-// Copyright 2000-2023 CEA (www.cea.fr) IFPEN (www.ifpenergiesnouvelles.com)
+// Copyright 2000-2024 CEA (www.cea.fr) IFPEN (www.ifpenergiesnouvelles.com)
 // See the top-level COPYRIGHT file for details.
 // SPDX-License-Identifier: Apache-2.0
 //-----------------------------------------------------------------------------
 /*---------------------------------------------------------------------------*/
-/* CsrFormatMatrix.cc                                     (C) 2022-2023 */
+/* CooFormatMatrix.h                                           (C) 2022-2024 */
 /*                                                                           */
 /*---------------------------------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
@@ -27,6 +27,7 @@
 #include <fstream>
 
 #include "arcane/accelerator/NumArrayViews.h"
+#include "arcane/accelerator/core/RunQueue.h"
 
 namespace Arcane::FemUtils
 {
@@ -54,6 +55,7 @@ class CooFormat : TraceAccessor
     m_dof_family = dof_family;
     m_last_value = 0;
     m_nnz = nnz;
+    m_is_reduced = false;
     info() << "Filling COO Matrix with zeros";
   }
 
@@ -75,18 +77,6 @@ class CooFormat : TraceAccessor
     m_matrix_value(indexValue(row, column)) += value;
   }
 
-  /**
- * @brief  Translate to Arcane linear system
- * 
- * @param linear_system 
- */
-  void translateToLinearSystem(DoFLinearSystem& linear_system)
-  {
-    for (Int32 i = 0; i < m_nnz; i++) {
-      linear_system.matrixAddValue(DoFLocalId(m_matrix_row(i)), DoFLocalId(m_matrix_column(i)), m_matrix_value(i));
-    }
-  }
-
   /**
  * @brief function to print the current content of the csr matrix 
  * 
@@ -125,25 +115,39 @@ class CooFormat : TraceAccessor
     m_last_value++;
   }
 
-  void sort()
-  {
-    sortMatrix(true, 0, m_matrix_row.extent0() - 1);
-    Int32 begin = 0;
-    for (Int32 i = 0; i < m_matrix_row.extent0(); i++) {
-      if (i + 1 == m_matrix_row.extent0() || m_matrix_row(i + 1) != m_matrix_row(begin)) {
-        sortMatrix(false, begin, i);
-        begin = i + 1;
-      }
-    }
-  }
+  /**
+   * @brief Sort the values and merge the values with the same coordinates.
+   *
+   * This is used when the values are added without computing the structure
+   * of the matrix first: each contribution is stored at its own index and
+   * the duplicates are summed by this method. Values with a null row are
+   * removed.
+   *
+   * After this call, the coordinates are unique, sorted by row and then
+   * by column, and m_nnz is the number of distinct coordinates.
+   *
+   * The sort is a LSD radix sort on the key (row, column) packed in a 64 bits
+   * integer. Each pass is done in parallel on @a queue.
+   */
+  void sortAndReduce(RunQueue& queue);
+
+  /**
+   * @brief Translate to Arcane linear system
+   *
+   * If the matrix has been reduced with sortAndReduce() and if the linear system
+   * supports it, the values are given in CSR format with setCSRValues().
+   *
+   * @param linear_system
+   */
+  void translateToLinearSystem(DoFLinearSystem& linear_system);
 
  public:
 
-  Int32 m_nnz;
+  Int32 m_nnz = 0;
   // To become parallelizable, have all the index
   // inside a queue that would gradually pop ?
   // or link the idnex to the index of the core ?
-  Int32 m_last_value;
+  Int32 m_last_value = 0;
   NumArray<Int32, MDDim1> m_matrix_row;
   NumArray<Int32, MDDim1> m_matrix_column;
   NumArray<Real, MDDim1> m_matrix_value;
@@ -222,78 +226,24 @@ class CooFormat : TraceAccessor
     return -1;
   }
 
-  /**
- * @brief Quicksort algorithm for the CSR Matrix 
- * 
- * @param is_row
- * @param start 
- * @param end 
- */
-  void
-  sortMatrix(bool is_row, Int32 start, Int32 end)
-  {
-    if (start >= end) {
-      return;
-    }
-
-    int pivot = partition(is_row, start, end);
-
-    sortMatrix(is_row, start, pivot - 1);
-
-    sortMatrix(is_row, pivot + 1, end);
-  }
-
-  /**
- * @brief Partition helper for the quickSort 
- * 
- * @param is_row 
- * @param start 
- * @param end 
- * @return Int32 
- */
-  Int32 partition(bool is_row, Int32 start, Int32 end)
-  {
-    Int32 pivot;
-    if (is_row)
-      pivot = m_matrix_row[end];
-    else
-      pivot = m_matrix_column[end];
-
-    Int32 pIndex = start;
-
-    for (Int32 i = start; i < end; i++) {
-      if ((is_row && m_matrix_row[i] <= pivot) || (!is_row && m_matrix_column[i] <= pivot)) {
-
-        swap(is_row, i, pIndex);
-        pIndex++;
-      }
-    }
-
-    swap(is_row, pIndex, end);
-
-    return pIndex;
-  }
-
-  /**
- * @brief Swap helper for the quickSort 
- * 
- * @param is_row 
- * @param i 
- * @param j 
- */
-  void swap(bool is_row, Int32 i, Int32 j)
-  {
-    if (is_row) {
-      Int32 tmp = m_matrix_row(i);
-      m_matrix_row(i) = m_matrix_row(j);
-      m_matrix_row(j) = tmp;
-    }
-    Int32 tmp = m_matrix_column(i);
-    m_matrix_column(i) = m_matrix_column(j);
-    m_matrix_column(j) = tmp;
-    Real tmp_val = m_matrix_value(i);
-    m_matrix_value(i) = m_matrix_value(j);
-    m_matrix_value(j) = tmp_val;
-  }
+ private:
+
+  //! Keys and permutation for the radix sort
+  NumArray<UInt64, MDDim1> m_sort_key;
+  NumArray<UInt64, MDDim1> m_sort_key_work;
+  NumArray<Int32, MDDim1> m_sort_index;
+  NumArray<Int32, MDDim1> m_sort_index_work;
+  NumArray<Int32, MDDim1> m_sort_histogram;
+  NumArray<Int32, MDDim1> m_sort_offset;
+  //! CSR view of the matrix after sortAndReduce()
+  NumArray<Int32, MDDim1> m_csr_row;
+  NumArray<Int32, MDDim1> m_csr_rows_nb_column;
+  bool m_is_reduced = false;
+
+ private:
+
+  Int32 _computeSortKeys(RunQueue& queue);
+  void _radixSort(RunQueue& queue, Int32 nb_key_bit);
+  void _computeCSRRows();
 };
 } // namespace Arcane::FemUtils
\ No newline at end of file
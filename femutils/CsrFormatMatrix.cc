@@ -1,6 +1,6 @@
 ﻿// -*- tab-width: 2; indent-tabs-mode: nil; coding: utf-8-with-signature -*-
 //-----------------------------------------------------------------------------
-// Copyright 2000-2023 CEA (www.cea.fr) IFPEN (www.ifpenergiesnouvelles.com)
+// Copyright 2000-2024 CEA (www.cea.fr) IFPEN (www.ifpenergiesnouvelles.com)
 // See the top-level COPYRIGHT file for details.
 // SPDX-License-Identifier: Apache-2.0
 //-----------------------------------------------------------------------------
@@ -18,8 +18,19 @@
 
 #include "CsrFormatMatrix.h"
 
+#include <arcane/core/ItemInfoListView.h>
+#include <arcane/core/IMesh.h>
+#include <arcane/core/UnstructuredMeshConnectivity.h>
+
+#include <arcane/accelerator/RunCommandLoop.h>
+#include <arcane/accelerator/RunCommandEnumerate.h>
+#include <arcane/accelerator/Scan.h>
+#include <arcane/accelerator/NumArrayViews.h>
+#include <arcane/accelerator/Atomic.h>
+
 namespace Arcane::FemUtils
 {
+namespace ax = Arcane::Accelerator;
 
 /*---------------------------------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
@@ -40,49 +51,338 @@ initialize(IItemFamily* dof_family, Int32 nnz, Int32 nbRow)
   m_dof_family = dof_family;
   m_last_value = 0;
   m_nnz = nnz;
+  m_has_cell_value_index = false;
+  m_is_symmetric = false;
   info() << "Filling CSR Matrix with zeros";
 }
 
 /*---------------------------------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
 
+void CsrFormat::
+computeSparsity(IItemFamily* dof_family, IMesh* mesh, IndexedNodeDoFConnectivityView node_dof,
+                Int32 nb_dof_per_node, RunQueue& queue, bool is_symmetric)
+{
+  const Int32 nb_dof = dof_family->maxLocalId();
+  UnstructuredMeshConnectivityView connectivity_view;
+  connectivity_view.setMesh(mesh);
+  auto nc = connectivity_view.nodeCell();
+  auto cnc = connectivity_view.cellNode();
+
+  // Number of columns of each row.
+  NumArray<Int32, MDDim1> rows_nb_column(nb_dof);
+  rows_nb_column.fill(0);
+  {
+    auto command = makeCommand(queue);
+    auto out_rows_nb_column = ax::viewOut(command, rows_nb_column);
+    command << RUNCOMMAND_ENUMERATE(Node, node, mesh->allNodes())
+    {
+      for (Int32 i = 0; i < nb_dof_per_node; ++i) {
+        DoFLocalId row = node_dof.dofId(node, i);
+        Int32 nb_column = 0;
+        for (Int32 c = 0, nb_cell = nc.nbCell(node); c < nb_cell; ++c) {
+          CellLocalId cell = nc.cellId(node, c);
+          for (Int32 n = 0, nb_node = cnc.nbNode(cell); n < nb_node; ++n) {
+            if (!isFirstNodeNeighbour(node, c, n, nc, cnc))
+              continue;
+            NodeLocalId neighbour = cnc.nodeId(cell, n);
+            for (Int32 j = 0; j < nb_dof_per_node; ++j)
+              if (!is_symmetric || node_dof.dofId(neighbour, j).localId() >= row.localId())
+                ++nb_column;
+          }
+        }
+        out_rows_nb_column(row.localId()) = nb_column;
+      }
+    };
+  }
+
+  // Beginning of each row.
+  NumArray<Int32, MDDim1> rows_begin(nb_dof);
+  ax::Scanner<Int32> scanner;
+  scanner.exclusiveSum(&queue, rows_nb_column, rows_begin);
+  const Int32 nnz = (nb_dof == 0) ? 0 : (rows_begin(nb_dof - 1) + rows_nb_column(nb_dof - 1));
+
+  initialize(dof_family, nnz, nb_dof);
+  setSymmetric(is_symmetric);
+  m_matrix_row.copy(rows_begin);
+  m_matrix_rows_nb_column.copy(rows_nb_column);
+  m_last_value = nnz;
+
+  // Columns of each row.
+  {
+    auto command = makeCommand(queue);
+    auto in_row = ax::viewIn(command, m_matrix_row);
+    auto out_column = ax::viewInOut(command, m_matrix_column);
+    command << RUNCOMMAND_ENUMERATE(Node, node, mesh->allNodes())
+    {
+      for (Int32 i = 0; i < nb_dof_per_node; ++i) {
+        DoFLocalId row = node_dof.dofId(node, i);
+        const Int32 begin = in_row(row.localId());
+        Int32 end = begin;
+        for (Int32 c = 0, nb_cell = nc.nbCell(node); c < nb_cell; ++c) {
+          CellLocalId cell = nc.cellId(node, c);
+          for (Int32 n = 0, nb_node = cnc.nbNode(cell); n < nb_node; ++n) {
+            if (!isFirstNodeNeighbour(node, c, n, nc, cnc))
+              continue;
+            NodeLocalId neighbour = cnc.nodeId(cell, n);
+            for (Int32 j = 0; j < nb_dof_per_node; ++j) {
+              Int32 column = node_dof.dofId(neighbour, j).localId();
+              if (is_symmetric && column < row.localId())
+                continue;
+              // Insertion sort of the columns of the row
+              Int32 k = end;
+              for (; k > begin && out_column(k - 1) > column; --k)
+                out_column(k) = out_column(k - 1);
+              out_column(k) = column;
+              ++end;
+            }
+          }
+        }
+      }
+    };
+  }
+  info() << "CsrFormat sparsity nb_row=" << nb_dof << " nb_non_zero=" << nnz
+         << " nb_dof_per_node=" << nb_dof_per_node << " symmetric=" << is_symmetric;
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
 void CsrFormat::
 translateToLinearSystem(DoFLinearSystem& linear_system)
 {
   info() << "TranslateToLinearSystem this=" << this;
   bool do_set_csr = linear_system.hasSetCSRValues();
+
+  if (m_is_symmetric) {
+    if (do_set_csr && linear_system.hasSymmetricCSRValues()) {
+      // The linear system uses the upper triangular part directly.
+      _computeRowsNbColumn();
+      CSRFormatView csr_view(m_matrix_row.to1DSpan(), m_matrix_rows_nb_column.to1DSpan(),
+                             m_matrix_column.to1DSpan(), m_matrix_value.to1DSpan());
+      csr_view.setSymmetric(true);
+      linear_system.setCSRValues(csr_view);
+      return;
+    }
+    // The linear system needs the full matrix.
+    _expandSymmetricMatrix();
+    CSRFormatView csr_view(m_full_matrix_row.to1DSpan(), m_full_matrix_rows_nb_column.to1DSpan(),
+                           m_full_matrix_column.to1DSpan(), m_full_matrix_value.to1DSpan());
+    if (do_set_csr) {
+      linear_system.setCSRValues(csr_view);
+      return;
+    }
+    Int32 nb_row = m_full_matrix_row.extent0();
+    for (Int32 i = 0; i < nb_row; ++i) {
+      Int32 begin = m_full_matrix_row(i);
+      for (Int32 j = begin, end = begin + m_full_matrix_rows_nb_column(i); j < end; ++j)
+        linear_system.matrixAddValue(DoFLocalId(i), DoFLocalId(m_full_matrix_column(j)), m_full_matrix_value(j));
+    }
+    return;
+  }
+
   // When using CSR format, we need to know the number of non zero values for
   // each row.
   // NOTE: it should be possible to compute that in setCoordinates().
   // and this value is constant if the structure of the matrix do not change
   // so we can store these values instead of recomputing them.
+  if (do_set_csr)
+    _computeRowsNbColumn();
+  else {
+    Int32 nb_row = m_matrix_row.dim1Size();
+    for (Int32 i = 0; i < nb_row; i++) {
+      if (((i + 1) < nb_row) && (m_matrix_row(i) == m_matrix_row(i + 1)))
+        continue;
+      for (Int32 j = m_matrix_row(i); ((i + 1) < nb_row && j < m_matrix_row(i + 1)) || ((i + 1) == nb_row && j < m_matrix_column.dim1Size()); j++) {
+        if (DoFLocalId(m_matrix_column(j)).isNull())
+          continue;
+        //info() << "Add: (" << i << ", " << m_matrix_column(j) << " v=" << m_matrix_value(j);
+        linear_system.matrixAddValue(DoFLocalId(i), DoFLocalId(m_matrix_column(j)), m_matrix_value(j));
+      }
+    }
+  }
+
   if (do_set_csr){
-    m_matrix_rows_nb_column.resize(m_matrix_row.extent0());
-    m_matrix_rows_nb_column.fill(0);
+    CSRFormatView csr_view(m_matrix_row.to1DSpan(),m_matrix_rows_nb_column.to1DSpan(),
+                           m_matrix_column.to1DSpan(),m_matrix_value.to1DSpan());
+    linear_system.setCSRValues(csr_view);
   }
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
+void CsrFormat::
+_computeRowsNbColumn()
+{
   Int32 nb_row = m_matrix_row.dim1Size();
+  m_matrix_rows_nb_column.resize(nb_row);
+  m_matrix_rows_nb_column.fill(0);
   for (Int32 i = 0; i < nb_row; i++) {
     if (((i + 1) < nb_row) && (m_matrix_row(i) == m_matrix_row(i + 1)))
       continue;
-    for (Int32 j = m_matrix_row(i); ((i + 1) < nb_row && j < m_matrix_row(i + 1)) || ((i + 1) == nb_row && j < m_matrix_column.dim1Size()); j++) {
-      if (do_set_csr){
-        ++m_matrix_rows_nb_column[i];
+    Int32 end = ((i + 1) < nb_row) ? m_matrix_row(i + 1) : m_matrix_column.dim1Size();
+    m_matrix_rows_nb_column[i] = end - m_matrix_row(i);
+  }
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*!
+ * \brief Build the full CSR matrix from the upper triangular part.
+ *
+ * Only the rows of the own DoFs are filled because they are the only ones
+ * used by the linear systems.
+ */
+void CsrFormat::
+_expandSymmetricMatrix()
+{
+  _computeRowsNbColumn();
+  Int32 nb_row = m_matrix_row.dim1Size();
+  DoFInfoListView dofs(m_dof_family);
+
+  // Count the number of values of each full row.
+  m_full_matrix_rows_nb_column.resize(nb_row);
+  m_full_matrix_rows_nb_column.fill(0);
+  for (Int32 i = 0; i < nb_row; ++i) {
+    Int32 begin = m_matrix_row(i);
+    for (Int32 j = begin, end = begin + m_matrix_rows_nb_column(i); j < end; ++j) {
+      Int32 column = m_matrix_column(j);
+      if (column < 0)
         continue;
-      }
-      if (DoFLocalId(m_matrix_column(j)).isNull())
+      if (dofs[i].isOwn())
+        ++m_full_matrix_rows_nb_column(i);
+      if (column != i && dofs[column].isOwn())
+        ++m_full_matrix_rows_nb_column(column);
+    }
+  }
+  m_full_matrix_row.resize(nb_row);
+  Int32 nb_value = 0;
+  for (Int32 i = 0; i < nb_row; ++i) {
+    m_full_matrix_row(i) = nb_value;
+    nb_value += m_full_matrix_rows_nb_column(i);
+  }
+  m_full_matrix_column.resize(nb_value);
+  m_full_matrix_value.resize(nb_value);
+
+  // Fill the values. 'm_full_matrix_rows_nb_column' is used as the insertion
+  // position during the filling.
+  m_full_matrix_rows_nb_column.fill(0);
+  auto add_value = [&](Int32 row, Int32 column, Real value) {
+    Int32 index = m_full_matrix_row(row) + m_full_matrix_rows_nb_column(row);
+    m_full_matrix_column(index) = column;
+    m_full_matrix_value(index) = value;
+    ++m_full_matrix_rows_nb_column(row);
+  };
+  for (Int32 i = 0; i < nb_row; ++i) {
+    Int32 begin = m_matrix_row(i);
+    for (Int32 j = begin, end = begin + m_matrix_rows_nb_column(i); j < end; ++j) {
+      Int32 column = m_matrix_column(j);
+      if (column < 0)
         continue;
-      //info() << "Add: (" << i << ", " << m_matrix_column(j) << " v=" << m_matrix_value(j);
-      linear_system.matrixAddValue(DoFLocalId(i), DoFLocalId(m_matrix_column(j)), m_matrix_value(j));
+      Real value = m_matrix_value(j);
+      if (dofs[i].isOwn())
+        add_value(i, column, value);
+      if (column != i && dofs[column].isOwn())
+        add_value(column, i, value);
     }
   }
+}
 
-  if (do_set_csr){
-    CSRFormatView csr_view(m_matrix_row.to1DSpan(),m_matrix_rows_nb_column.to1DSpan(),
-                           m_matrix_column.to1DSpan(),m_matrix_value.to1DSpan());
-    linear_system.setCSRValues(csr_view);
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
+void CsrFormat::
+computeCellValueIndexes(CellGroup cells, IndexedNodeDoFConnectivityView node_dof)
+{
+  Int32 nb_node_per_cell = 0;
+  ENUMERATE_ (Cell, icell, cells) {
+    nb_node_per_cell = math::max(nb_node_per_cell, (*icell).nbNode());
+  }
+  const Int32 nb_cell_value = nb_node_per_cell * nb_node_per_cell;
+  info() << "Compute CSR cell value indexes nb_cell=" << cells.size() << " nb_value_per_cell=" << nb_cell_value;
+
+  m_cell_value_index.resize(cells.itemFamily()->maxLocalId(), nb_cell_value);
+  m_cell_value_index.fill(-1);
+  ENUMERATE_ (Cell, icell, cells) {
+    Cell cell = *icell;
+    Int32 nb_node = cell.nbNode();
+    for (Int32 i = 0; i < nb_node; ++i) {
+      Node node1 = cell.node(i);
+      DoFLocalId dof1 = node_dof.dofId(node1, 0);
+      for (Int32 j = 0; j < nb_node; ++j) {
+        Node node2 = cell.node(j);
+        DoFLocalId dof2 = node_dof.dofId(node2, 0);
+        Int32 index = -1;
+        if (m_is_symmetric) {
+          // The value (i,j) and (j,i) are the same and only stored once.
+          if (j >= i && (node1.isOwn() || node2.isOwn())) {
+            if (dof1.localId() <= dof2.localId())
+              index = indexValue(dof1, dof2);
+            else
+              index = indexValue(dof2, dof1);
+          }
+        }
+        else if (node1.isOwn())
+          index = indexValue(dof1, dof2);
+        m_cell_value_index(icell.itemLocalId(), i * nb_node + j) = index;
+      }
+    }
+  }
+  m_has_cell_value_index = true;
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
+void CsrFormat::
+multiply(RunQueue& queue, Span<const Real> x, Span<Real> y)
+{
+  _computeRowsNbColumn();
+  const Int32 nb_row = m_matrix_row.dim1Size();
+  const bool is_symmetric = m_is_symmetric;
+
+  if (is_symmetric) {
+    // Contributions of the transpose are added to other rows.
+    auto command = makeCommand(queue);
+    command << RUNCOMMAND_LOOP1(iter, nb_row)
+    {
+      auto [i] = iter();
+      y[i] = 0.0;
+    };
   }
+
+  auto command = makeCommand(queue);
+  auto in_row = ax::viewIn(command, m_matrix_row);
+  auto in_rows_nb_column = ax::viewIn(command, m_matrix_rows_nb_column);
+  auto in_column = ax::viewIn(command, m_matrix_column);
+  auto in_value = ax::viewIn(command, m_matrix_value);
+  command << RUNCOMMAND_LOOP1(iter, nb_row)
+  {
+    auto [row] = iter();
+    Int32 begin = in_row(row);
+    Int32 end = begin + in_rows_nb_column(row);
+    Real sum = 0.0;
+    Real x_row = x[row];
+    for (Int32 j = begin; j < end; ++j) {
+      Int32 column = in_column(j);
+      if (column < 0)
+        continue;
+      Real value = in_value(j);
+      sum += value * x[column];
+      if (is_symmetric && column != row)
+        ax::doAtomic<ax::eAtomicOperation::Add>(y[column], value * x_row);
+    }
+    if (is_symmetric)
+      ax::doAtomic<ax::eAtomicOperation::Add>(y[row], sum);
+    else
+      y[row] = sum;
+  };
 }
 
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
 void CsrFormat::
 printMatrix(std::string fileName)
 {
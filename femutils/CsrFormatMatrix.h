@@ -15,6 +15,9 @@
 
 #include <arcane/VariableTypes.h>
 #include <arcane/IItemFamily.h>
+#include <arcane/IndexedItemConnectivityView.h>
+
+#include <arcane/accelerator/core/RunQueue.h>
 
 #include <arcane/aleph/AlephTypesSolver.h>
 #include <arcane/aleph/Aleph.h>
@@ -42,6 +45,39 @@ class CsrFormat
 
   void initialize(IItemFamily* dof_family, Int32 nnz, Int32 nbRow);
 
+  /*!
+   * \brief Initialize the matrix and compute its structure from the mesh.
+   *
+   * There is a non-zero value between two DoFs if their nodes share a cell.
+   * It works for any type of cell and any number of DoFs per node so there is
+   * no need of a formula for the number of non-zero values.
+   * \a nb_dof_per_node is the number of DoFs per node given by \a node_dof.
+   * If \a is_symmetric is true, only the upper triangular part is computed
+   * (see setSymmetric()).
+   *
+   * The structure is computed on \a queue in three steps: the number of
+   * columns of each row, an exclusive scan to get the beginning of the rows
+   * and the filling of the columns. Columns of a row are sorted.
+   */
+  void computeSparsity(IItemFamily* dof_family, IMesh* mesh, IndexedNodeDoFConnectivityView node_dof,
+                       Int32 nb_dof_per_node, RunQueue& queue, bool is_symmetric = false);
+
+  /*!
+   * \brief Set the symmetric storage mode.
+   *
+   * In this mode only the upper triangular part (column >= row) of the
+   * matrix is stored. setCoordinates(), matrixAddValue() and
+   * matrixSetValue() have to be called only with column >= row.
+   * translateToLinearSystem() gives the upper triangular part to the linear
+   * systems which support it (see DoFLinearSystem::hasSymmetricCSRValues())
+   * and expands the matrix to the full CSR format for the other ones.
+   *
+   * This has to be called after initialize(), which resets the storage
+   * to the non symmetric mode.
+   */
+  void setSymmetric(bool v) { m_is_symmetric = v; }
+  bool isSymmetric() const { return m_is_symmetric; }
+
   /**
    * @brief
    *
@@ -95,6 +131,37 @@ class CsrFormat
    */
   void printMatrix(std::string fileName);
 
+  /*!
+   * \brief Compute y = A.x.
+   *
+   * \a x and \a y are indexed by the local ids of the DoFs. In symmetric
+   * mode, the lower triangular part is used through the transpose of the
+   * stored upper part.
+   */
+  void multiply(RunQueue& queue, Span<const Real> x, Span<Real> y);
+
+  /*!
+   * \brief Compute for each cell of \a cells the index in m_matrix_value of
+   * the values of the element matrix.
+   *
+   * The value (i,j) of the element matrix of the cell \a c, where \a i and
+   * \a j are the local indexes of the nodes in the cell, is added to
+   * m_matrix_value(m_cell_value_index(c, i * nb_node + j)). An index of
+   * (-1) means that the value is not added: the row is not an own DoF or,
+   * in symmetric mode, the value is in the lower triangular part.
+   *
+   * The structure of the matrix has to be computed before and it has to be
+   * the same for all the following assemblies. The indexes are invalidated
+   * by initialize().
+   */
+  void computeCellValueIndexes(CellGroup cells, IndexedNodeDoFConnectivityView node_dof);
+  bool hasCellValueIndexes() const { return m_has_cell_value_index; }
+  //! Number of values of the element matrix of each cell.
+  Int32 nbCellValue() const { return m_cell_value_index.extent1(); }
+
+  //! Set all the values to zero. The structure is kept.
+  void clearValues() { m_matrix_value.fill(0.0); }
+
   // Warning : does not support empty row (or does it ?)
   void setCoordinates(DoFLocalId row, DoFLocalId column)
   {
@@ -124,12 +191,29 @@ class CsrFormat
   //! Nombre de colonnes de chaque lignes.
   NumArray<Int32, MDDim1> m_matrix_rows_nb_column;
   IItemFamily* m_dof_family = nullptr;
+  bool m_is_symmetric = false;
+  //! Indexes of the values of the element matrices (see computeCellValueIndexes())
+  NumArray<Int32, MDDim2> m_cell_value_index;
 
   //! Return the Value at the (row, column) coordinates.
   Int32 getValue(DoFLocalId row, DoFLocalId column)
   {
     return m_matrix_value(indexValue(row, column));
   }
+
+ private:
+
+  // Full matrix built from the upper triangular part in symmetric mode
+  NumArray<Int32, MDDim1> m_full_matrix_row;
+  NumArray<Int32, MDDim1> m_full_matrix_rows_nb_column;
+  NumArray<Int32, MDDim1> m_full_matrix_column;
+  NumArray<Real, MDDim1> m_full_matrix_value;
+  bool m_has_cell_value_index = false;
+
+ private:
+
+  void _computeRowsNbColumn();
+  void _expandSymmetricMatrix();
 };
 
 } // namespace Arcane::FemUtils
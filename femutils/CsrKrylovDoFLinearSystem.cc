@@ -0,0 +1,810 @@
+﻿// -*- tab-width: 2; indent-tabs-mode: nil; coding: utf-8-with-signature -*-
+//-----------------------------------------------------------------------------
+// Copyright 2000-2024 CEA (www.cea.fr) IFPEN (www.ifpenergiesnouvelles.com)
+// See the top-level COPYRIGHT file for details.
+// SPDX-License-Identifier: Apache-2.0
+//-----------------------------------------------------------------------------
+/*---------------------------------------------------------------------------*/
+/* CsrKrylovDoFLinearSystem.cc                                 (C) 2022-2024 */
+/*                                                                           */
+/* Linear system solved with internal Krylov methods on a CSR matrix.        */
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
+#include "DoFLinearSystem.h"
+
+#include <arcane/utils/FatalErrorException.h>
+#include <arcane/utils/NumArray.h>
+#include <arcane/utils/PlatformUtils.h>
+#include <arcane/utils/ITraceMng.h>
+
+#include <arcane/core/VariableTypes.h>
+#include <arcane/core/IItemFamily.h>
+#include <arcane/core/ISubDomain.h>
+#include <arcane/core/IParallelMng.h>
+#include <arcane/core/Timer.h>
+#include <arcane/core/Concurrency.h>
+
+#include <arcane/accelerator/core/Runner.h>
+#include <arcane/accelerator/core/RunQueue.h>
+#include <arcane/accelerator/RunCommandLoop.h>
+#include <arcane/accelerator/VariableViews.h>
+#include <arcane/accelerator/NumArrayViews.h>
+#include <arcane/accelerator/Reduce.h>
+#include <arcane/accelerator/Atomic.h>
+
+#include "FemUtils.h"
+#include "IDoFLinearSystemFactory.h"
+
+namespace Arcane::FemUtils
+{
+enum class eCsrKrylovSolverMethod
+{
+  CG,
+  BiCGStab,
+};
+enum class eCsrKrylovPreconditioner
+{
+  None,
+  Jacobi,
+};
+} // namespace Arcane::FemUtils
+
+#include "CsrKrylovDoFLinearSystemFactory_axl.h"
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
+namespace Arcane::FemUtils
+{
+using namespace Arcane;
+namespace ax = Arcane::Accelerator;
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*!
+ * \brief Linear system solved with internal Krylov methods.
+ *
+ * The matrix is given in CSR format with setCSRValues(). Rows and columns
+ * of the CSR matrix are local ids of the DoFs. Only the rows of the own
+ * DoFs are used and the values of the ghost DoFs are synchronized before
+ * each matrix-vector product so this implementation works in parallel.
+ *
+ * The matrix may contain only its upper triangular part (see
+ * CSRFormatView::isSymmetric()). In this case all the rows are used by the
+ * matrix-vector product because the values of the lower part of an own row
+ * may be stored in the row of a ghost DoF.
+ *
+ * All the operations (matrix-vector product, dot products and vector
+ * updates) are done with RunQueue so they use the threads or the
+ * accelerator associated to the runner.
+ *
+ * In mixed precision mode, a copy of the matrix and of the preconditioner
+ * is stored in single precision and used by the Krylov iterations. An
+ * outer iterative refinement loop computes the residual with the double
+ * precision matrix and solves for a correction until the requested
+ * tolerance is reached.
+ */
+class CsrKrylovDoFLinearSystemImpl
+: public TraceAccessor
+, public DoFLinearSystemImpl
+{
+ public:
+
+  CsrKrylovDoFLinearSystemImpl(ISubDomain* sd, IItemFamily* dof_family, const String& solver_name)
+  : TraceAccessor(sd->traceMng())
+  , m_sub_domain(sd)
+  , m_dof_family(dof_family)
+  , m_rhs_variable(VariableBuildInfo(dof_family, solver_name + "RHSVariable"))
+  , m_dof_variable(VariableBuildInfo(dof_family, solver_name + "SolutionVariable"))
+  , m_r(VariableBuildInfo(dof_family, solver_name + "KrylovR"))
+  , m_r0(VariableBuildInfo(dof_family, solver_name + "KrylovR0"))
+  , m_z(VariableBuildInfo(dof_family, solver_name + "KrylovZ"))
+  , m_p(VariableBuildInfo(dof_family, solver_name + "KrylovP"))
+  , m_q(VariableBuildInfo(dof_family, solver_name + "KrylovQ"))
+  , m_s(VariableBuildInfo(dof_family, solver_name + "KrylovS"))
+  , m_t(VariableBuildInfo(dof_family, solver_name + "KrylovT"))
+  , m_refinement_r(VariableBuildInfo(dof_family, solver_name + "KrylovRefinementR"))
+  , m_correction(VariableBuildInfo(dof_family, solver_name + "KrylovCorrection"))
+  {
+    info() << "Creating CsrKrylovDoFLinearSystemImpl()";
+  }
+
+ public:
+
+  void matrixAddValue(DoFLocalId row, DoFLocalId column, Real value) override
+  {
+    ARCANE_THROW(NotImplementedException, "");
+  }
+
+  void matrixSetValue(DoFLocalId row, DoFLocalId column, Real value) override
+  {
+    ARCANE_THROW(NotImplementedException, "");
+  }
+
+  void eliminateRow(DoFLocalId row, Real value) override
+  {
+    ARCANE_THROW(NotImplementedException, "");
+  }
+
+  void eliminateRowColumn(DoFLocalId row, Real value) override
+  {
+    ARCANE_THROW(NotImplementedException, "");
+  }
+
+  void solve() override;
+
+  VariableDoFReal& solutionVariable() override
+  {
+    return m_dof_variable;
+  }
+
+  VariableDoFReal& rhsVariable() override
+  {
+    return m_rhs_variable;
+  }
+
+  void setSolverCommandLineArguments(const CommandLineArguments& args) override
+  {
+  }
+
+  void clearValues() override
+  {
+    info() << "Clear values";
+    m_csr_view = {};
+  }
+
+  void setCSRValues(const CSRFormatView& csr_view) override
+  {
+    m_csr_view = csr_view;
+  }
+  bool hasSetCSRValues() const override { return true; }
+  bool hasSymmetricCSRValues() const override { return true; }
+
+  void setRunner(Runner* r) override { m_runner = r; }
+  Runner* runner() const { return m_runner; }
+
+ public:
+
+  void setSolverMethod(eCsrKrylovSolverMethod v) { m_solver_method = v; }
+  void setPreconditioner(eCsrKrylovPreconditioner v) { m_preconditioner = v; }
+  void setEpsilon(Real v) { m_epsilon = v; }
+  void setMaxIteration(Int32 v) { m_max_iteration = v; }
+  void setMixedPrecision(bool v) { m_use_mixed_precision = v; }
+  void setInnerEpsilon(Real v) { m_inner_epsilon = v; }
+  void setMaxRefinement(Int32 v) { m_max_refinement = v; }
+
+ private:
+
+  ISubDomain* m_sub_domain = nullptr;
+  IItemFamily* m_dof_family = nullptr;
+  VariableDoFReal m_rhs_variable;
+  VariableDoFReal m_dof_variable;
+
+  // Work vectors of the Krylov methods. They are variables so that
+  // they can be synchronized before the matrix-vector products.
+  VariableDoFReal m_r;
+  VariableDoFReal m_r0;
+  VariableDoFReal m_z;
+  VariableDoFReal m_p;
+  VariableDoFReal m_q;
+  VariableDoFReal m_s;
+  VariableDoFReal m_t;
+  // Residual and correction of the iterative refinement
+  VariableDoFReal m_refinement_r;
+  VariableDoFReal m_correction;
+
+  //! Local ids of the own DoFs
+  NumArray<Int32, MDDim1> m_own_dofs;
+  //! Inverse of the diagonal of the matrix for the Jacobi preconditioner
+  NumArray<Real, MDDim1> m_inverse_diagonal;
+  //! Values of the matrix in single precision (mixed precision mode)
+  NumArray<float, MDDim1> m_float_values;
+  //! Inverse of the diagonal in single precision (mixed precision mode)
+  NumArray<float, MDDim1> m_float_inverse_diagonal;
+
+  CSRFormatView m_csr_view;
+  Runner* m_runner = nullptr;
+  //! Runner used if none is given with setRunner()
+  Runner m_default_runner;
+
+  eCsrKrylovSolverMethod m_solver_method = eCsrKrylovSolverMethod::CG;
+  eCsrKrylovPreconditioner m_preconditioner = eCsrKrylovPreconditioner::Jacobi;
+  Real m_epsilon = 1.0e-10;
+  Int32 m_max_iteration = 5000;
+  bool m_use_mixed_precision = false;
+  Real m_inner_epsilon = 1.0e-4;
+  Int32 m_max_refinement = 20;
+  //! True if the Krylov iterations use the single precision matrix
+  bool m_use_float_matrix = false;
+
+ private:
+
+  RunQueue _makeQueue();
+  void _computeOwnDoFs(RunQueue& queue);
+  void _computeInverseDiagonal(RunQueue& queue);
+  void _computeFloatMatrix(RunQueue& queue);
+  Int32 _solveKrylov(RunQueue& queue, VariableDoFReal& b, VariableDoFReal& x, Real epsilon, Real& residual_norm);
+  Int32 _solveCG(RunQueue& queue, VariableDoFReal& b, VariableDoFReal& x, Real epsilon, Real& residual_norm);
+  Int32 _solveBiCGStab(RunQueue& queue, VariableDoFReal& b, VariableDoFReal& x, Real epsilon, Real& residual_norm);
+  Int32 _solveMixedPrecision(RunQueue& queue, Int32& nb_refinement, Real& residual_norm);
+
+  void _multiply(RunQueue& queue, VariableDoFReal& x, VariableDoFReal& y);
+  template <typename DataType> void
+  _multiplyWithValues(RunQueue& queue, Span<const DataType> values, VariableDoFReal& x, VariableDoFReal& y);
+  template <typename DataType> void
+  _multiplySymmetricWithValues(RunQueue& queue, Span<const DataType> values, VariableDoFReal& x, VariableDoFReal& y);
+  void _applyPreconditioner(RunQueue& queue, VariableDoFReal& r, VariableDoFReal& z);
+  template <typename DataType> void
+  _applyJacobi(RunQueue& queue, NumArray<DataType, MDDim1>& inverse_diagonal, VariableDoFReal& r, VariableDoFReal& z);
+  Real _dot(RunQueue& queue, VariableDoFReal& x, VariableDoFReal& y);
+  void _axpby(RunQueue& queue, Real a, VariableDoFReal& x, Real b, VariableDoFReal& y);
+  void _copy(RunQueue& queue, VariableDoFReal& x, VariableDoFReal& y);
+};
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
+RunQueue CsrKrylovDoFLinearSystemImpl::
+_makeQueue()
+{
+  Runner* runner = m_runner;
+  if (!runner) {
+    if (!m_default_runner.isInitialized()) {
+      // Use the threads if the task mechanism is active.
+      auto policy = ax::eExecutionPolicy::Sequential;
+      if (TaskFactory::isActive())
+        policy = ax::eExecutionPolicy::Thread;
+      m_default_runner.initialize(policy);
+    }
+    runner = &m_default_runner;
+  }
+  return makeQueue(*runner);
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
+void CsrKrylovDoFLinearSystemImpl::
+_computeOwnDoFs(RunQueue& queue)
+{
+  DoFGroup own_dofs = m_dof_family->allItems().own();
+  const Int32 nb_own = own_dofs.size();
+  m_own_dofs.resize(nb_own);
+  ENUMERATE_ (DoF, idof, own_dofs) {
+    m_own_dofs[idof.index()] = idof.itemLocalId();
+  }
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
+void CsrKrylovDoFLinearSystemImpl::
+_computeInverseDiagonal(RunQueue& queue)
+{
+  const Int32 nb_dof = m_dof_family->maxLocalId();
+  m_inverse_diagonal.resize(nb_dof);
+  const Int32 nb_own = m_own_dofs.extent0();
+
+  Span<const Int32> rows = m_csr_view.rows();
+  Span<const Int32> rows_nb_column = m_csr_view.rowsNbColumn();
+  Span<const Int32> columns = m_csr_view.columns();
+  Span<const Real> values = m_csr_view.values();
+
+  auto command = makeCommand(queue);
+  auto in_own_dofs = ax::viewIn(command, m_own_dofs);
+  auto out_inverse_diagonal = ax::viewOut(command, m_inverse_diagonal);
+  command << RUNCOMMAND_LOOP1(iter, nb_own)
+  {
+    auto [k] = iter();
+    Int32 row = in_own_dofs(k);
+    Int32 begin = rows[row];
+    Int32 end = begin + rows_nb_column[row];
+    Real diagonal = 0.0;
+    for (Int32 j = begin; j < end; ++j)
+      if (columns[j] == row)
+        diagonal += values[j];
+    out_inverse_diagonal(row) = (diagonal != 0.0) ? (1.0 / diagonal) : 1.0;
+  };
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*!
+ * \brief Copy the matrix and the inverse of the diagonal in single precision.
+ */
+void CsrKrylovDoFLinearSystemImpl::
+_computeFloatMatrix(RunQueue& queue)
+{
+  Span<const Real> values = m_csr_view.values();
+  const Int32 nb_value = values.size();
+  m_float_values.resize(nb_value);
+  {
+    auto command = makeCommand(queue);
+    auto out_float_values = ax::viewOut(command, m_float_values);
+    command << RUNCOMMAND_LOOP1(iter, nb_value)
+    {
+      auto [i] = iter();
+      out_float_values(i) = static_cast<float>(values[i]);
+    };
+  }
+  if (m_preconditioner == eCsrKrylovPreconditioner::Jacobi) {
+    const Int32 nb_dof = m_inverse_diagonal.extent0();
+    m_float_inverse_diagonal.resize(nb_dof);
+    auto command = makeCommand(queue);
+    auto in_inverse_diagonal = ax::viewIn(command, m_inverse_diagonal);
+    auto out_float_inverse_diagonal = ax::viewOut(command, m_float_inverse_diagonal);
+    command << RUNCOMMAND_LOOP1(iter, nb_dof)
+    {
+      auto [i] = iter();
+      out_float_inverse_diagonal(i) = static_cast<float>(in_inverse_diagonal(i));
+    };
+  }
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*!
+ * \brief Compute y = A.x for the own rows.
+ *
+ * Use the single precision matrix if m_use_float_matrix is true.
+ */
+void CsrKrylovDoFLinearSystemImpl::
+_multiply(RunQueue& queue, VariableDoFReal& x, VariableDoFReal& y)
+{
+  if (m_use_float_matrix)
+    _multiplyWithValues<float>(queue, m_float_values.to1DSpan(), x, y);
+  else
+    _multiplyWithValues<Real>(queue, m_csr_view.values(), x, y);
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
+template <typename DataType> void CsrKrylovDoFLinearSystemImpl::
+_multiplyWithValues(RunQueue& queue, Span<const DataType> values, VariableDoFReal& x, VariableDoFReal& y)
+{
+  // The columns may reference ghost DoFs.
+  x.synchronize();
+
+  const Int32 nb_own = m_own_dofs.extent0();
+  Span<const Int32> rows = m_csr_view.rows();
+  Span<const Int32> rows_nb_column = m_csr_view.rowsNbColumn();
+  Span<const Int32> columns = m_csr_view.columns();
+
+  if (m_csr_view.isSymmetric()) {
+    _multiplySymmetricWithValues(queue, values, x, y);
+    return;
+  }
+
+  auto command = makeCommand(queue);
+  auto in_own_dofs = ax::viewIn(command, m_own_dofs);
+  auto in_x = ax::viewIn(command, x);
+  auto out_y = ax::viewOut(command, y);
+  command << RUNCOMMAND_LOOP1(iter, nb_own)
+  {
+    auto [k] = iter();
+    Int32 row = in_own_dofs(k);
+    Int32 begin = rows[row];
+    Int32 end = begin + rows_nb_column[row];
+    Real sum = 0.0;
+    for (Int32 j = begin; j < end; ++j) {
+      Int32 column = columns[j];
+      // Null columns are unused slots of the CSR matrix.
+      if (column >= 0)
+        sum += static_cast<Real>(values[j]) * in_x[DoFLocalId(column)];
+    }
+    out_y[DoFLocalId(row)] = sum;
+  };
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*!
+ * \brief Compute y = A.x when only the upper triangular part of A is stored.
+ *
+ * The value (row,column) is also used as the value (column,row) so the
+ * products are accumulated with atomic operations. Only the values of \a y
+ * for the own DoFs are valid.
+ */
+template <typename DataType> void CsrKrylovDoFLinearSystemImpl::
+_multiplySymmetricWithValues(RunQueue& queue, Span<const DataType> values, VariableDoFReal& x, VariableDoFReal& y)
+{
+  const Int32 nb_row = m_csr_view.rowsNbColumn().size();
+  Span<const Int32> rows = m_csr_view.rows();
+  Span<const Int32> rows_nb_column = m_csr_view.rowsNbColumn();
+  Span<const Int32> columns = m_csr_view.columns();
+  Span<Real> y_values(y.asArray());
+
+  {
+    auto command = makeCommand(queue);
+    command << RUNCOMMAND_LOOP1(iter, nb_row)
+    {
+      auto [row] = iter();
+      y_values[row] = 0.0;
+    };
+  }
+
+  auto command = makeCommand(queue);
+  auto in_x = ax::viewIn(command, x);
+  command << RUNCOMMAND_LOOP1(iter, nb_row)
+  {
+    auto [row] = iter();
+    Int32 begin = rows[row];
+    Int32 end = begin + rows_nb_column[row];
+    Real x_row = in_x[DoFLocalId(row)];
+    Real sum = 0.0;
+    for (Int32 j = begin; j < end; ++j) {
+      Int32 column = columns[j];
+      if (column < 0)
+        continue;
+      Real value = static_cast<Real>(values[j]);
+      sum += value * in_x[DoFLocalId(column)];
+      if (column != row)
+        ax::doAtomic<ax::eAtomicOperation::Add>(y_values[column], value * x_row);
+    }
+    ax::doAtomic<ax::eAtomicOperation::Add>(y_values[row], sum);
+  };
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
+void CsrKrylovDoFLinearSystemImpl::
+_applyPreconditioner(RunQueue& queue, VariableDoFReal& r, VariableDoFReal& z)
+{
+  if (m_preconditioner == eCsrKrylovPreconditioner::None) {
+    _copy(queue, r, z);
+    return;
+  }
+  if (m_use_float_matrix)
+    _applyJacobi(queue, m_float_inverse_diagonal, r, z);
+  else
+    _applyJacobi(queue, m_inverse_diagonal, r, z);
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
+template <typename DataType> void CsrKrylovDoFLinearSystemImpl::
+_applyJacobi(RunQueue& queue, NumArray<DataType, MDDim1>& inverse_diagonal, VariableDoFReal& r, VariableDoFReal& z)
+{
+  const Int32 nb_own = m_own_dofs.extent0();
+  auto command = makeCommand(queue);
+  auto in_own_dofs = ax::viewIn(command, m_own_dofs);
+  auto in_inverse_diagonal = ax::viewIn(command, inverse_diagonal);
+  auto in_r = ax::viewIn(command, r);
+  auto out_z = ax::viewOut(command, z);
+  command << RUNCOMMAND_LOOP1(iter, nb_own)
+  {
+    auto [k] = iter();
+    DoFLocalId dof(in_own_dofs(k));
+    out_z[dof] = static_cast<Real>(in_inverse_diagonal(dof.localId())) * in_r[dof];
+  };
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
+Real CsrKrylovDoFLinearSystemImpl::
+_dot(RunQueue& queue, VariableDoFReal& x, VariableDoFReal& y)
+{
+  const Int32 nb_own = m_own_dofs.extent0();
+  auto command = makeCommand(queue);
+  ax::ReducerSum<Real> reducer(command);
+  auto in_own_dofs = ax::viewIn(command, m_own_dofs);
+  auto in_x = ax::viewIn(command, x);
+  auto in_y = ax::viewIn(command, y);
+  command << RUNCOMMAND_LOOP1(iter, nb_own)
+  {
+    auto [k] = iter();
+    DoFLocalId dof(in_own_dofs(k));
+    reducer.add(in_x[dof] * in_y[dof]);
+  };
+  Real local_sum = reducer.reduce();
+  return m_dof_family->parallelMng()->reduce(Parallel::ReduceSum, local_sum);
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*!
+ * \brief Compute y = a.x + b.y for the own DoFs.
+ */
+void CsrKrylovDoFLinearSystemImpl::
+_axpby(RunQueue& queue, Real a, VariableDoFReal& x, Real b, VariableDoFReal& y)
+{
+  const Int32 nb_own = m_own_dofs.extent0();
+  auto command = makeCommand(queue);
+  auto in_own_dofs = ax::viewIn(command, m_own_dofs);
+  auto in_x = ax::viewIn(command, x);
+  auto inout_y = ax::viewInOut(command, y);
+  command << RUNCOMMAND_LOOP1(iter, nb_own)
+  {
+    auto [k] = iter();
+    DoFLocalId dof(in_own_dofs(k));
+    inout_y[dof] = a * in_x[dof] + b * inout_y[dof];
+  };
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
+void CsrKrylovDoFLinearSystemImpl::
+_copy(RunQueue& queue, VariableDoFReal& x, VariableDoFReal& y)
+{
+  _axpby(queue, 1.0, x, 0.0, y);
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
+void CsrKrylovDoFLinearSystemImpl::
+solve()
+{
+  ITimeStats* tstat = m_dof_family->parallelMng()->timeStats();
+  Timer::Action ta(tstat, "CsrKrylovLinearSystemSolve");
+
+  if (m_csr_view.rowsNbColumn().size() < m_dof_family->maxLocalId())
+    ARCANE_FATAL("Invalid CSR matrix: nb_row={0} nb_dof={1}. setCSRValues() has to be called before solve()",
+                 m_csr_view.rowsNbColumn().size(), m_dof_family->maxLocalId());
+
+  RunQueue queue = _makeQueue();
+  _computeOwnDoFs(queue);
+  if (m_preconditioner == eCsrKrylovPreconditioner::Jacobi)
+    _computeInverseDiagonal(queue);
+  if (m_use_mixed_precision)
+    _computeFloatMatrix(queue);
+
+  // Start with a null solution
+  m_dof_variable.fill(0.0);
+
+  Real t1 = platform::getRealTime();
+  Real residual_norm = 0.0;
+  Int32 nb_iteration = 0;
+  if (m_use_mixed_precision) {
+    Int32 nb_refinement = 0;
+    nb_iteration = _solveMixedPrecision(queue, nb_refinement, residual_norm);
+    info() << "[CsrKrylov] Mixed precision nb_refinement=" << nb_refinement;
+  }
+  else
+    nb_iteration = _solveKrylov(queue, m_rhs_variable, m_dof_variable, m_epsilon, residual_norm);
+  Real t2 = platform::getRealTime();
+
+  info() << "[CsrKrylov] End solve nb_iteration=" << nb_iteration
+         << " relative_residual=" << residual_norm << " time=" << (t2 - t1);
+  if (residual_norm > m_epsilon)
+    pwarning() << "[CsrKrylov] Solver has not converged after " << nb_iteration << " iterations"
+               << " relative_residual=" << residual_norm << " epsilon=" << m_epsilon;
+
+  m_dof_variable.synchronize();
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*!
+ * \brief Solve A.x = b with the selected Krylov method.
+ *
+ * \a x has to be null on input.
+ */
+Int32 CsrKrylovDoFLinearSystemImpl::
+_solveKrylov(RunQueue& queue, VariableDoFReal& b, VariableDoFReal& x, Real epsilon, Real& residual_norm)
+{
+  switch (m_solver_method) {
+  case eCsrKrylovSolverMethod::CG:
+    return _solveCG(queue, b, x, epsilon, residual_norm);
+  case eCsrKrylovSolverMethod::BiCGStab:
+    return _solveBiCGStab(queue, b, x, epsilon, residual_norm);
+  }
+  return 0;
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*!
+ * \brief Mixed precision solve with iterative refinement.
+ *
+ * The correction d of A.d = r is computed with the single precision matrix
+ * and a tolerance of m_inner_epsilon. The residual r = b - A.x is computed
+ * with the double precision matrix so the final tolerance is m_epsilon.
+ *
+ * Returns the total number of Krylov iterations.
+ */
+Int32 CsrKrylovDoFLinearSystemImpl::
+_solveMixedPrecision(RunQueue& queue, Int32& nb_refinement, Real& residual_norm)
+{
+  VariableDoFReal& x = m_dof_variable;
+  VariableDoFReal& b = m_rhs_variable;
+
+  Real b_norm = math::sqrt(_dot(queue, b, b));
+  nb_refinement = 0;
+  residual_norm = 0.0;
+  if (b_norm == 0.0)
+    return 0;
+
+  // x=0 so r = b
+  _copy(queue, b, m_refinement_r);
+  residual_norm = 1.0;
+  Int32 nb_iteration = 0;
+  for (; nb_refinement < m_max_refinement; ++nb_refinement) {
+    // Solve A.d = r in single precision.
+    m_use_float_matrix = true;
+    m_correction.fill(0.0);
+    Real inner_residual_norm = 0.0;
+    nb_iteration += _solveKrylov(queue, m_refinement_r, m_correction, m_inner_epsilon, inner_residual_norm);
+    m_use_float_matrix = false;
+
+    // x = x + d and r = b - A.x in double precision.
+    _axpby(queue, 1.0, m_correction, 1.0, x);
+    _multiply(queue, x, m_t);
+    _copy(queue, b, m_refinement_r);
+    _axpby(queue, -1.0, m_t, 1.0, m_refinement_r);
+    residual_norm = math::sqrt(_dot(queue, m_refinement_r, m_refinement_r)) / b_norm;
+    info(4) << "[CsrKrylov] Refinement step=" << nb_refinement << " inner_residual=" << inner_residual_norm
+            << " relative_residual=" << residual_norm;
+    if (residual_norm < m_epsilon) {
+      ++nb_refinement;
+      break;
+    }
+  }
+  return nb_iteration;
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*!
+ * \brief Preconditioned conjugate gradient.
+ *
+ * \a x has to be null on input. Returns the number of iterations and
+ * set \a residual_norm to the relative residual ||r||/||b||.
+ */
+Int32 CsrKrylovDoFLinearSystemImpl::
+_solveCG(RunQueue& queue, VariableDoFReal& b, VariableDoFReal& x, Real epsilon, Real& residual_norm)
+{
+  // x=0 so r = b
+  _copy(queue, b, m_r);
+  Real b_norm = math::sqrt(_dot(queue, b, b));
+  if (b_norm == 0.0) {
+    residual_norm = 0.0;
+    return 0;
+  }
+
+  _applyPreconditioner(queue, m_r, m_z);
+  _copy(queue, m_z, m_p);
+  Real rz = _dot(queue, m_r, m_z);
+  residual_norm = 1.0;
+
+  Int32 iteration = 0;
+  for (; iteration < m_max_iteration; ++iteration) {
+    _multiply(queue, m_p, m_q);
+    Real alpha = rz / _dot(queue, m_p, m_q);
+    _axpby(queue, alpha, m_p, 1.0, x);
+    _axpby(queue, -alpha, m_q, 1.0, m_r);
+    residual_norm = math::sqrt(_dot(queue, m_r, m_r)) / b_norm;
+    if (residual_norm < epsilon) {
+      ++iteration;
+      break;
+    }
+    _applyPreconditioner(queue, m_r, m_z);
+    Real new_rz = _dot(queue, m_r, m_z);
+    Real beta = new_rz / rz;
+    rz = new_rz;
+    // p = z + beta.p
+    _axpby(queue, 1.0, m_z, beta, m_p);
+  }
+  return iteration;
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*!
+ * \brief Right preconditioned BiCGStab.
+ *
+ * \a x has to be null on input. Returns the number of iterations and
+ * set \a residual_norm to the relative residual ||r||/||b||.
+ */
+Int32 CsrKrylovDoFLinearSystemImpl::
+_solveBiCGStab(RunQueue& queue, VariableDoFReal& b, VariableDoFReal& x, Real epsilon, Real& residual_norm)
+{
+  // x=0 so r = b
+  _copy(queue, b, m_r);
+  _copy(queue, b, m_r0);
+  Real b_norm = math::sqrt(_dot(queue, b, b));
+  if (b_norm == 0.0) {
+    residual_norm = 0.0;
+    return 0;
+  }
+
+  // 'm_q' is used for v = A.p_hat and 'm_z' for the preconditioned vectors.
+  Real rho = 1.0;
+  Real alpha = 1.0;
+  Real omega = 1.0;
+  m_p.fill(0.0);
+  m_q.fill(0.0);
+  residual_norm = 1.0;
+
+  Int32 iteration = 0;
+  for (; iteration < m_max_iteration; ++iteration) {
+    Real new_rho = _dot(queue, m_r0, m_r);
+    if (new_rho == 0.0)
+      ARCANE_FATAL("BiCGStab breakdown (rho==0) at iteration {0}", iteration);
+    Real beta = (new_rho / rho) * (alpha / omega);
+    rho = new_rho;
+    // p = r + beta.(p - omega.v)
+    _axpby(queue, -omega, m_q, 1.0, m_p);
+    _axpby(queue, 1.0, m_r, beta, m_p);
+    // v = A.M^-1.p
+    _applyPreconditioner(queue, m_p, m_z);
+    _multiply(queue, m_z, m_q);
+    alpha = rho / _dot(queue, m_r0, m_q);
+    // x = x + alpha.M^-1.p
+    _axpby(queue, alpha, m_z, 1.0, x);
+    // s = r - alpha.v
+    _copy(queue, m_r, m_s);
+    _axpby(queue, -alpha, m_q, 1.0, m_s);
+    Real s_norm = math::sqrt(_dot(queue, m_s, m_s)) / b_norm;
+    if (s_norm < epsilon) {
+      residual_norm = s_norm;
+      ++iteration;
+      break;
+    }
+    // t = A.M^-1.s
+    _applyPreconditioner(queue, m_s, m_z);
+    _multiply(queue, m_z, m_t);
+    omega = _dot(queue, m_t, m_s) / _dot(queue, m_t, m_t);
+    // x = x + omega.M^-1.s
+    _axpby(queue, omega, m_z, 1.0, x);
+    // r = s - omega.t
+    _copy(queue, m_s, m_r);
+    _axpby(queue, -omega, m_t, 1.0, m_r);
+    residual_norm = math::sqrt(_dot(queue, m_r, m_r)) / b_norm;
+    if (residual_norm < epsilon) {
+      ++iteration;
+      break;
+    }
+    if (omega == 0.0)
+      ARCANE_FATAL("BiCGStab breakdown (omega==0) at iteration {0}", iteration);
+  }
+  return iteration;
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
+class CsrKrylovDoFLinearSystemFactoryService
+: public ArcaneCsrKrylovDoFLinearSystemFactoryObject
+{
+ public:
+
+  explicit CsrKrylovDoFLinearSystemFactoryService(const ServiceBuildInfo& sbi)
+  : ArcaneCsrKrylovDoFLinearSystemFactoryObject(sbi)
+  {
+  }
+
+  DoFLinearSystemImpl*
+  createInstance(ISubDomain* sd, IItemFamily* dof_family, const String& solver_name) override
+  {
+    auto* x = new CsrKrylovDoFLinearSystemImpl(sd, dof_family, solver_name);
+    x->setSolverMethod(options()->solverMethod());
+    x->setPreconditioner(options()->preconditioner());
+    x->setEpsilon(options()->epsilon());
+    x->setMaxIteration(options()->maxIteration());
+    x->setMixedPrecision(options()->mixedPrecision());
+    x->setInnerEpsilon(options()->innerEpsilon());
+    x->setMaxRefinement(options()->maxRefinement());
+    return x;
+  }
+};
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
+ARCANE_REGISTER_SERVICE_CSRKRYLOVDOFLINEARSYSTEMFACTORY(CsrKrylovLinearSystem,
+                                                        CsrKrylovDoFLinearSystemFactoryService);
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
+} // namespace Arcane::FemUtils
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
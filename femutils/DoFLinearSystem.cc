@@ -53,10 +53,32 @@ createAlephDoFLinearSystemImpl(ISubDomain* sd, IItemFamily* dof_family, const St
 /*---------------------------------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
 
+/*!
+ * \brief Sequential linear system using an internal sparse matrix.
+ *
+ * Values are accumulated row by row in arrays of (column,value) sorted by
+ * column so memory usage is proportional to the number of non-zero values.
+ * Calls to matrixSetValue() and to the elimination methods are only applied
+ * at solving time so they are not overwritten by later calls to
+ * matrixAddValue().
+ */
 class SequentialDoFLinearSystemImpl
 : public TraceAccessor
 , public DoFLinearSystemImpl
 {
+  static constexpr Byte ELIMINATE_NONE = 0;
+  static constexpr Byte ELIMINATE_ROW = 1;
+  static constexpr Byte ELIMINATE_ROW_COLUMN = 2;
+
+  struct ColumnValue
+  {
+    Int32 column_id = 0;
+    Real value = 0.0;
+  };
+
+  //! Values of a row sorted by column index
+  using RowValues = UniqueArray<ColumnValue>;
+
  public:
 
   SequentialDoFLinearSystemImpl(ISubDomain* sd, IItemFamily* dof_family, const String& solver_name)
@@ -71,10 +93,11 @@ class SequentialDoFLinearSystemImpl
 
   void build()
   {
-    Int32 nb_node = m_dof_family->allItems().size();
-    m_k_matrix.resize(nb_node, nb_node);
-    m_k_matrix.fill(0.0);
-    m_rhs_vector.resize(nb_node);
+    Int32 nb_dof = m_dof_family->allItems().size();
+    m_rows_values.resize(nb_dof);
+    m_forced_rows_values.resize(nb_dof);
+    _clearMatrixValues();
+    m_rhs_vector.resize(nb_dof);
     m_rhs_vector.fill(0.0);
   }
 
@@ -82,35 +105,38 @@ class SequentialDoFLinearSystemImpl
 
   void matrixAddValue(DoFLocalId row, DoFLocalId column, Real value) override
   {
-    m_k_matrix(row, column) += value;
+    if (value == 0.0)
+      return;
+    _getOrAddValue(m_rows_values[row], column) += value;
   }
 
   void matrixSetValue(DoFLocalId row, DoFLocalId column, Real value) override
   {
-    // TODO: We should do the set() at the solving time because a following
-    // call to matrixAddValue() will override this value and this is not the
-    // wanted bahavior.
-    m_k_matrix(row, column) = value;
+    // The value is applied in solve() so that a following call
+    // to matrixAddValue() does not change it.
+    _getOrAddValue(m_forced_rows_values[row], column) = value;
   }
 
   void eliminateRow(DoFLocalId row, Real value) override
   {
-    ARCANE_THROW(NotImplementedException, "");
+    m_dof_elimination_info[row] = ELIMINATE_ROW;
+    m_dof_elimination_value[row] = value;
   }
 
   void eliminateRowColumn(DoFLocalId row, Real value) override
   {
-    ARCANE_THROW(NotImplementedException, "");
+    m_dof_elimination_info[row] = ELIMINATE_ROW_COLUMN;
+    m_dof_elimination_value[row] = value;
   }
 
   void solve() override
   {
     _fillRHSVector();
 
-    Int32 matrix_size = m_k_matrix.extent0();
+    Int32 matrix_size = m_rows_values.size();
     Arcane::MatVec::Matrix matrix(matrix_size, matrix_size);
-    _convertNumArrayToCSRMatrix(matrix, m_k_matrix.span());
-    bool is_verbose = true;
+    _fillMatrix(matrix);
+    bool is_verbose = matrix_size < 200;
     Arcane::MatVec::Vector vector_b(matrix_size);
     Arcane::MatVec::Vector vector_x(matrix_size);
     {
@@ -177,8 +203,10 @@ class SequentialDoFLinearSystemImpl
 
   void clearValues() override
   {
-    // TODO: not yet tested. We need to have test for this.
-    build();
+    // Only the values are cleared. The memory allocated for each row is kept
+    // so that the next assembly does not need to reallocate it.
+    _clearMatrixValues();
+    m_rhs_vector.fill(0.0);
   }
 
   void setCSRValues(const CSRFormatView& csr_view) override
@@ -201,7 +229,14 @@ class SequentialDoFLinearSystemImpl
   VariableDoFReal m_rhs_variable;
   VariableDoFReal m_dof_variable;
 
-  NumArray<Real, MDDim2> m_k_matrix;
+  //! Values added with matrixAddValue() for each row
+  UniqueArray<RowValues> m_rows_values;
+  //! Values set with matrixSetValue() for each row. They override added values.
+  UniqueArray<RowValues> m_forced_rows_values;
+  //! Elimination type for each DoF
+  UniqueArray<Byte> m_dof_elimination_info;
+  //! Value to impose for eliminated DoFs
+  UniqueArray<Real> m_dof_elimination_value;
   //! RHS (Right Hand Side) vector
   NumArray<Real, MDDim1> m_rhs_vector;
 
@@ -212,6 +247,101 @@ class SequentialDoFLinearSystemImpl
 
  private:
 
+  //! Return a reference to the value of \a column in \a row_values (added if needed)
+  static Real& _getOrAddValue(RowValues& row_values, Int32 column_id)
+  {
+    Int32 size = row_values.size();
+    // Rows are small so a binary search followed by a shift is fast enough.
+    Int32 pos = 0;
+    Int32 end = size;
+    while (pos < end) {
+      Int32 mid = (pos + end) / 2;
+      if (row_values[mid].column_id < column_id)
+        pos = mid + 1;
+      else
+        end = mid;
+    }
+    if (pos < size && row_values[pos].column_id == column_id)
+      return row_values[pos].value;
+    row_values.add(ColumnValue{});
+    for (Int32 i = size; i > pos; --i)
+      row_values[i] = row_values[i - 1];
+    row_values[pos] = ColumnValue{ column_id, 0.0 };
+    return row_values[pos].value;
+  }
+
+  void _clearMatrixValues()
+  {
+    for (RowValues& r : m_rows_values)
+      r.clear();
+    for (RowValues& r : m_forced_rows_values)
+      r.clear();
+    Int32 nb_dof = m_rows_values.size();
+    m_dof_elimination_info.resize(nb_dof);
+    m_dof_elimination_info.fill(ELIMINATE_NONE);
+    m_dof_elimination_value.resize(nb_dof);
+    m_dof_elimination_value.fill(0.0);
+  }
+
+  /*!
+   * \brief Fill \a out_matrix in CSR format.
+   *
+   * Forced values and eliminations are applied here. This may modify the RHS
+   * vector so _fillRHSVector() has to be called before.
+   */
+  void _fillMatrix(Arcane::MatVec::Matrix& out_matrix)
+  {
+    const Int32 nb_row = m_rows_values.size();
+
+    // Apply forced values
+    for (Int32 row = 0; row < nb_row; ++row) {
+      RowValues& row_values = m_rows_values[row];
+      for (const ColumnValue& cv : m_forced_rows_values[row])
+        _getOrAddValue(row_values, cv.column_id) = cv.value;
+    }
+
+    // For Row+Column elimination, substract the contribution of the
+    // eliminated columns to the RHS of the other rows.
+    for (Int32 row = 0; row < nb_row; ++row) {
+      if (m_dof_elimination_info[row] != ELIMINATE_NONE)
+        continue;
+      for (const ColumnValue& cv : m_rows_values[row]) {
+        Int32 column = cv.column_id;
+        if (m_dof_elimination_info[column] == ELIMINATE_ROW_COLUMN)
+          m_rhs_vector[row] -= cv.value * m_dof_elimination_value[column];
+      }
+    }
+
+    UniqueArray<Int32> nb_non_zero_in_row(nb_row);
+    UniqueArray<Int32> columns;
+    UniqueArray<Real> values;
+    for (Int32 row = 0; row < nb_row; ++row) {
+      Byte row_elimination_info = m_dof_elimination_info[row];
+      if (row_elimination_info != ELIMINATE_NONE) {
+        // Eliminated row: only keep the diagonal
+        m_rhs_vector[row] = m_dof_elimination_value[row];
+        columns.add(row);
+        values.add(1.0);
+        nb_non_zero_in_row[row] = 1;
+        continue;
+      }
+      Int32 nb_non_zero = 0;
+      for (const ColumnValue& cv : m_rows_values[row]) {
+        if (cv.value == 0.0)
+          continue;
+        if (m_dof_elimination_info[cv.column_id] == ELIMINATE_ROW_COLUMN)
+          continue;
+        columns.add(cv.column_id);
+        values.add(cv.value);
+        ++nb_non_zero;
+      }
+      nb_non_zero_in_row[row] = nb_non_zero;
+    }
+    info() << "Sequential matrix nb_row=" << nb_row << " nb_non_zero=" << columns.size();
+    out_matrix.setRowsSize(nb_non_zero_in_row);
+    out_matrix.setValues(columns, values);
+  }
+
   void _fillRHSVector()
   {
     // For the LinearSystem class we need an array
@@ -259,7 +389,7 @@ class DefaultDoFLinearSystemFactory
   {
     IParallelMng* pm = sd->parallelMng();
     bool is_parallel = pm->isParallel();
-    // If true, we use a dense debug matrix in sequential
+    // If true, we use the internal sequential matrix
     bool use_debug_dense_matrix = false;
 #ifdef ENABLE_DEBUG_MATRIX
     use_debug_dense_matrix = true;
@@ -442,6 +572,16 @@ hasSetCSRValues() const
 /*---------------------------------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
 
+bool DoFLinearSystem::
+hasSymmetricCSRValues() const
+{
+  _checkInit();
+  return m_p->hasSymmetricCSRValues();
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
 void DoFLinearSystem::
 reset()
 {
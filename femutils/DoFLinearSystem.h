@@ -53,12 +53,23 @@ class CSRFormatView
   Span<const Int32> columns() const { return m_matrix_columns; }
   Span<const Real> values() const { return m_values; }
 
+  /*!
+   * \brief Indicate if only the upper triangular part (column >= row) is stored.
+   *
+   * In this case the lower triangular part is the transpose of the upper one.
+   * This view can only be given to a linear system for which
+   * hasSymmetricCSRValues() is true.
+   */
+  bool isSymmetric() const { return m_is_symmetric; }
+  void setSymmetric(bool v) { m_is_symmetric = v; }
+
  private:
 
   Span<const Int32> m_matrix_rows;
   Span<const Int32> m_matrix_rows_nb_column;
   Span<const Int32> m_matrix_columns;
   Span<const Real> m_values;
+  bool m_is_symmetric = false;
 };
 
 /*---------------------------------------------------------------------------*/
@@ -86,6 +97,7 @@ class DoFLinearSystemImpl
   virtual void clearValues() = 0;
   virtual void setCSRValues(const CSRFormatView& csr_view) = 0;
   virtual bool hasSetCSRValues() const = 0;
+  virtual bool hasSymmetricCSRValues() const { return false; }
   virtual void setRunner(Runner* r) =0;
   virtual Runner* runner() const =0;
 };
@@ -241,6 +253,9 @@ class DoFLinearSystem
   //! Indique si l'implémentation supporte d'utiliser setCSRValue()
   bool hasSetCSRValues() const;
 
+  //! Indicate if setCSRValues() accepts a view with only the upper triangular part
+  bool hasSymmetricCSRValues() const;
+
  public:
 
   IDoFLinearSystemFactory* linearSystemFactory() const
@@ -0,0 +1,180 @@
+﻿// -*- tab-width: 2; indent-tabs-mode: nil; coding: utf-8-with-signature -*-
+//-----------------------------------------------------------------------------
+// Copyright 2000-2024 CEA (www.cea.fr) IFPEN (www.ifpenergiesnouvelles.com)
+// See the top-level COPYRIGHT file for details.
+// SPDX-License-Identifier: Apache-2.0
+//-----------------------------------------------------------------------------
+/*---------------------------------------------------------------------------*/
+/* FemGeometryCache.cc                                         (C) 2022-2024 */
+/*                                                                           */
+/* Cache of the geometric factors of P1 elements.                            */
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
+#include "FemGeometryCache.h"
+
+#include <arcane/utils/FatalErrorException.h>
+#include <arcane/utils/MathUtils.h>
+
+#include <arcane/IMesh.h>
+#include <arcane/IItemFamily.h>
+#include <arcane/core/UnstructuredMeshConnectivity.h>
+
+#include <arcane/accelerator/RunCommandEnumerate.h>
+#include <arcane/accelerator/NumArrayViews.h>
+#include <arcane/accelerator/VariableViews.h>
+
+namespace Arcane::FemUtils
+{
+namespace ax = Arcane::Accelerator;
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
+void FemGeometryCache::
+computeCellGeometry(CellGroup cells, const VariableNodeReal3& node_coord, RunQueue& queue)
+{
+  IMesh* mesh = cells.mesh();
+  const Int32 dimension = mesh->dimension();
+  const Int16 cell_type = (dimension == 2) ? IT_Triangle3 : IT_Tetraedron4;
+  ENUMERATE_ (Cell, icell, cells) {
+    if (icell->type() != cell_type)
+      ARCANE_FATAL("Only Triangle3 cells in 2D and Tetraedron4 cells in 3D are supported (cell={0} type={1})",
+                   icell->uniqueId(), icell->type());
+  }
+
+  const Int32 nb_cell = mesh->cellFamily()->maxLocalId();
+  m_cell_measure.resize(nb_cell);
+  m_cell_gradient_x.resize(nb_cell, MaxNbNodePerCell);
+  m_cell_gradient_y.resize(nb_cell, MaxNbNodePerCell);
+  m_cell_gradient_z.resize(nb_cell, MaxNbNodePerCell);
+  m_cell_gradient_z.fill(0.0);
+
+  UnstructuredMeshConnectivityView connectivity_view;
+  connectivity_view.setMesh(mesh);
+  auto cnc = connectivity_view.cellNode();
+
+  auto command = makeCommand(queue);
+  auto in_node_coord = ax::viewIn(command, node_coord);
+  auto out_measure = ax::viewOut(command, m_cell_measure);
+  auto out_gradient_x = ax::viewOut(command, m_cell_gradient_x);
+  auto out_gradient_y = ax::viewOut(command, m_cell_gradient_y);
+  auto out_gradient_z = ax::viewInOut(command, m_cell_gradient_z);
+
+  command << RUNCOMMAND_ENUMERATE(Cell, cell, cells)
+  {
+    Int32 lid = cell.localId();
+    Real3 m0 = in_node_coord[cnc.nodeId(cell, 0)];
+    Real3 m1 = in_node_coord[cnc.nodeId(cell, 1)];
+    Real3 m2 = in_node_coord[cnc.nodeId(cell, 2)];
+
+    if (dimension == 2) {
+      Real area = 0.5 * ((m1.x - m0.x) * (m2.y - m0.y) - (m2.x - m0.x) * (m1.y - m0.y));
+      Real factor = 0.5 / area;
+      out_measure(lid) = area;
+      out_gradient_x(lid, 0) = (m1.y - m2.y) * factor;
+      out_gradient_y(lid, 0) = (m2.x - m1.x) * factor;
+      out_gradient_x(lid, 1) = (m2.y - m0.y) * factor;
+      out_gradient_y(lid, 1) = (m0.x - m2.x) * factor;
+      out_gradient_x(lid, 2) = (m0.y - m1.y) * factor;
+      out_gradient_y(lid, 2) = (m1.x - m0.x) * factor;
+      out_gradient_x(lid, 3) = 0.0;
+      out_gradient_y(lid, 3) = 0.0;
+    }
+    else {
+      Real3 m3 = in_node_coord[cnc.nodeId(cell, 3)];
+      Real3 d1 = m1 - m0;
+      Real3 d2 = m2 - m0;
+      Real3 d3 = m3 - m0;
+      // Gradients of the barycentric coordinates: the rows of the inverse
+      // of the Jacobian [d1 d2 d3]
+      Real3 g1 = math::cross(d2, d3);
+      Real3 g2 = math::cross(d3, d1);
+      Real3 g3 = math::cross(d1, d2);
+      Real det = math::dot(d1, g1);
+      Real factor = 1.0 / det;
+      g1 *= factor;
+      g2 *= factor;
+      g3 *= factor;
+      Real3 g0 = -(g1 + g2 + g3);
+      out_measure(lid) = math::abs(det) / 6.0;
+      out_gradient_x(lid, 0) = g0.x;
+      out_gradient_y(lid, 0) = g0.y;
+      out_gradient_z(lid, 0) = g0.z;
+      out_gradient_x(lid, 1) = g1.x;
+      out_gradient_y(lid, 1) = g1.y;
+      out_gradient_z(lid, 1) = g1.z;
+      out_gradient_x(lid, 2) = g2.x;
+      out_gradient_y(lid, 2) = g2.y;
+      out_gradient_z(lid, 2) = g2.z;
+      out_gradient_x(lid, 3) = g3.x;
+      out_gradient_y(lid, 3) = g3.y;
+      out_gradient_z(lid, 3) = g3.z;
+    }
+  };
+
+  m_has_cell_geometry = true;
+  info() << "FemGeometryCache: computed geometry for " << cells.size() << " cells";
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*!
+ * The orientation of the normal depends on Face::isSubDomainBoundaryOutside()
+ * which is not available on accelerator. As this is done only once, the
+ * computation is done on the host.
+ */
+void FemGeometryCache::
+computeFaceGeometry(FaceGroup faces, const VariableNodeReal3& node_coord)
+{
+  IMesh* mesh = faces.mesh();
+  const Int32 dimension = mesh->dimension();
+
+  const Int32 nb_face = mesh->faceFamily()->maxLocalId();
+  m_face_measure.resize(nb_face);
+  m_face_normal_x.resize(nb_face);
+  m_face_normal_y.resize(nb_face);
+  m_face_normal_z.resize(nb_face);
+
+  ENUMERATE_ (Face, iface, faces) {
+    Face face = *iface;
+    Int32 lid = face.localId();
+    Real3 m0 = node_coord[face.nodeId(0)];
+    Real3 m1 = node_coord[face.nodeId(1)];
+    if (!face.isSubDomainBoundaryOutside())
+      std::swap(m0, m1);
+
+    Real measure = 0.0;
+    Real3 normal;
+    if (dimension == 2) {
+      if (face.type() != IT_Line2)
+        ARCANE_FATAL("Only Line2 faces are supported in 2D (face={0})", face.uniqueId());
+      measure = math::sqrt((m1.x - m0.x) * (m1.x - m0.x) + (m1.y - m0.y) * (m1.y - m0.y));
+      normal = Real3((m1.y - m0.y) / measure, (m0.x - m1.x) / measure, 0.0);
+    }
+    else {
+      if (face.type() != IT_Triangle3)
+        ARCANE_FATAL("Only Triangle3 faces are supported in 3D (face={0})", face.uniqueId());
+      Real3 m2 = node_coord[face.nodeId(2)];
+      Real3 n = math::cross(m1 - m0, m2 - m0);
+      Real norm = n.normL2();
+      measure = 0.5 * norm;
+      normal = n / norm;
+    }
+    m_face_measure(lid) = measure;
+    m_face_normal_x(lid) = normal.x;
+    m_face_normal_y(lid) = normal.y;
+    m_face_normal_z(lid) = normal.z;
+  }
+
+  m_has_face_geometry = true;
+  info() << "FemGeometryCache: computed geometry for " << faces.size() << " faces";
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
+} // namespace Arcane::FemUtils
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
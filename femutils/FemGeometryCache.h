@@ -0,0 +1,129 @@
+﻿// -*- tab-width: 2; indent-tabs-mode: nil; coding: utf-8-with-signature -*-
+//-----------------------------------------------------------------------------
+// Copyright 2000-2024 CEA (www.cea.fr) IFPEN (www.ifpenergiesnouvelles.com)
+// See the top-level COPYRIGHT file for details.
+// SPDX-License-Identifier: Apache-2.0
+//-----------------------------------------------------------------------------
+/*---------------------------------------------------------------------------*/
+/* FemGeometryCache.h                                          (C) 2022-2024 */
+/*                                                                           */
+/* Cache of the geometric factors of P1 elements.                            */
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+#ifndef ARCANEFEM_FEMUTILS_FEMGEOMETRYCACHE_H
+#define ARCANEFEM_FEMUTILS_FEMGEOMETRYCACHE_H
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
+#include <arcane/utils/NumArray.h>
+#include <arcane/utils/TraceAccessor.h>
+#include <arcane/utils/Real3.h>
+
+#include <arcane/VariableTypes.h>
+#include <arcane/ItemGroup.h>
+
+#include <arcane/accelerator/core/RunQueue.h>
+
+namespace Arcane::FemUtils
+{
+using namespace Arcane;
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*!
+ * \brief Cache of the geometric factors of P1 elements.
+ *
+ * For a mesh which does not move, the measure of the cells and the gradients
+ * of the shape functions are constant and can be computed only once. The
+ * supported cells are Triangle3 in 2D and Tetraedron4 in 3D. The supported
+ * faces are Line2 in 2D and Triangle3 in 3D.
+ *
+ * The values are stored in structure of arrays indexed by the local id of
+ * the item so they can be read on the host or with a view on accelerator:
+ * - m_cell_measure(c) is the area (or the volume) of the cell \a c. For
+ *   Triangle3, it is the signed area.
+ * - m_cell_gradient_x(c, i) (and _y, _z) is the gradient of the shape
+ *   function of the \a i-th node of the cell \a c.
+ * - m_face_measure(f) is the length (or the area) of the face \a f.
+ * - m_face_normal_x(f) (and _y, _z) is the outward unit normal of the face \a f.
+ *
+ * Usage:
+ * \code
+ * FemGeometryCache geometry(traceMng());
+ * geometry.computeCellGeometry(allCells(), m_node_coord, *queue);
+ * geometry.computeFaceGeometry(outerFaces(), m_node_coord);
+ * ...
+ * Real area = geometry.cellMeasure(cell);
+ * Real3 dphi0 = geometry.cellGradient(cell, 0);
+ * \endcode
+ */
+class FemGeometryCache
+: public TraceAccessor
+{
+ public:
+
+  explicit FemGeometryCache(ITraceMng* tm)
+  : TraceAccessor(tm)
+  {
+  }
+
+ public:
+
+  //! Compute the measure and the gradients of the shape functions for the cells of \a cells
+  void computeCellGeometry(CellGroup cells, const VariableNodeReal3& node_coord, RunQueue& queue);
+
+  /*!
+   * \brief Compute the measure and the outward normal for the faces of \a faces.
+   *
+   * The normal is oriented outside of the sub-domain for the faces at
+   * the boundary of the sub-domain.
+   */
+  void computeFaceGeometry(FaceGroup faces, const VariableNodeReal3& node_coord);
+
+  bool hasCellGeometry() const { return m_has_cell_geometry; }
+  bool hasFaceGeometry() const { return m_has_face_geometry; }
+
+  Real cellMeasure(CellLocalId cell) const { return m_cell_measure(cell.localId()); }
+  Real3 cellGradient(CellLocalId cell, Int32 node_index) const
+  {
+    Int32 lid = cell.localId();
+    return Real3(m_cell_gradient_x(lid, node_index), m_cell_gradient_y(lid, node_index), m_cell_gradient_z(lid, node_index));
+  }
+
+  Real faceMeasure(FaceLocalId face) const { return m_face_measure(face.localId()); }
+  Real3 faceNormal(FaceLocalId face) const
+  {
+    Int32 lid = face.localId();
+    return Real3(m_face_normal_x(lid), m_face_normal_y(lid), m_face_normal_z(lid));
+  }
+
+ public:
+
+  //! Maximum number of nodes of a supported cell
+  static constexpr Int32 MaxNbNodePerCell = 4;
+
+  NumArray<Real, MDDim1> m_cell_measure;
+  NumArray<Real, MDDim2> m_cell_gradient_x;
+  NumArray<Real, MDDim2> m_cell_gradient_y;
+  NumArray<Real, MDDim2> m_cell_gradient_z;
+
+  NumArray<Real, MDDim1> m_face_measure;
+  NumArray<Real, MDDim1> m_face_normal_x;
+  NumArray<Real, MDDim1> m_face_normal_y;
+  NumArray<Real, MDDim1> m_face_normal_z;
+
+ private:
+
+  bool m_has_cell_geometry = false;
+  bool m_has_face_geometry = false;
+};
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
+} // namespace Arcane::FemUtils
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
+#endif
@@ -20,7 +20,11 @@
 #include <arcane/IParallelMng.h>
 #include <arcane/VariableTypes.h>
 #include <arcane/IItemFamily.h>
+#include <arcane/IVariable.h>
+#include <arcane/IVariableSynchronizer.h>
 #include <map>
+#include <algorithm>
+#include <fstream>
 
 /*---------------------------------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
@@ -167,6 +171,70 @@ namespace
     if (nb_error > 0)
       ARCANE_FATAL("Error checking values nb_error={0}", nb_error);
   }
+
+  inline void
+  _addValues(Array<Real>& values, Real v)
+  {
+    values.add(v);
+  }
+  inline void
+  _addValues(Array<Real>& values, Real2 v)
+  {
+    values.add(v.x);
+    values.add(v.y);
+  }
+  inline void
+  _addValues(Array<Real>& values, Real3 v)
+  {
+    values.add(v.x);
+    values.add(v.y);
+    values.add(v.z);
+  }
+
+  template <typename VariableType> inline void
+  _writeNodeResultFile(ITraceMng* tm, const String& filename,
+                       const VariableType& node_values, Int32 nb_component)
+  {
+    ARCANE_CHECK_POINTER(tm);
+    tm->info() << "WriteNodeResultFile filename=" << filename;
+    if (filename.empty())
+      ARCANE_FATAL("Invalid empty filename");
+    IItemFamily* node_family = node_values.variable()->itemFamily();
+    if (!node_family)
+      ARCANE_FATAL("Variable '{0}' is not allocated", node_values.name());
+    IParallelMng* pm = node_family->parallelMng();
+
+    UniqueArray<Int64> uids;
+    UniqueArray<Real> values;
+    ENUMERATE_ (Node, inode, node_family->allItems().own()) {
+      Node node = *inode;
+      uids.add(node.uniqueId());
+      _addValues(values, node_values[node]);
+    }
+
+    UniqueArray<Int64> all_uids;
+    UniqueArray<Real> all_values;
+    pm->allGatherVariable(uids, all_uids);
+    pm->allGatherVariable(values, all_values);
+    if (!pm->isMasterIO())
+      return;
+
+    UniqueArray<Int32> order(all_uids.size());
+    for (Int32 i = 0; i < order.size(); ++i)
+      order[i] = i;
+    std::sort(order.begin(), order.end(), [&](Int32 a, Int32 b) { return all_uids[a] < all_uids[b]; });
+
+    std::ofstream ofile(filename.localstr());
+    ofile.precision(17);
+    for (Int32 i : order) {
+      ofile << all_uids[i];
+      for (Int32 c = 0; c < nb_component; ++c)
+        ofile << " " << all_values[i * nb_component + c];
+      ofile << "\n";
+    }
+    if (!ofile)
+      ARCANE_FATAL("Error during writing of file '{0}'", filename);
+  }
 } // namespace
 
 /*---------------------------------------------------------------------------*/
@@ -259,6 +327,52 @@ void checkNodeResultFile(ITraceMng* tm, const String& filename,
 /*---------------------------------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
 
+void writeNodeResultFile(ITraceMng* tm, const String& filename,
+                         const VariableNodeReal& node_values)
+{
+  _writeNodeResultFile(tm, filename, node_values, 1);
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
+void writeNodeResultFile(ITraceMng* tm, const String& filename,
+                         const VariableNodeReal2& node_values)
+{
+  _writeNodeResultFile(tm, filename, node_values, 2);
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
+void writeNodeResultFile(ITraceMng* tm, const String& filename,
+                         const VariableNodeReal3& node_values)
+{
+  _writeNodeResultFile(tm, filename, node_values, 3);
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
+void synchronizeVariables(const VariableCollection& variables)
+{
+  if (variables.empty())
+    return;
+
+  IItemFamily* family = variables.front()->itemFamily();
+  if (!family)
+    ARCANE_FATAL("Variable '{0}' is not defined on an item family", variables.front()->name());
+  for (VariableCollection::Enumerator ivar(variables); ++ivar;) {
+    IVariable* var = *ivar;
+    if (var->itemFamily() != family)
+      ARCANE_FATAL("Variable '{0}' is not defined on the family '{1}'", var->name(), family->name());
+  }
+  family->allItemsSynchronizer()->synchronize(variables);
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
 }
 
 /*---------------------------------------------------------------------------*/
@@ -18,9 +18,11 @@
 #include <arcane/utils/MDSpan.h>
 #include <arcane/matvec/Matrix.h>
 #include <arcane/VariableTypedef.h>
+#include <arcane/VariableCollection.h>
 #include <arcane/Parallel.h>
 #include <arcane/IIOMng.h>
 #include <arcane/CaseTable.h>
+#include <arcane/IndexedItemConnectivityView.h>
 
 #include <array>
 
@@ -144,6 +146,31 @@ matrixTranspose(const FixedMatrix<N, M>& a)
   return t_matrix;
 }
 
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*!
+ * \brief Check if the node \a node_index of the cell \a cell_index of
+ * the node \a node is the first occurrence of this node.
+ *
+ * Used to enumerate only once the neighbours of \a node when computing the
+ * structure of a matrix.
+ */
+inline ARCCORE_HOST_DEVICE bool
+isFirstNodeNeighbour(NodeLocalId node, Int32 cell_index, Int32 node_index,
+                     IndexedNodeCellConnectivityView nc, IndexedCellNodeConnectivityView cnc)
+{
+  CellLocalId cell = nc.cellId(node, cell_index);
+  NodeLocalId neighbour = cnc.nodeId(cell, node_index);
+  for (Int32 c = 0; c <= cell_index; ++c) {
+    CellLocalId previous_cell = nc.cellId(node, c);
+    Int32 nb_node = (c == cell_index) ? node_index : cnc.nbNode(previous_cell);
+    for (Int32 n = 0; n < nb_node; ++n)
+      if (cnc.nodeId(previous_cell, n) == neighbour)
+        return false;
+  }
+  return true;
+}
+
 /*---------------------------------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
 /*!
@@ -213,6 +240,30 @@ checkNodeResultFile(ITraceMng* tm, const String& filename,
                     const VariableNodeReal3& node_values, double epsilon,
                     double min_value = 0.0);
 
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*!
+ * \brief Write the values of the variable in a reference file.
+ *
+ * The file \a filename is written by the master IO rank in the format read
+ * by checkNodeResultFile(): one line per node with the unique id followed by
+ * the value(s) of \a node_values, sorted by unique id. This method is
+ * collective.
+ */
+extern "C++" void
+writeNodeResultFile(ITraceMng* tm, const String& filename,
+                    const VariableNodeReal& node_values);
+
+//! Write the values of the variable in a reference file.
+extern "C++" void
+writeNodeResultFile(ITraceMng* tm, const String& filename,
+                    const VariableNodeReal2& node_values);
+
+//! Write the values of the variable in a reference file.
+extern "C++" void
+writeNodeResultFile(ITraceMng* tm, const String& filename,
+                    const VariableNodeReal3& node_values);
+
 /*---------------------------------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
 /*!
@@ -227,6 +278,34 @@ readFileAsCaseTable(IParallelMng* pm, const String& filename, const Int32& ndim)
 /*---------------------------------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
 
+/*!
+ * \brief Synchronize several variables at once.
+ *
+ * All the variables have to be defined on the same item family. The values
+ * of all the variables are sent in a single message per neighbour
+ * sub-domain instead of one message per variable.
+ */
+extern "C++" void
+synchronizeVariables(const VariableCollection& variables);
+
+/*!
+ * \brief Synchronize several variables of the same item family at once.
+ *
+ * \code
+ * synchronizeVariables(m_dU, m_U, m_V, m_A);
+ * \endcode
+ */
+template <typename... VariableType> void
+synchronizeVariables(VariableType&... variables)
+{
+  VariableList variable_list;
+  (variable_list.add(variables.variable()), ...);
+  synchronizeVariables(variable_list);
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
 } // namespace Arcane::FemUtils
 
 /*---------------------------------------------------------------------------*/
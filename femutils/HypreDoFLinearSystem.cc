@@ -1,6 +1,6 @@
 ﻿// -*- tab-width: 2; indent-tabs-mode: nil; coding: utf-8-with-signature -*-
 //-----------------------------------------------------------------------------
-// Copyright 2000-2023 CEA (www.cea.fr) IFPEN (www.ifpenergiesnouvelles.com)
+// Copyright 2000-2024 CEA (www.cea.fr) IFPEN (www.ifpenergiesnouvelles.com)
 // See the top-level COPYRIGHT file for details.
 // SPDX-License-Identifier: Apache-2.0
 //-----------------------------------------------------------------------------
@@ -20,6 +20,7 @@
 
 #include <arcane/core/VariableTypes.h>
 #include <arcane/core/IItemFamily.h>
+#include <arcane/core/IMesh.h>
 #include <arcane/core/BasicService.h>
 #include <arcane/core/ServiceFactory.h>
 #include <arcane/core/IParallelMng.h>
@@ -31,6 +32,27 @@
 #include "FemUtils.h"
 #include "IDoFLinearSystemFactory.h"
 
+namespace Arcane::FemUtils
+{
+enum class eHypreSolverMethod
+{
+  PCG,
+  GMRES,
+  BiCGStab,
+};
+
+//! Set of default parameters for a kind of physics
+enum class eHyprePreset
+{
+  //! Historical parameters (PCG + BoomerAMG with Falgout coarsening)
+  Default,
+  //! Scalar problems (poisson, heat, laplace, fourier)
+  Scalar,
+  //! Vector problems with several DoFs per node (elasticity, elastodynamics, soildynamics, bilaplacian)
+  Vector,
+};
+} // namespace Arcane::FemUtils
+
 #include "HypreDoFLinearSystemFactory_axl.h"
 
 #include <HYPRE.h>
@@ -77,6 +99,34 @@ namespace
   }
 } // namespace
 
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*!
+ * \brief Parameters for the Hypre Krylov solver and the BoomerAMG preconditioner.
+ */
+struct HypreSolverParameters
+{
+  eHypreSolverMethod solver_method = eHypreSolverMethod::PCG;
+  Real tolerance = 1.0e-7;
+  Int32 max_iteration = 1000;
+  //! Size of the Krylov space for GMRES
+  Int32 krylov_dim = 30;
+  Int32 print_level = 2;
+  //! BoomerAMG coarsening (6: Falgout, 8: PMIS, 10: HMIS)
+  Int32 amg_coarsen_type = 6;
+  //! BoomerAMG interpolation (0: classical, 6: extended+i)
+  Int32 amg_interp_type = 0;
+  //! BoomerAMG smoother (6: hybrid symmetric Gauss-Seidel, 8: l1-Gauss-Seidel, 18: l1-Jacobi)
+  Int32 amg_relax_type = 6;
+  Int32 amg_num_sweeps = 1;
+  Real amg_strong_threshold = 0.25;
+  Int32 amg_agg_num_levels = 0;
+  //! Number of functions (i.e. DoFs per node) for systems AMG (0 to use the number of DoFs per node)
+  Int32 amg_num_functions = 1;
+  //! Nodal coarsening for systems AMG (0 means unknown-based coarsening)
+  Int32 amg_nodal = 0;
+};
+
 /*---------------------------------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
 
@@ -101,6 +151,8 @@ class HypreDoFLinearSystemImpl
 
   ~HypreDoFLinearSystemImpl()
   {
+    _destroySolver();
+    _destroyMatrix();
     info() << "Calling HYPRE_Finalize";
 #if HYPRE_RELEASE_NUMBER >= 21500
     HYPRE_Finalize(); /* must be the last HYPRE function call */
@@ -156,6 +208,8 @@ class HypreDoFLinearSystemImpl
 
   void clearValues()
   {
+    // Hypre objects are kept and will be reused if the structure
+    // of the matrix is the same in the next solve.
     info() << "Clear values";
     m_csr_view = {};
   }
@@ -169,6 +223,12 @@ class HypreDoFLinearSystemImpl
   void setRunner(Runner* r) override { m_runner = r; }
   Runner* runner() const { return m_runner; }
 
+ public:
+
+  void setAmgReuseCount(Int32 v) { m_amg_reuse_count = v; }
+  void setAmgReuseIterationRatio(Real v) { m_amg_reuse_iteration_ratio = v; }
+  void setSolverParameters(const HypreSolverParameters& v) { m_parameters = v; }
+
  private:
 
   IItemFamily* m_dof_family = nullptr;
@@ -187,10 +247,52 @@ class HypreDoFLinearSystemImpl
   CSRFormatView m_csr_view;
   Int32 m_first_own_row = -1;
   Int32 m_nb_own_row = -1;
+  //! Unique ids and owners of the DoFs (in local id order) when the numbering has been computed
+  UniqueArray<Int64> m_numbering_dof_uids;
+  UniqueArray<Int32> m_numbering_dof_owners;
+
+  //! Structure of the matrix used to create 'm_ij_A'
+  UniqueArray<Int32> m_saved_rows_nb_column;
+  UniqueArray<Int32> m_saved_columns;
+
+  HYPRE_IJMatrix m_ij_A = nullptr;
+  HYPRE_ParCSRMatrix m_parcsr_A = nullptr;
+  HYPRE_Solver m_solver = nullptr;
+  HYPRE_Solver m_precond = nullptr;
+
+  //! Number of solves the AMG preconditioner can be reused (0 to rebuild it at each solve)
+  Int32 m_amg_reuse_count = 0;
+  //! Rebuild the preconditioner if the number of iterations grows more than this ratio
+  Real m_amg_reuse_iteration_ratio = 2.0;
+  bool m_need_precond_setup = true;
+  Int32 m_nb_solve_since_precond_setup = 0;
+  Int32 m_nb_iteration_after_precond_setup = 0;
+
+  HypreSolverParameters m_parameters;
+  //! Number of functions used by BoomerAMG
+  Int32 m_amg_num_functions = 1;
 
  private:
 
   void _computeMatrixNumerotation();
+  bool _isSameNumbering() const;
+  void _computeColumnsIndex(bool is_parallel);
+  bool _isSameStructure() const;
+  void _createSolver(MPI_Comm mpi_comm);
+  void _createPreconditioner();
+  void _checkDoFFunctions();
+  Int32 _computeNbDoFPerNode();
+  void _setupSolver(HYPRE_ParVector b, HYPRE_ParVector x);
+  void _solve(HYPRE_ParVector b, HYPRE_ParVector x);
+  Int32 _nbIteration();
+  void _destroySolver();
+  void _destroyMatrix();
+
+  //! Setup function for the preconditioner when it is reused.
+  static HYPRE_Int _noPrecondSetup(HYPRE_Solver, HYPRE_ParCSRMatrix, HYPRE_ParVector, HYPRE_ParVector)
+  {
+    return 0;
+  }
 };
 
 /*---------------------------------------------------------------------------*/
@@ -235,6 +337,39 @@ _computeMatrixNumerotation()
 
   m_parallel_rows_index.resize(nb_own_row);
   m_result_work_values.resize(nb_own_row);
+
+  m_numbering_dof_uids.clear();
+  m_numbering_dof_owners.clear();
+  ENUMERATE_DOF (idof, all_dofs) {
+    DoF dof = *idof;
+    m_numbering_dof_uids.add(dof.uniqueId());
+    m_numbering_dof_owners.add(dof.owner());
+  }
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*!
+ * \brief Indicate if the DoFs are the same than when the numbering has been
+ * computed.
+ *
+ * The number of DoFs is not enough: the DoFs may have been renumbered or
+ * their owners may have changed (for example after a load balance) while
+ * keeping the same number of items.
+ */
+bool HypreDoFLinearSystemImpl::
+_isSameNumbering() const
+{
+  DoFGroup all_dofs = m_dof_family->allItems();
+  if (all_dofs.size() != m_numbering_dof_uids.size())
+    return false;
+  ENUMERATE_DOF (idof, all_dofs) {
+    DoF dof = *idof;
+    const Int32 index = idof.index();
+    if (m_numbering_dof_uids[index] != dof.uniqueId() || m_numbering_dof_owners[index] != dof.owner())
+      return false;
+  }
+  return true;
 }
 
 /*---------------------------------------------------------------------------*/
@@ -260,8 +395,16 @@ solve()
   const Int32 nb_rank = pm->commSize();
   const Int32 my_rank = pm->commRank();
 
-  // TODO: A ne faire qu'un fois sauf si les DoFs évoluent
-  _computeMatrixNumerotation();
+  // La numérotation n'est recalculée que si les DoFs évoluent.
+  // The decision has to be the same on all the ranks because the numbering is collective.
+  Int32 need_numbering = (_isSameNumbering()) ? 0 : 1;
+  if (is_parallel)
+    need_numbering = pm->reduce(Parallel::ReduceMax, need_numbering);
+  if (need_numbering != 0) {
+    _computeMatrixNumerotation();
+    // The structure of the matrix has to be recomputed
+    _destroyMatrix();
+  }
 
   bool is_use_device = false;
   if (m_runner) {
@@ -303,9 +446,6 @@ solve()
 
   /* setup IJ matrix A */
 
-  HYPRE_IJMatrix ij_A = nullptr;
-  HYPRE_ParCSRMatrix parcsr_A = nullptr;
-
   const bool do_debug_print = false;
   const bool do_dump_matrix = false;
 
@@ -323,38 +463,36 @@ solve()
   const int first_row = m_first_own_row;
   const int last_row = m_first_own_row + m_nb_own_row - 1;
 
-  info() << "CreateMatrix first_row=" << first_row << " last_row " << last_row;
-  HYPRE_IJMatrixCreate(mpi_comm, first_row, last_row, first_row, last_row, &ij_A);
+  // If the structure of the matrix has not changed since the previous
+  // solve, the Hypre matrix and the columns translation are reused and
+  // only the values are updated.
+  const bool is_same_structure = (m_ij_A && _isSameStructure());
+  if (!is_same_structure) {
+    _destroyMatrix();
+    info() << "CreateMatrix first_row=" << first_row << " last_row " << last_row;
+    hypreCheck("HYPRE_IJMatrixCreate",
+               HYPRE_IJMatrixCreate(mpi_comm, first_row, last_row, first_row, last_row, &m_ij_A));
+    HYPRE_IJMatrixSetObjectType(m_ij_A, HYPRE_PARCSR);
+#if HYPRE_RELEASE_NUMBER >= 22700
+    HYPRE_IJMatrixInitialize_v2(m_ij_A, hypre_memory);
+#else
+    HYPRE_IJMatrixInitialize(m_ij_A);
+#endif
+    _computeColumnsIndex(is_parallel);
+    // A new matrix needs a new preconditioner.
+    m_need_precond_setup = true;
+  }
+  else
+    info() << "Reusing Hypre matrix structure";
 
   int* rows_nb_column_data = const_cast<int*>(m_csr_view.rowsNbColumn().data());
 
   Real m1 = platform::getRealTime();
-  HYPRE_IJMatrixSetObjectType(ij_A, HYPRE_PARCSR);
-#if HYPRE_RELEASE_NUMBER >= 22700
-  HYPRE_IJMatrixInitialize_v2(ij_A, hypre_memory);
-#else
-  HYPRE_IJMatrixInitialize(ij_A);
-#endif
   // m_csr_view.columns() use matrix coordinates local to sub-domain
-  // We need to translate them to global matrix coordinates
+  // and have been translated to global matrix coordinates in _computeColumnsIndex().
   Span<const Int32> columns_index_span = m_csr_view.columns();
-  if (is_parallel) {
-    // TODO: Faire sur accélérateur et ne faire qu'une fois si la structure
-    // ne change pas.
-    Int64 nb_column = columns_index_span.size();
-    m_parallel_columns_index.resize(nb_column);
-    for (Int64 i = 0; i < nb_column; ++i) {
-      DoFLocalId lid(columns_index_span[i]);
-      //info() << "I=" << i << " index=" << columns_index_span[i];
-      // Si lid correspond à une entité nulle, alors la valeur de la matrice
-      // ne sera pas utilisée.
-      if (!lid.isNull())
-        m_parallel_columns_index[i] = m_dof_matrix_numbering[lid];
-      else
-        m_parallel_columns_index[i] = 0;
-    }
+  if (is_parallel)
     columns_index_span = m_parallel_columns_index.to1DSpan();
-  }
 
   if (do_debug_print) {
     info() << "FINAL_COLUMNS=" << columns_index_span;
@@ -383,39 +521,28 @@ solve()
     }
   }
 
-  if (is_parallel) {
-    // Fill 'm_parallel_rows_index' with only rows we owns
-    // NOTE: This is only needed if matrix structure has changed.
-    Int32 index = 0;
-    ENUMERATE_ (DoF, idof, m_dof_family->allItems()) {
-      DoF dof = *idof;
-      if (!dof.isOwn())
-        continue;
-      Int32 nb_col = m_csr_view.rowsNbColumn()[idof.index()];
-      m_parallel_rows_index[index] = rows_index_span[idof.index()];
-      ++index;
-    }
-  }
-
   {
     Timer::Action ta1(tstat, "HypreLinearSystemBuildMatrix");
+    // When the matrix is already assembled, Hypre updates the existing
+    // entries in place so there is no new allocation.
     /* GPU pointers; efficient in large chunks */
-    HYPRE_IJMatrixSetValues(ij_A,
-                            nb_local_row,
-                            rows_nb_column_data,
-                            rows_index_span.data(),
-                            columns_index_span.data(),
-                            matrix_values.data());
-
-    HYPRE_IJMatrixAssemble(ij_A);
-    HYPRE_IJMatrixGetObject(ij_A, (void**)&parcsr_A);
+    hypreCheck("HYPRE_IJMatrixSetValues",
+               HYPRE_IJMatrixSetValues(m_ij_A,
+                                       nb_local_row,
+                                       rows_nb_column_data,
+                                       rows_index_span.data(),
+                                       columns_index_span.data(),
+                                       matrix_values.data()));
+
+    hypreCheck("HYPRE_IJMatrixAssemble", HYPRE_IJMatrixAssemble(m_ij_A));
+    HYPRE_IJMatrixGetObject(m_ij_A, (void**)&m_parcsr_A);
     Real m2 = platform::getRealTime();
-    info() << "Time to create matrix=" << (m2 - m1);
+    info() << "Time to create matrix=" << (m2 - m1) << " reuse_structure=" << is_same_structure;
   }
 
   if (do_dump_matrix) {
     String file_name = String("dumpA.") + String::fromNumber(my_rank) + ".txt";
-    HYPRE_IJMatrixPrint(ij_A, file_name.localstr());
+    HYPRE_IJMatrixPrint(m_ij_A, file_name.localstr());
     pm->traceMng()->flush();
     pm->barrier();
   }
@@ -469,48 +596,41 @@ solve()
     pm->barrier();
   }
 
-  HYPRE_Solver solver = nullptr;
-  HYPRE_Solver precond = nullptr;
-  {
-    Timer::Action ta1(tstat, "HypreSetPrecond");
-    /* setup AMG */
-    HYPRE_ParCSRPCGCreate(mpi_comm, &solver);
-
-    /* Set some parameters (See Reference Manual for more parameters) */
-    HYPRE_PCGSetMaxIter(solver, 1000); /* max iterations */
-    HYPRE_PCGSetTol(solver, 1e-7); /* conv. tolerance */
-    HYPRE_PCGSetTwoNorm(solver, 1); /* use the two norm as the stopping criteria */
-    HYPRE_PCGSetPrintLevel(solver, 2); /* print solve info */
-    HYPRE_PCGSetLogging(solver, 1); /* needed to get run info later */
-
-    hypreCheck("HYPRE_BoomerAMGCreate", HYPRE_BoomerAMGCreate(&precond));
-
-    HYPRE_BoomerAMGCreate(&precond);
-    HYPRE_BoomerAMGSetPrintLevel(precond, 1); /* print amg solution info */
-    HYPRE_BoomerAMGSetCoarsenType(precond, 6);
-    HYPRE_BoomerAMGSetOldDefault(precond);
-    HYPRE_BoomerAMGSetRelaxType(precond, 6); /* Sym G.S./Jacobi hybrid */
-    HYPRE_BoomerAMGSetNumSweeps(precond, 1);
-    HYPRE_BoomerAMGSetTol(precond, 0.0); /* conv. tolerance zero */
-    HYPRE_BoomerAMGSetMaxIter(precond, 1); /* do only one iteration! */
+  // Check if we can keep the preconditioner of the previous solve
+  if (m_amg_reuse_count <= 0 || m_nb_solve_since_precond_setup >= m_amg_reuse_count)
+    m_need_precond_setup = true;
 
-    hypreCheck("HYPRE_ParCSRPCGSetPrecond",
-               HYPRE_ParCSRPCGSetPrecond(solver, HYPRE_BoomerAMGSolve, HYPRE_BoomerAMGSetup, precond));
+  if (!m_solver) {
+    Timer::Action ta1(tstat, "HypreSetPrecond");
+    _createSolver(mpi_comm);
+    m_need_precond_setup = true;
   }
+
   Real a1 = platform::getRealTime();
   {
     Timer::Action ta1(tstat, "HypreSetup");
-    hypreCheck("HYPRE_PCGSetup",
-               HYPRE_ParCSRPCGSetup(solver, parcsr_A, parvector_b, parvector_x));
+    _setupSolver(parvector_b, parvector_x);
   }
+  Real a2 = platform::getRealTime();
 
   {
     Timer::Action ta1(tstat, "HypreLinearSystemSolve");
-    hypreCheck("HYPRE_PCGSolve",
-               HYPRE_ParCSRPCGSolve(solver, parcsr_A, parvector_b, parvector_x));
+    _solve(parvector_b, parvector_x);
   }
   Real b1 = platform::getRealTime();
-  info() << "Time to setup and solve=" << (b1 - a1);
+  Int32 nb_iteration = _nbIteration();
+  info() << "Time to setup=" << (a2 - a1) << " solve=" << (b1 - a2) << " nb_iteration=" << nb_iteration;
+
+  if (m_need_precond_setup) {
+    m_need_precond_setup = false;
+    m_nb_solve_since_precond_setup = 0;
+    m_nb_iteration_after_precond_setup = nb_iteration;
+  }
+  ++m_nb_solve_since_precond_setup;
+  // Rebuild the preconditioner if the number of iterations has
+  // increased too much compared to the solve which has built it.
+  if (nb_iteration > m_amg_reuse_iteration_ratio * m_nb_iteration_after_precond_setup)
+    m_need_precond_setup = true;
 
   if (is_parallel) {
     Int32 nb_wanted_row = m_parallel_rows_index.extent0();
@@ -527,6 +647,310 @@ solve()
                HYPRE_IJVectorGetValues(ij_vector_x, nb_local_row, rows_index_span.data(),
                                        m_dof_variable.asArray().data()));
   }
+
+  HYPRE_IJVectorDestroy(ij_vector_b);
+  HYPRE_IJVectorDestroy(ij_vector_x);
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
+void HypreDoFLinearSystemImpl::
+_createSolver(MPI_Comm mpi_comm)
+{
+  const HypreSolverParameters& p = m_parameters;
+  info() << "Create Hypre solver method=" << (int)p.solver_method
+         << " tolerance=" << p.tolerance << " max_iteration=" << p.max_iteration;
+
+  /* Set some parameters (See Reference Manual for more parameters) */
+  switch (p.solver_method) {
+  case eHypreSolverMethod::PCG:
+    hypreCheck("HYPRE_ParCSRPCGCreate", HYPRE_ParCSRPCGCreate(mpi_comm, &m_solver));
+    HYPRE_PCGSetMaxIter(m_solver, p.max_iteration); /* max iterations */
+    HYPRE_PCGSetTol(m_solver, p.tolerance); /* conv. tolerance */
+    HYPRE_PCGSetTwoNorm(m_solver, 1); /* use the two norm as the stopping criteria */
+    HYPRE_PCGSetPrintLevel(m_solver, p.print_level); /* print solve info */
+    HYPRE_PCGSetLogging(m_solver, 1); /* needed to get run info later */
+    break;
+  case eHypreSolverMethod::GMRES:
+    hypreCheck("HYPRE_ParCSRGMRESCreate", HYPRE_ParCSRGMRESCreate(mpi_comm, &m_solver));
+    HYPRE_GMRESSetKDim(m_solver, p.krylov_dim);
+    HYPRE_GMRESSetMaxIter(m_solver, p.max_iteration);
+    HYPRE_GMRESSetTol(m_solver, p.tolerance);
+    HYPRE_GMRESSetPrintLevel(m_solver, p.print_level);
+    HYPRE_GMRESSetLogging(m_solver, 1);
+    break;
+  case eHypreSolverMethod::BiCGStab:
+    hypreCheck("HYPRE_ParCSRBiCGSTABCreate", HYPRE_ParCSRBiCGSTABCreate(mpi_comm, &m_solver));
+    HYPRE_BiCGSTABSetMaxIter(m_solver, p.max_iteration);
+    HYPRE_BiCGSTABSetTol(m_solver, p.tolerance);
+    HYPRE_BiCGSTABSetPrintLevel(m_solver, p.print_level);
+    HYPRE_BiCGSTABSetLogging(m_solver, 1);
+    break;
+  }
+
+  _createPreconditioner();
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
+void HypreDoFLinearSystemImpl::
+_createPreconditioner()
+{
+  const HypreSolverParameters& p = m_parameters;
+  m_amg_num_functions = (p.amg_num_functions > 0) ? p.amg_num_functions : _computeNbDoFPerNode();
+  info() << "Create BoomerAMG coarsen_type=" << p.amg_coarsen_type
+         << " interp_type=" << p.amg_interp_type << " relax_type=" << p.amg_relax_type
+         << " strong_threshold=" << p.amg_strong_threshold
+         << " num_functions=" << m_amg_num_functions << " nodal=" << p.amg_nodal;
+
+  hypreCheck("HYPRE_BoomerAMGCreate", HYPRE_BoomerAMGCreate(&m_precond));
+
+  // NOTE: SetOldDefault() changes the coarsening and the interpolation
+  // so it has to be called before setting them.
+  HYPRE_BoomerAMGSetOldDefault(m_precond);
+  HYPRE_BoomerAMGSetPrintLevel(m_precond, 1); /* print amg solution info */
+  HYPRE_BoomerAMGSetCoarsenType(m_precond, p.amg_coarsen_type);
+  HYPRE_BoomerAMGSetInterpType(m_precond, p.amg_interp_type);
+  HYPRE_BoomerAMGSetRelaxType(m_precond, p.amg_relax_type);
+  HYPRE_BoomerAMGSetNumSweeps(m_precond, p.amg_num_sweeps);
+  HYPRE_BoomerAMGSetStrongThreshold(m_precond, p.amg_strong_threshold);
+  HYPRE_BoomerAMGSetAggNumLevels(m_precond, p.amg_agg_num_levels);
+  HYPRE_BoomerAMGSetTol(m_precond, 0.0); /* conv. tolerance zero */
+  HYPRE_BoomerAMGSetMaxIter(m_precond, 1); /* do only one iteration! */
+
+  if (m_amg_num_functions > 1) {
+    // Systems AMG. Hypre assumes the unknowns are interleaved
+    // (function of a row is 'row % num_functions') if no DoF function map is given.
+    _checkDoFFunctions();
+    HYPRE_BoomerAMGSetNumFunctions(m_precond, m_amg_num_functions);
+    if (p.amg_nodal > 0)
+      HYPRE_BoomerAMGSetNodal(m_precond, p.amg_nodal);
+  }
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*!
+ * \brief Vérifie que les DoFs sont numérotés par noeud.
+ *
+ * FemDoFsOnNodes crée les DoFs d'un noeud avec les uniqueId()
+ * node_uid * nb_dof_per_node + i. La fonction d'un DoF est donc
+ * uniqueId() % nb_dof_per_node et elle doit correspondre à la fonction
+ * implicite utilisée par Hypre pour la ligne de la matrice.
+ */
+void HypreDoFLinearSystemImpl::
+_checkDoFFunctions()
+{
+  const Int32 nb_function = m_amg_num_functions;
+  if ((m_first_own_row % nb_function) != 0)
+    ARCANE_FATAL("Invalid first row '{0}' for systems AMG with '{1}' functions", m_first_own_row, nb_function);
+  ENUMERATE_ (DoF, idof, m_dof_family->allItems().own()) {
+    Int32 dof_function = static_cast<Int32>((*idof).uniqueId().asInt64() % nb_function);
+    Int32 row_function = idof.index() % nb_function;
+    if (dof_function != row_function)
+      ARCANE_FATAL("DoF uid={0} is not compatible with systems AMG (function={1} row_function={2})."
+                   " DoFs have to be created with FemDoFsOnNodes",
+                   (*idof).uniqueId(), dof_function, row_function);
+  }
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*!
+ * \brief Calcule le nombre de DoFs par noeud du maillage.
+ *
+ * Used by the 'vector' preset so that the number of functions of systems AMG
+ * is 2 or 3 depending on the problem. The number of own DoFs has to be a
+ * multiple of the number of own nodes.
+ */
+Int32 HypreDoFLinearSystemImpl::
+_computeNbDoFPerNode()
+{
+  IParallelMng* pm = m_dof_family->parallelMng();
+  Int64 nb_dof = pm->reduce(Parallel::ReduceSum, Int64(m_dof_family->allItems().own().size()));
+  Int64 nb_node = pm->reduce(Parallel::ReduceSum, Int64(m_dof_family->mesh()->ownNodes().size()));
+  if (nb_node == 0 || nb_dof == 0 || (nb_dof % nb_node) != 0)
+    ARCANE_FATAL("Can not compute the number of DoFs per node (nb_dof={0} nb_node={1})."
+                 " Use option 'amg-num-functions'",
+                 nb_dof, nb_node);
+  return static_cast<Int32>(nb_dof / nb_node);
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
+void HypreDoFLinearSystemImpl::
+_setupSolver(HYPRE_ParVector b, HYPRE_ParVector x)
+{
+  // If the preconditioner is kept, use a setup function which does nothing
+  // so that only the Krylov solver is set up.
+  HYPRE_PtrToParSolverFcn precond_setup = HYPRE_BoomerAMGSetup;
+  if (!m_need_precond_setup) {
+    precond_setup = _noPrecondSetup;
+    info() << "Reusing Hypre AMG preconditioner nb_solve_since_setup=" << m_nb_solve_since_precond_setup;
+  }
+  switch (m_parameters.solver_method) {
+  case eHypreSolverMethod::PCG:
+    hypreCheck("HYPRE_ParCSRPCGSetPrecond",
+               HYPRE_ParCSRPCGSetPrecond(m_solver, HYPRE_BoomerAMGSolve, precond_setup, m_precond));
+    hypreCheck("HYPRE_PCGSetup",
+               HYPRE_ParCSRPCGSetup(m_solver, m_parcsr_A, b, x));
+    break;
+  case eHypreSolverMethod::GMRES:
+    hypreCheck("HYPRE_ParCSRGMRESSetPrecond",
+               HYPRE_ParCSRGMRESSetPrecond(m_solver, HYPRE_BoomerAMGSolve, precond_setup, m_precond));
+    hypreCheck("HYPRE_GMRESSetup",
+               HYPRE_ParCSRGMRESSetup(m_solver, m_parcsr_A, b, x));
+    break;
+  case eHypreSolverMethod::BiCGStab:
+    hypreCheck("HYPRE_ParCSRBiCGSTABSetPrecond",
+               HYPRE_ParCSRBiCGSTABSetPrecond(m_solver, HYPRE_BoomerAMGSolve, precond_setup, m_precond));
+    hypreCheck("HYPRE_BiCGSTABSetup",
+               HYPRE_ParCSRBiCGSTABSetup(m_solver, m_parcsr_A, b, x));
+    break;
+  }
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
+void HypreDoFLinearSystemImpl::
+_solve(HYPRE_ParVector b, HYPRE_ParVector x)
+{
+  switch (m_parameters.solver_method) {
+  case eHypreSolverMethod::PCG:
+    hypreCheck("HYPRE_PCGSolve", HYPRE_ParCSRPCGSolve(m_solver, m_parcsr_A, b, x));
+    break;
+  case eHypreSolverMethod::GMRES:
+    hypreCheck("HYPRE_GMRESSolve", HYPRE_ParCSRGMRESSolve(m_solver, m_parcsr_A, b, x));
+    break;
+  case eHypreSolverMethod::BiCGStab:
+    hypreCheck("HYPRE_BiCGSTABSolve", HYPRE_ParCSRBiCGSTABSolve(m_solver, m_parcsr_A, b, x));
+    break;
+  }
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
+Int32 HypreDoFLinearSystemImpl::
+_nbIteration()
+{
+  HYPRE_Int nb_iteration = 0;
+  switch (m_parameters.solver_method) {
+  case eHypreSolverMethod::PCG:
+    HYPRE_PCGGetNumIterations(m_solver, &nb_iteration);
+    break;
+  case eHypreSolverMethod::GMRES:
+    HYPRE_GMRESGetNumIterations(m_solver, &nb_iteration);
+    break;
+  case eHypreSolverMethod::BiCGStab:
+    HYPRE_BiCGSTABGetNumIterations(m_solver, &nb_iteration);
+    break;
+  }
+  return nb_iteration;
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
+void HypreDoFLinearSystemImpl::
+_destroySolver()
+{
+  if (m_solver) {
+    switch (m_parameters.solver_method) {
+    case eHypreSolverMethod::PCG:
+      HYPRE_ParCSRPCGDestroy(m_solver);
+      break;
+    case eHypreSolverMethod::GMRES:
+      HYPRE_ParCSRGMRESDestroy(m_solver);
+      break;
+    case eHypreSolverMethod::BiCGStab:
+      HYPRE_ParCSRBiCGSTABDestroy(m_solver);
+      break;
+    }
+  }
+  if (m_precond)
+    HYPRE_BoomerAMGDestroy(m_precond);
+  m_solver = nullptr;
+  m_precond = nullptr;
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
+void HypreDoFLinearSystemImpl::
+_destroyMatrix()
+{
+  if (m_ij_A)
+    HYPRE_IJMatrixDestroy(m_ij_A);
+  m_ij_A = nullptr;
+  m_parcsr_A = nullptr;
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*!
+ * \brief Indique si la structure de la matrice est la même qu'au solve précédent.
+ */
+bool HypreDoFLinearSystemImpl::
+_isSameStructure() const
+{
+  Span<const Int32> rows_nb_column = m_csr_view.rowsNbColumn();
+  Span<const Int32> columns = m_csr_view.columns();
+  if (rows_nb_column.size() != m_saved_rows_nb_column.size())
+    return false;
+  if (columns.size() != m_saved_columns.size())
+    return false;
+  for (Int64 i = 0, n = rows_nb_column.size(); i < n; ++i)
+    if (rows_nb_column[i] != m_saved_rows_nb_column[i])
+      return false;
+  for (Int64 i = 0, n = columns.size(); i < n; ++i)
+    if (columns[i] != m_saved_columns[i])
+      return false;
+  return true;
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*!
+ * \brief Calcule la numérotation globale des colonnes et sauve la structure.
+ */
+void HypreDoFLinearSystemImpl::
+_computeColumnsIndex(bool is_parallel)
+{
+  Span<const Int32> columns_index_span = m_csr_view.columns();
+  m_saved_rows_nb_column.copy(m_csr_view.rowsNbColumn());
+  m_saved_columns.copy(columns_index_span);
+
+  if (is_parallel) {
+    // TODO: Faire sur accélérateur
+    Int64 nb_column = columns_index_span.size();
+    m_parallel_columns_index.resize(nb_column);
+    for (Int64 i = 0; i < nb_column; ++i) {
+      DoFLocalId lid(columns_index_span[i]);
+      //info() << "I=" << i << " index=" << columns_index_span[i];
+      // Si lid correspond à une entité nulle, alors la valeur de la matrice
+      // ne sera pas utilisée.
+      if (!lid.isNull())
+        m_parallel_columns_index[i] = m_dof_matrix_numbering[lid];
+      else
+        m_parallel_columns_index[i] = 0;
+    }
+
+    // Fill 'm_parallel_rows_index' with only rows we owns
+    Span<const Int32> rows_index_span = m_dof_matrix_numbering.asArray();
+    Int32 index = 0;
+    ENUMERATE_ (DoF, idof, m_dof_family->allItems()) {
+      DoF dof = *idof;
+      if (!dof.isOwn())
+        continue;
+      m_parallel_rows_index[index] = rows_index_span[idof.index()];
+      ++index;
+    }
+  }
 }
 
 /*---------------------------------------------------------------------------*/
@@ -548,8 +972,65 @@ class HypreDoFLinearSystemFactoryService
   {
     auto* x = new HypreDoFLinearSystemImpl(dof_family, solver_name);
     x->build();
+    x->setAmgReuseCount(options()->amgReuseCount());
+    x->setAmgReuseIterationRatio(options()->amgReuseIterationRatio());
+    x->setSolverParameters(_buildParameters());
     return x;
   }
+
+ private:
+
+  HypreSolverParameters _buildParameters()
+  {
+    HypreSolverParameters p;
+
+    // Values of the preset. They may be overridden by the options.
+    switch (options()->preset()) {
+    case eHyprePreset::Default:
+      break;
+    case eHyprePreset::Scalar:
+      p.amg_coarsen_type = 10; // HMIS
+      p.amg_interp_type = 6; // extended+i
+      p.amg_relax_type = 8; // l1-Gauss-Seidel
+      p.amg_strong_threshold = 0.25;
+      break;
+    case eHyprePreset::Vector:
+      p.amg_coarsen_type = 10; // HMIS
+      p.amg_interp_type = 6; // extended+i
+      p.amg_relax_type = 8; // l1-Gauss-Seidel
+      p.amg_strong_threshold = 0.5;
+      p.amg_num_functions = 0; // number of DoFs per node
+      p.amg_nodal = 4; // row-sum norm of the nodal blocks
+      break;
+    }
+
+    p.solver_method = options()->solverMethod();
+    p.krylov_dim = options()->krylovDim();
+    p.print_level = options()->printLevel();
+    if (options()->tolerance.isPresent())
+      p.tolerance = options()->tolerance();
+    if (options()->maxIteration.isPresent())
+      p.max_iteration = options()->maxIteration();
+    if (options()->amgCoarsenType.isPresent())
+      p.amg_coarsen_type = options()->amgCoarsenType();
+    if (options()->amgInterpType.isPresent())
+      p.amg_interp_type = options()->amgInterpType();
+    if (options()->amgRelaxType.isPresent())
+      p.amg_relax_type = options()->amgRelaxType();
+    if (options()->amgNumSweeps.isPresent())
+      p.amg_num_sweeps = options()->amgNumSweeps();
+    if (options()->amgStrongThreshold.isPresent())
+      p.amg_strong_threshold = options()->amgStrongThreshold();
+    if (options()->amgAggNumLevels.isPresent())
+      p.amg_agg_num_levels = options()->amgAggNumLevels();
+    if (options()->amgNumFunctions.isPresent())
+      p.amg_num_functions = options()->amgNumFunctions();
+    if (options()->amgNodal.isPresent())
+      p.amg_nodal = options()->amgNodal();
+    if (p.amg_num_functions < 0)
+      ARCANE_FATAL("Invalid value '{0}' for 'amg-num-functions'. Value has to be positive", p.amg_num_functions);
+    return p;
+  }
 };
 
 /*---------------------------------------------------------------------------*/
@@ -0,0 +1,512 @@
+﻿// -*- tab-width: 2; indent-tabs-mode: nil; coding: utf-8-with-signature -*-
+//-----------------------------------------------------------------------------
+// Copyright 2000-2024 CEA (www.cea.fr) IFPEN (www.ifpenergiesnouvelles.com)
+// See the top-level COPYRIGHT file for details.
+// SPDX-License-Identifier: Apache-2.0
+//-----------------------------------------------------------------------------
+/*---------------------------------------------------------------------------*/
+/* MatrixFreeP1Operator.cc                                     (C) 2022-2024 */
+/*                                                                           */
+/* Matrix-free P1 diffusion operator and its preconditioned CG solver.       */
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
+#include "MatrixFreeP1Operator.h"
+
+#include <arcane/utils/FatalErrorException.h>
+#include <arcane/utils/MathUtils.h>
+#include <arcane/utils/PlatformUtils.h>
+
+#include <arcane/IMesh.h>
+#include <arcane/IItemFamily.h>
+#include <arcane/IParallelMng.h>
+#include <arcane/VariableBuildInfo.h>
+#include <arcane/core/UnstructuredMeshConnectivity.h>
+
+#include <arcane/accelerator/RunCommandEnumerate.h>
+#include <arcane/accelerator/RunCommandLoop.h>
+#include <arcane/accelerator/NumArrayViews.h>
+#include <arcane/accelerator/VariableViews.h>
+#include <arcane/accelerator/Reduce.h>
+#include <arcane/accelerator/Atomic.h>
+
+namespace Arcane::FemUtils
+{
+namespace ax = Arcane::Accelerator;
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
+void MatrixFreeP1Operator::
+initialize(IMesh* mesh, const FemGeometryCache& geometry, Real diffusion,
+           Real mass, RunQueue& queue)
+{
+  if (!geometry.hasCellGeometry())
+    ARCANE_FATAL("The cell geometry has to be computed before initializing the matrix-free operator");
+  if (diffusion < 0.0 || mass < 0.0 || (diffusion == 0.0 && mass == 0.0))
+    ARCANE_FATAL("Invalid coefficients for the matrix-free operator (diffusion={0} mass={1})", diffusion, mass);
+
+  m_mesh = mesh;
+  m_geometry = &geometry;
+  m_diffusion = diffusion;
+  m_mass = mass;
+
+  const Int32 nb_node = mesh->nodeFamily()->maxLocalId();
+  m_diagonal.resize(nb_node);
+  m_diagonal.fill(1.0);
+  m_dirichlet_mask.resize(nb_node);
+  m_dirichlet_mask.fill(0);
+  m_scatter_buffer.resize(nb_node);
+  m_chebyshev_max = 0.0;
+
+  if (!m_r) {
+    m_r = std::make_unique<VariableNodeReal>(VariableBuildInfo(mesh, "MatrixFreeR"));
+    m_z = std::make_unique<VariableNodeReal>(VariableBuildInfo(mesh, "MatrixFreeZ"));
+    m_p = std::make_unique<VariableNodeReal>(VariableBuildInfo(mesh, "MatrixFreeP"));
+    m_q = std::make_unique<VariableNodeReal>(VariableBuildInfo(mesh, "MatrixFreeQ"));
+    m_s = std::make_unique<VariableNodeReal>(VariableBuildInfo(mesh, "MatrixFreeS"));
+    m_d = std::make_unique<VariableNodeReal>(VariableBuildInfo(mesh, "MatrixFreeD"));
+  }
+
+  info() << "MatrixFreeP1Operator: diffusion=" << diffusion << " mass=" << mass
+         << " nb_cell=" << mesh->allCells().size();
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*!
+ * The diagonal is gathered by each own node from its cells:
+ * diffusion.|e|.|grad(phi_i)|^2 + mass.|e|.2/((d+1)(d+2)).
+ */
+void MatrixFreeP1Operator::
+setDirichletNodes(const VariableNodeBool& is_dirichlet, RunQueue& queue)
+{
+  ENUMERATE_ (Node, inode, m_mesh->allNodes()) {
+    m_dirichlet_mask(inode.localId()) = (is_dirichlet[inode]) ? 1 : 0;
+  }
+
+  const Int32 dimension = m_mesh->dimension();
+  const Int32 nb_node_per_cell = dimension + 1;
+  const Real diffusion = m_diffusion;
+  const Real mass_diagonal = m_mass * 2.0 / ((dimension + 1) * (dimension + 2));
+
+  UnstructuredMeshConnectivityView connectivity_view;
+  connectivity_view.setMesh(m_mesh);
+  auto cnc = connectivity_view.cellNode();
+  auto nc = connectivity_view.nodeCell();
+
+  auto command = makeCommand(queue);
+  auto in_measure = ax::viewIn(command, m_geometry->m_cell_measure);
+  auto in_gradient_x = ax::viewIn(command, m_geometry->m_cell_gradient_x);
+  auto in_gradient_y = ax::viewIn(command, m_geometry->m_cell_gradient_y);
+  auto in_gradient_z = ax::viewIn(command, m_geometry->m_cell_gradient_z);
+  auto in_dirichlet_mask = ax::viewIn(command, m_dirichlet_mask);
+  auto out_diagonal = ax::viewOut(command, m_diagonal);
+
+  command << RUNCOMMAND_ENUMERATE(Node, node, m_mesh->ownNodes())
+  {
+    Int32 node_lid = node.localId();
+    Real diagonal = 0.0;
+    for (CellLocalId cell : nc.cells(node)) {
+      Int32 lid = cell.localId();
+      Int32 i = 0;
+      for (Int32 k = 0; k < nb_node_per_cell; ++k)
+        if (cnc.nodeId(cell, k) == node)
+          i = k;
+      Real gx = in_gradient_x(lid, i);
+      Real gy = in_gradient_y(lid, i);
+      Real gz = in_gradient_z(lid, i);
+      diagonal += math::abs(in_measure(lid)) * (diffusion * (gx * gx + gy * gy + gz * gz) + mass_diagonal);
+    }
+    out_diagonal(node_lid) = (in_dirichlet_mask(node_lid) || diagonal == 0.0) ? 1.0 : diagonal;
+  };
+
+  // The bounds depend on the diagonal so they have to be computed again.
+  m_chebyshev_max = 0.0;
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
+void MatrixFreeP1Operator::
+apply(VariableNodeReal& x, VariableNodeReal& y, RunQueue& queue)
+{
+  // The cells of the own nodes may reference ghost nodes.
+  x.synchronize();
+
+  if (m_scatter == eMatrixFreeScatter::Atomic)
+    _applyAtomic(x, y, queue);
+  else
+    _applyGather(x, y, queue);
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*!
+ * For a P1 cell e, the gradient of x is constant so that the contribution
+ * to the node i is:
+ * |e| (diffusion grad(phi_i).grad(x) + mass/((d+1)(d+2)) (sum_j x_j + x_i)).
+ */
+void MatrixFreeP1Operator::
+_applyAtomic(VariableNodeReal& x, VariableNodeReal& y, RunQueue& queue)
+{
+  const Int32 dimension = m_mesh->dimension();
+  const Int32 nb_node_per_cell = dimension + 1;
+  const Real diffusion = m_diffusion;
+  const Real mass_factor = m_mass / ((dimension + 1) * (dimension + 2));
+  const Int32 nb_node = m_scatter_buffer.extent0();
+
+  UnstructuredMeshConnectivityView connectivity_view;
+  connectivity_view.setMesh(m_mesh);
+  auto cnc = connectivity_view.cellNode();
+
+  {
+    auto command = makeCommand(queue);
+    auto out_buffer = ax::viewOut(command, m_scatter_buffer);
+    command << RUNCOMMAND_LOOP1(iter, nb_node)
+    {
+      auto [i] = iter();
+      out_buffer(i) = 0.0;
+    };
+  }
+  {
+    auto command = makeCommand(queue);
+    auto in_x = ax::viewIn(command, x);
+    auto in_measure = ax::viewIn(command, m_geometry->m_cell_measure);
+    auto in_gradient_x = ax::viewIn(command, m_geometry->m_cell_gradient_x);
+    auto in_gradient_y = ax::viewIn(command, m_geometry->m_cell_gradient_y);
+    auto in_gradient_z = ax::viewIn(command, m_geometry->m_cell_gradient_z);
+    auto inout_buffer = ax::viewInOut(command, m_scatter_buffer);
+
+    command << RUNCOMMAND_ENUMERATE(Cell, cell, m_mesh->allCells())
+    {
+      Int32 lid = cell.localId();
+      Real measure = math::abs(in_measure(lid));
+      Real x_e[FemGeometryCache::MaxNbNodePerCell];
+      Real3 grad_x;
+      Real sum_x = 0.0;
+      for (Int32 k = 0; k < nb_node_per_cell; ++k) {
+        x_e[k] = in_x[cnc.nodeId(cell, k)];
+        grad_x += x_e[k] * Real3(in_gradient_x(lid, k), in_gradient_y(lid, k), in_gradient_z(lid, k));
+        sum_x += x_e[k];
+      }
+      for (Int32 i = 0; i < nb_node_per_cell; ++i) {
+        Real3 grad_i(in_gradient_x(lid, i), in_gradient_y(lid, i), in_gradient_z(lid, i));
+        Real value = measure * (diffusion * math::dot(grad_i, grad_x) + mass_factor * (sum_x + x_e[i]));
+        ax::doAtomic<ax::eAtomicOperation::Add>(inout_buffer(cnc.nodeId(cell, i).localId()), value);
+      }
+    };
+  }
+  {
+    auto command = makeCommand(queue);
+    auto in_buffer = ax::viewIn(command, m_scatter_buffer);
+    auto in_dirichlet_mask = ax::viewIn(command, m_dirichlet_mask);
+    auto out_y = ax::viewOut(command, y);
+    command << RUNCOMMAND_ENUMERATE(Node, node, m_mesh->ownNodes())
+    {
+      Int32 node_lid = node.localId();
+      out_y[node] = (in_dirichlet_mask(node_lid)) ? 0.0 : in_buffer(node_lid);
+    };
+  }
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*!
+ * Each own node computes its row from its cells. The gradient of x in a
+ * cell is computed again for each node of the cell but there is no atomic
+ * operation and the result does not depend on the order of the cells.
+ */
+void MatrixFreeP1Operator::
+_applyGather(VariableNodeReal& x, VariableNodeReal& y, RunQueue& queue)
+{
+  const Int32 dimension = m_mesh->dimension();
+  const Int32 nb_node_per_cell = dimension + 1;
+  const Real diffusion = m_diffusion;
+  const Real mass_factor = m_mass / ((dimension + 1) * (dimension + 2));
+
+  UnstructuredMeshConnectivityView connectivity_view;
+  connectivity_view.setMesh(m_mesh);
+  auto cnc = connectivity_view.cellNode();
+  auto nc = connectivity_view.nodeCell();
+
+  auto command = makeCommand(queue);
+  auto in_x = ax::viewIn(command, x);
+  auto in_measure = ax::viewIn(command, m_geometry->m_cell_measure);
+  auto in_gradient_x = ax::viewIn(command, m_geometry->m_cell_gradient_x);
+  auto in_gradient_y = ax::viewIn(command, m_geometry->m_cell_gradient_y);
+  auto in_gradient_z = ax::viewIn(command, m_geometry->m_cell_gradient_z);
+  auto in_dirichlet_mask = ax::viewIn(command, m_dirichlet_mask);
+  auto out_y = ax::viewOut(command, y);
+
+  command << RUNCOMMAND_ENUMERATE(Node, node, m_mesh->ownNodes())
+  {
+    Real value = 0.0;
+    if (!in_dirichlet_mask(node.localId())) {
+      Real x_i = in_x[node];
+      for (CellLocalId cell : nc.cells(node)) {
+        Int32 lid = cell.localId();
+        Real3 grad_x;
+        Real sum_x = 0.0;
+        Int32 i = 0;
+        for (Int32 k = 0; k < nb_node_per_cell; ++k) {
+          NodeLocalId node_k = cnc.nodeId(cell, k);
+          if (node_k == node)
+            i = k;
+          Real x_k = in_x[node_k];
+          grad_x += x_k * Real3(in_gradient_x(lid, k), in_gradient_y(lid, k), in_gradient_z(lid, k));
+          sum_x += x_k;
+        }
+        Real3 grad_i(in_gradient_x(lid, i), in_gradient_y(lid, i), in_gradient_z(lid, i));
+        value += math::abs(in_measure(lid)) * (diffusion * math::dot(grad_i, grad_x) + mass_factor * (sum_x + x_i));
+      }
+    }
+    out_y[node] = value;
+  };
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
+Int32 MatrixFreeP1Operator::
+solve(const VariableNodeReal& b, VariableNodeReal& x, Real epsilon,
+      Int32 max_iteration, RunQueue& queue)
+{
+  if (!m_mesh)
+    ARCANE_FATAL("initialize() has to be called before solve()");
+
+  VariableNodeReal& r = *m_r;
+  VariableNodeReal& z = *m_z;
+  VariableNodeReal& p = *m_p;
+  VariableNodeReal& q = *m_q;
+
+  if (m_preconditioner == eMatrixFreePreconditioner::Chebyshev && m_chebyshev_max == 0.0)
+    _estimateChebyshevBounds(queue);
+
+  Real t1 = platform::getRealTime();
+
+  // r = b - A.x for the free nodes. As the Dirichlet rows of r are null,
+  // so are the ones of all the search directions and x keeps its
+  // Dirichlet values.
+  apply(x, q, queue);
+  {
+    auto command = makeCommand(queue);
+    auto in_b = ax::viewIn(command, b);
+    auto in_q = ax::viewIn(command, q);
+    auto in_dirichlet_mask = ax::viewIn(command, m_dirichlet_mask);
+    auto out_r = ax::viewOut(command, r);
+    command << RUNCOMMAND_ENUMERATE(Node, node, m_mesh->ownNodes())
+    {
+      out_r[node] = (in_dirichlet_mask(node.localId())) ? 0.0 : (in_b[node] - in_q[node]);
+    };
+  }
+  Real r0_norm = math::sqrt(_dot(r, r, queue));
+  Real residual_norm = 0.0;
+  Int32 iteration = 0;
+
+  if (r0_norm != 0.0) {
+    _applyPreconditioner(r, z, queue);
+    _axpby(1.0, z, 0.0, p, queue);
+    Real rz = _dot(r, z, queue);
+    residual_norm = 1.0;
+
+    for (; iteration < max_iteration; ++iteration) {
+      apply(p, q, queue);
+      Real alpha = rz / _dot(p, q, queue);
+      _axpby(alpha, p, 1.0, x, queue);
+      _axpby(-alpha, q, 1.0, r, queue);
+      residual_norm = math::sqrt(_dot(r, r, queue)) / r0_norm;
+      if (residual_norm < epsilon) {
+        ++iteration;
+        break;
+      }
+      _applyPreconditioner(r, z, queue);
+      Real new_rz = _dot(r, z, queue);
+      Real beta = new_rz / rz;
+      rz = new_rz;
+      // p = z + beta.p
+      _axpby(1.0, z, beta, p, queue);
+    }
+  }
+  x.synchronize();
+  Real t2 = platform::getRealTime();
+
+  info() << "[MatrixFree] End solve nb_iteration=" << iteration
+         << " relative_residual=" << residual_norm << " time=" << (t2 - t1);
+  if (residual_norm > epsilon)
+    pwarning() << "[MatrixFree] Solver has not converged after " << iteration << " iterations"
+               << " relative_residual=" << residual_norm << " epsilon=" << epsilon;
+  return iteration;
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
+void MatrixFreeP1Operator::
+_applyPreconditioner(VariableNodeReal& r, VariableNodeReal& z, RunQueue& queue)
+{
+  switch (m_preconditioner) {
+  case eMatrixFreePreconditioner::None:
+    _axpby(1.0, r, 0.0, z, queue);
+    break;
+  case eMatrixFreePreconditioner::Jacobi:
+    _axpbyInverseDiagonal(1.0, r, 0.0, z, queue);
+    break;
+  case eMatrixFreePreconditioner::Chebyshev:
+    _applyChebyshev(r, z, queue);
+    break;
+  }
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*!
+ * \brief Apply m_chebyshev_degree steps of the Chebyshev iteration for
+ * D^-1.A.z = D^-1.r starting from z = 0.
+ *
+ * The result is a fixed polynomial of D^-1.A applied to D^-1.r. This
+ * polynomial is positive on ]0, m_chebyshev_max] so it is a valid
+ * preconditioner for the conjugate gradient.
+ */
+void MatrixFreeP1Operator::
+_applyChebyshev(VariableNodeReal& r, VariableNodeReal& z, RunQueue& queue)
+{
+  VariableNodeReal& s = *m_s;
+  VariableNodeReal& d = *m_d;
+  VariableNodeReal& q = *m_q;
+
+  const Real theta = 0.5 * (m_chebyshev_max + m_chebyshev_min);
+  const Real delta = 0.5 * (m_chebyshev_max - m_chebyshev_min);
+  const Real sigma = theta / delta;
+  Real rho = 1.0 / sigma;
+
+  // s = D^-1.r, d = s / theta, z = d
+  _axpbyInverseDiagonal(1.0, r, 0.0, s, queue);
+  _axpby(1.0 / theta, s, 0.0, d, queue);
+  _axpby(1.0, d, 0.0, z, queue);
+  for (Int32 k = 1; k < m_chebyshev_degree; ++k) {
+    // s = s - D^-1.A.d
+    apply(d, q, queue);
+    _axpbyInverseDiagonal(-1.0, q, 1.0, s, queue);
+    Real new_rho = 1.0 / (2.0 * sigma - rho);
+    _axpby(2.0 * new_rho / delta, s, new_rho * rho, d, queue);
+    _axpby(1.0, d, 1.0, z, queue);
+    rho = new_rho;
+  }
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*!
+ * \brief Estimate the largest eigenvalue of D^-1.A with a few power iterations.
+ *
+ * The upper bound is increased by 10% to be safe and the lower bound is
+ * taken as a fraction of the upper bound as usually done for Chebyshev
+ * preconditioners.
+ */
+void MatrixFreeP1Operator::
+_estimateChebyshevBounds(RunQueue& queue)
+{
+  VariableNodeReal& v = *m_p;
+  VariableNodeReal& w = *m_z;
+  VariableNodeReal& q = *m_q;
+
+  // Start from a vector which is not smooth so that it is not close to an
+  // eigenvector of the smallest eigenvalues.
+  {
+    auto command = makeCommand(queue);
+    auto in_dirichlet_mask = ax::viewIn(command, m_dirichlet_mask);
+    auto out_v = ax::viewOut(command, v);
+    command << RUNCOMMAND_ENUMERATE(Node, node, m_mesh->ownNodes())
+    {
+      Int32 lid = node.localId();
+      out_v[node] = (in_dirichlet_mask(lid)) ? 0.0 : (1.0 + ((lid * 7919) % 17) / 17.0);
+    };
+  }
+
+  Real lambda = 0.0;
+  Real v_norm = math::sqrt(_dot(v, v, queue));
+  if (v_norm != 0.0) {
+    _axpby(1.0 / v_norm, v, 0.0, v, queue);
+    for (Int32 k = 0; k < 10; ++k) {
+      apply(v, q, queue);
+      _axpbyInverseDiagonal(1.0, q, 0.0, w, queue);
+      lambda = math::sqrt(_dot(w, w, queue));
+      if (lambda == 0.0)
+        break;
+      _axpby(1.0 / lambda, w, 0.0, v, queue);
+    }
+  }
+  if (lambda == 0.0)
+    lambda = 1.0;
+
+  m_chebyshev_max = 1.1 * lambda;
+  m_chebyshev_min = m_chebyshev_max / 30.0;
+  info() << "MatrixFreeP1Operator: Chebyshev degree=" << m_chebyshev_degree
+         << " bounds=[" << m_chebyshev_min << "," << m_chebyshev_max << "]";
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
+Real MatrixFreeP1Operator::
+_dot(const VariableNodeReal& x, const VariableNodeReal& y, RunQueue& queue)
+{
+  auto command = makeCommand(queue);
+  ax::ReducerSum<Real> reducer(command);
+  auto in_x = ax::viewIn(command, x);
+  auto in_y = ax::viewIn(command, y);
+  command << RUNCOMMAND_ENUMERATE(Node, node, m_mesh->ownNodes())
+  {
+    reducer.add(in_x[node] * in_y[node]);
+  };
+  Real local_sum = reducer.reduce();
+  return m_mesh->parallelMng()->reduce(Parallel::ReduceSum, local_sum);
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*!
+ * \brief Compute y = a.x + b.y for the own nodes.
+ */
+void MatrixFreeP1Operator::
+_axpby(Real a, const VariableNodeReal& x, Real b, VariableNodeReal& y, RunQueue& queue)
+{
+  auto command = makeCommand(queue);
+  auto in_x = ax::viewIn(command, x);
+  auto inout_y = ax::viewInOut(command, y);
+  command << RUNCOMMAND_ENUMERATE(Node, node, m_mesh->ownNodes())
+  {
+    Real x_node = in_x[node];
+    Real y_node = inout_y[node];
+    inout_y[node] = a * x_node + b * y_node;
+  };
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*!
+ * \brief Compute y = a.D^-1.x + b.y for the own nodes.
+ */
+void MatrixFreeP1Operator::
+_axpbyInverseDiagonal(Real a, const VariableNodeReal& x, Real b, VariableNodeReal& y, RunQueue& queue)
+{
+  auto command = makeCommand(queue);
+  auto in_x = ax::viewIn(command, x);
+  auto in_diagonal = ax::viewIn(command, m_diagonal);
+  auto inout_y = ax::viewInOut(command, y);
+  command << RUNCOMMAND_ENUMERATE(Node, node, m_mesh->ownNodes())
+  {
+    Real x_node = in_x[node];
+    Real y_node = inout_y[node];
+    inout_y[node] = a * x_node / in_diagonal(node.localId()) + b * y_node;
+  };
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
+} // namespace Arcane::FemUtils
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,176 @@
+﻿// -*- tab-width: 2; indent-tabs-mode: nil; coding: utf-8-with-signature -*-
+//-----------------------------------------------------------------------------
+// Copyright 2000-2024 CEA (www.cea.fr) IFPEN (www.ifpenergiesnouvelles.com)
+// See the top-level COPYRIGHT file for details.
+// SPDX-License-Identifier: Apache-2.0
+//-----------------------------------------------------------------------------
+/*---------------------------------------------------------------------------*/
+/* MatrixFreeP1Operator.h                                      (C) 2022-2024 */
+/*                                                                           */
+/* Matrix-free P1 diffusion operator and its preconditioned CG solver.       */
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+#ifndef ARCANEFEM_FEMUTILS_MATRIXFREEP1OPERATOR_H
+#define ARCANEFEM_FEMUTILS_MATRIXFREEP1OPERATOR_H
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
+#include <arcane/utils/NumArray.h>
+#include <arcane/utils/TraceAccessor.h>
+
+#include <arcane/VariableTypes.h>
+#include <arcane/ItemGroup.h>
+
+#include <arcane/accelerator/core/RunQueue.h>
+
+#include "FemGeometryCache.h"
+
+#include <memory>
+
+namespace Arcane::FemUtils
+{
+using namespace Arcane;
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
+//! Way the element contributions are accumulated on the nodes
+enum class eMatrixFreeScatter
+{
+  //! Loop over the cells and add the contributions with atomic operations
+  Atomic,
+  //! Loop over the own nodes and gather the contributions of their cells
+  Gather,
+};
+
+//! Preconditioner of the matrix-free conjugate gradient
+enum class eMatrixFreePreconditioner
+{
+  None,
+  Jacobi,
+  Chebyshev,
+};
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*!
+ * \brief Matrix-free P1 operator A = diffusion.K + mass.M.
+ *
+ * K is the stiffness matrix of the Laplacian and M the consistent mass
+ * matrix. The global matrix is never built: the product y = A.x is computed
+ * element by element as y = sum_e Pe^T Ae Pe x with the measures and the
+ * gradients of the shape functions read from a FemGeometryCache. Only
+ * Triangle3 cells in 2D and Tetraedron4 cells in 3D are supported.
+ *
+ * The rows of the Dirichlet nodes are removed from the operator: solve()
+ * keeps the values of the solution on these nodes and solves for the other
+ * nodes with a preconditioned conjugate gradient. The diagonal used by the
+ * Jacobi and Chebyshev preconditioners is also computed element by element.
+ *
+ * All the computations are done with RunQueue. Vectors are node variables
+ * so they are synchronized before each product and the solver works in
+ * parallel.
+ *
+ * Usage:
+ * \code
+ * MatrixFreeP1Operator op(traceMng());
+ * op.initialize(mesh(), m_geometry, 1.0, 0.0, *queue);
+ * op.setDirichletNodes(m_u_dirichlet, *queue);
+ * // m_u contains the Dirichlet values and m_rhs the assembled right hand side
+ * op.solve(m_rhs, m_u, 1.0e-10, 5000, *queue);
+ * \endcode
+ */
+class MatrixFreeP1Operator
+: public TraceAccessor
+{
+ public:
+
+  explicit MatrixFreeP1Operator(ITraceMng* tm)
+  : TraceAccessor(tm)
+  {
+  }
+
+ public:
+
+  //! Keep the coefficients of the operator and create the work vectors
+  void initialize(IMesh* mesh, const FemGeometryCache& geometry, Real diffusion,
+                  Real mass, RunQueue& queue);
+
+  //! Set the nodes where the solution is prescribed and compute the diagonal
+  void setDirichletNodes(const VariableNodeBool& is_dirichlet, RunQueue& queue);
+
+  void setScatter(eMatrixFreeScatter v) { m_scatter = v; }
+  void setPreconditioner(eMatrixFreePreconditioner v) { m_preconditioner = v; }
+  //! Degree of the Chebyshev polynomial used as preconditioner
+  void setChebyshevDegree(Int32 v) { m_chebyshev_degree = v; }
+
+  /*!
+   * \brief Compute y = A.x for the own nodes.
+   *
+   * \a x is synchronized first. The rows of the Dirichlet nodes are set to zero.
+   */
+  void apply(VariableNodeReal& x, VariableNodeReal& y, RunQueue& queue);
+
+  /*!
+   * \brief Solve A.x = b.
+   *
+   * On input, \a x contains the initial guess and the Dirichlet values,
+   * which are kept. The values of \a b on the Dirichlet nodes are not used.
+   * Returns the number of iterations; \a x is synchronized on output.
+   */
+  Int32 solve(const VariableNodeReal& b, VariableNodeReal& x, Real epsilon,
+              Int32 max_iteration, RunQueue& queue);
+
+ public:
+
+  //! Diagonal of A for each node (1 for the Dirichlet nodes)
+  NumArray<Real, MDDim1> m_diagonal;
+  //! 1 if the node is a Dirichlet node, 0 otherwise
+  NumArray<Int32, MDDim1> m_dirichlet_mask;
+
+ private:
+
+  IMesh* m_mesh = nullptr;
+  const FemGeometryCache* m_geometry = nullptr;
+  Real m_diffusion = 1.0;
+  Real m_mass = 0.0;
+  eMatrixFreeScatter m_scatter = eMatrixFreeScatter::Atomic;
+  eMatrixFreePreconditioner m_preconditioner = eMatrixFreePreconditioner::Jacobi;
+  Int32 m_chebyshev_degree = 4;
+  //! Bounds of the spectrum of D^-1.A used by the Chebyshev preconditioner
+  Real m_chebyshev_min = 0.0;
+  Real m_chebyshev_max = 0.0;
+
+  //! Accumulation buffer of the atomic scatter
+  NumArray<Real, MDDim1> m_scatter_buffer;
+
+  // Work vectors. They are variables so that they can be synchronized
+  // before the products.
+  std::unique_ptr<VariableNodeReal> m_r;
+  std::unique_ptr<VariableNodeReal> m_z;
+  std::unique_ptr<VariableNodeReal> m_p;
+  std::unique_ptr<VariableNodeReal> m_q;
+  std::unique_ptr<VariableNodeReal> m_s;
+  std::unique_ptr<VariableNodeReal> m_d;
+
+ private:
+
+  void _applyAtomic(VariableNodeReal& x, VariableNodeReal& y, RunQueue& queue);
+  void _applyGather(VariableNodeReal& x, VariableNodeReal& y, RunQueue& queue);
+  void _applyPreconditioner(VariableNodeReal& r, VariableNodeReal& z, RunQueue& queue);
+  void _applyChebyshev(VariableNodeReal& r, VariableNodeReal& z, RunQueue& queue);
+  void _estimateChebyshevBounds(RunQueue& queue);
+  Real _dot(const VariableNodeReal& x, const VariableNodeReal& y, RunQueue& queue);
+  void _axpby(Real a, const VariableNodeReal& x, Real b, VariableNodeReal& y, RunQueue& queue);
+  void _axpbyInverseDiagonal(Real a, const VariableNodeReal& x, Real b, VariableNodeReal& y, RunQueue& queue);
+};
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
+} // namespace Arcane::FemUtils
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
+#endif
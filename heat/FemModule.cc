@@ -17,12 +17,14 @@
 #include <arcane/IItemFamily.h>
 #include <arcane/ItemGroup.h>
 #include <arcane/ICaseMng.h>
+#include <arcane/IParallelMng.h>
 
 #include "IDoFLinearSystemFactory.h"
 #include "Fem_axl.h"
 #include "FemUtils.h"
 #include "DoFLinearSystem.h"
 #include "FemDoFsOnNodes.h"
+#include "FemGeometryCache.h"
 
 /*---------------------------------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
@@ -38,11 +40,22 @@ using namespace Arcane::FemUtils;
 class FemModule
 : public ArcaneFemObject
 {
+ public:
+
+  //! Time discretization schemes
+  enum class eTimeScheme
+  {
+    BackwardEuler,
+    CrankNicolson,
+    BDF2
+  };
+
  public:
 
   explicit FemModule(const ModuleBuildInfo& mbi)
   : ArcaneFemObject(mbi)
   , m_dofs_on_nodes(mbi.subDomain()->traceMng())
+  , m_geometry(mbi.subDomain()->traceMng())
   {
     ICaseMng* cm = mbi.subDomain()->caseMng();
     cm->setTreatWarningAsError(true);
@@ -81,11 +94,51 @@ class FemModule
   DoFLinearSystem m_linear_system;
   IItemFamily* m_dof_family = nullptr;
   FemDoFsOnNodes m_dofs_on_nodes;
+  FemGeometryCache m_geometry;
+
+  //! True if the bilinear operator has to be assembled for the next solve
+  bool m_need_operator_assembly = true;
+  //! Time step used for the current bilinear operator
+  Real m_operator_dt = 0.0;
+  //! Coefficients of the time scheme used for the current bilinear operator
+  Real m_operator_mass_coef = 0.0;
+  Real m_operator_stiffness_coef = 0.0;
+
+  //! Time scheme given in the options
+  eTimeScheme m_time_scheme = eTimeScheme::BackwardEuler;
+  //! Time scheme used for the current time step
+  eTimeScheme m_step_time_scheme = eTimeScheme::BackwardEuler;
+  //! Coefficient of the mass matrix M/dt in the bilinear operator
+  Real m_mass_coef = 1.0;
+  //! Coefficient of the conduction and convection matrix K in the bilinear operator
+  Real m_stiffness_coef = 1.0;
+  //! Coefficient of K*T(t) in the right hand side
+  Real m_explicit_coef = 0.0;
+  //! Coefficients of T(t) and T(t-dt) for the mass term of the right hand side
+  Real m_history_coef0 = 1.0;
+  Real m_history_coef1 = 0.0;
+
+  //! Adaptive time step parameters
+  bool m_use_adaptive_time_step = false;
+  Real m_dt_min = 0.0;
+  Real m_dt_max = 0.0;
+  //! Time step computed for the next iteration
+  Real m_next_dt = 0.0;
+  //! Time step of the previous iteration
+  Real m_previous_dt = 0.0;
+  //! Number of time steps done
+  Int32 m_nb_time_step = 0;
 
  private:
 
   void _initTime();
   void _updateTime();
+  void _computeTimeCoefficients();
+  void _initLinearSystem();
+  bool _adaptTimeStep(Int32 nb_rejection);
+  Real _estimateTimeError();
+  void _updateTemperatureRate();
+  void _addExplicitOperatorTerm(VariableDoFReal& rhs_values);
   void _updateVariables();
   void _initTemperature();
   void _doStationarySolve();
@@ -101,10 +154,9 @@ class FemModule
   Real  _computeDxOfRealTRIA3(Cell cell);
   Real  _computeDyOfRealTRIA3(Cell cell);
   Real2 _computeDxDyOfRealTRIA3(Cell cell);
-  Real _computeAreaTriangle3(Cell cell);
-  Real _computeEdgeLength2(Face face);
   void _applyDirichletBoundaryConditions();
   void _checkResultFile();
+  void _writeResultFile();
 };
 
 /*---------------------------------------------------------------------------*/
@@ -115,19 +167,37 @@ compute()
 {
   info() << "Module Fem COMPUTE";
 
-  // Stop code after computations
-  if (t >= tmax)
-    subDomain()->timeLoopMng()->stopComputeLoop(true);
+  info() << "NB_CELL=" << allCells().size() << " NB_FACE=" << allFaces().size();
 
-  m_linear_system.reset();
-  m_linear_system.setLinearSystemFactory(options()->linearSystem());
-  m_linear_system.initialize(subDomain(), m_dofs_on_nodes.dofFamily(), "Solver");
+  // The last time step ends exactly at tmax so that the results of runs
+  // with different time steps or time schemes can be compared.
+  const Real time_epsilon = 1.0e-10 * tmax;
+  if (t + dt > tmax - time_epsilon) {
+    dt = tmax - t;
+    m_global_deltat.assign(dt);
+  }
 
-  info() << "NB_CELL=" << allCells().size() << " NB_FACE=" << allFaces().size();
-  _doStationarySolve();
+  // With the adaptive time step, a rejected time step is computed
+  // again with a smaller dt.
+  for (Int32 nb_rejection = 0;; ++nb_rejection) {
+    _computeTimeCoefficients();
+    _initLinearSystem();
+    _doStationarySolve();
+    if (!m_use_adaptive_time_step || _adaptTimeStep(nb_rejection))
+      break;
+  }
+
+  if (m_use_adaptive_time_step)
+    _updateTemperatureRate();
   _updateVariables();
   _updateTime();
 
+  // Stop code after computations and write and check the results at tmax
+  if (t >= tmax - time_epsilon) {
+    subDomain()->timeLoopMng()->stopComputeLoop(true);
+    _writeResultFile();
+    _checkResultFile();
+  }
 }
 
 /*---------------------------------------------------------------------------*/
@@ -141,6 +211,10 @@ startInit()
   m_dofs_on_nodes.initialize(mesh(), 1);
   m_dof_family = m_dofs_on_nodes.dofFamily();
 
+  // The mesh does not move: the geometric factors are computed only once
+  m_geometry.computeCellGeometry(allCells(), m_node_coord, *acceleratorMng()->defaultQueue());
+  m_geometry.computeFaceGeometry(allFaces(), m_node_coord);
+
   _initBoundaryconditions();    // initialize boundary conditions
   _initTime();                  // initialize time
   _getParameters();             // get material parameters
@@ -161,6 +235,22 @@ _initTime()
 
   tmax = tmax ;
   t    = 0.0;
+
+  String scheme = options()->timeDiscretization();
+  if (scheme == "BackwardEuler")
+    m_time_scheme = eTimeScheme::BackwardEuler;
+  else if (scheme == "CrankNicolson")
+    m_time_scheme = eTimeScheme::CrankNicolson;
+  else if (scheme == "BDF2")
+    m_time_scheme = eTimeScheme::BDF2;
+  else
+    ARCANE_FATAL("Invalid value '{0}' for 'time-discretization'. Valid values are: BackwardEuler, CrankNicolson, BDF2", scheme);
+
+  m_use_adaptive_time_step = options()->adaptiveTimeStep();
+  m_dt_min = options()->dtMin();
+  m_dt_max = (options()->dtMax.isPresent()) ? options()->dtMax() : tmax;
+  m_next_dt = dt;
+  info() << "Time discretization=" << scheme << " adaptive_time_step=" << m_use_adaptive_time_step;
 }
 
 /*---------------------------------------------------------------------------*/
@@ -173,6 +263,203 @@ _updateTime()
 
   t += dt;
   info() << "Time t is :" << t << " (s)";
+
+  m_previous_dt = dt;
+  ++m_nb_time_step;
+  if (m_use_adaptive_time_step) {
+    dt = m_next_dt;
+    info() << "Next time step dt=" << dt;
+    m_global_deltat.assign(dt);
+  }
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*!
+ * \brief Compute the coefficients of the time scheme for the current time step.
+ *
+ * The linear system solved at each time step is:
+ *
+ *   (a*M/dt + b*K) T(t+dt) = M/dt (c0*T(t) - c1*T(t-dt)) - e*K*T(t) + F
+ *
+ * with M the mass matrix, K the conduction and convection matrix and F the
+ * source and flux terms:
+ * - BackwardEuler: a=1, b=1, c0=1, c1=0, e=0
+ * - CrankNicolson: a=1, b=1/2, c0=1, c1=0, e=1/2
+ * - BDF2 with w=dt/dt_prev: a=(1+2w)/(1+w), b=1, c0=1+w, c1=w*w/(1+w), e=0
+ *
+ * BDF2 needs two previous solutions so BackwardEuler is used for the first
+ * time step. BackwardEuler is also used for the first time step of
+ * CrankNicolson because CrankNicolson does not damp the high frequencies
+ * of the initial jump between the initial temperature and the Dirichlet
+ * values.
+ */
+void FemModule::
+_computeTimeCoefficients()
+{
+  m_step_time_scheme = m_time_scheme;
+  if (m_nb_time_step == 0)
+    m_step_time_scheme = eTimeScheme::BackwardEuler;
+
+  m_mass_coef = 1.0;
+  m_stiffness_coef = 1.0;
+  m_explicit_coef = 0.0;
+  m_history_coef0 = 1.0;
+  m_history_coef1 = 0.0;
+
+  switch (m_step_time_scheme) {
+  case eTimeScheme::BackwardEuler:
+    break;
+  case eTimeScheme::CrankNicolson:
+    m_stiffness_coef = 0.5;
+    m_explicit_coef = 0.5;
+    break;
+  case eTimeScheme::BDF2: {
+    Real w = dt / m_previous_dt;
+    m_mass_coef = (1.0 + 2.0 * w) / (1.0 + w);
+    m_history_coef0 = 1.0 + w;
+    m_history_coef1 = w * w / (1.0 + w);
+  } break;
+  }
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*!
+ * \brief Create the linear system if the bilinear operator has changed.
+ *
+ * The bilinear operator only depends on dt, on the coefficients of the time
+ * scheme and on the material and convection parameters. It is kept between
+ * time steps and the linear system is only created again when one of these
+ * parameters changes.
+ */
+void FemModule::
+_initLinearSystem()
+{
+  if (dt != m_operator_dt || m_mass_coef != m_operator_mass_coef || m_stiffness_coef != m_operator_stiffness_coef)
+    m_need_operator_assembly = true;
+  if (m_need_operator_assembly || !m_linear_system.isInitialized()) {
+    m_linear_system.reset();
+    m_linear_system.setLinearSystemFactory(options()->linearSystem());
+    m_linear_system.initialize(subDomain(), m_dofs_on_nodes.dofFamily(), "Solver");
+    m_need_operator_assembly = true;
+  }
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*!
+ * \brief Estimate the local time error of the current time step.
+ *
+ * The solution is compared to an explicit predictor of the same order
+ * (forward Euler for BackwardEuler, Adams-Bashforth 2 for CrankNicolson and
+ * BDF2) built from the time derivatives of the previous time steps. The
+ * difference is scaled with the ratio of the error constants of the two
+ * methods (Milne's device).
+ *
+ * \return the error relative to the maximum temperature or a negative value
+ * if there are not enough previous time steps to build the predictor.
+ */
+Real FemModule::
+_estimateTimeError()
+{
+  const bool is_first_order = (m_step_time_scheme == eTimeScheme::BackwardEuler);
+  const Int32 nb_needed_step = (is_first_order) ? 1 : 2;
+  if (m_nb_time_step < nb_needed_step)
+    return -1.0;
+
+  const Real w = dt / m_previous_dt;
+  Real max_diff = 0.0;
+  Real max_value = 0.0;
+  ENUMERATE_ (Node, inode, ownNodes()) {
+    Node node = *inode;
+    if (m_node_is_temperature_fixed[node])
+      continue;
+    Real un = m_node_temperature_old[node];
+    Real predictor = 0.0;
+    if (is_first_order)
+      predictor = un + dt * m_node_temperature_rate[node];
+    else
+      predictor = un + 0.5 * dt * ((2.0 + w) * m_node_temperature_rate[node] - w * m_node_temperature_rate_old[node]);
+    Real u = m_node_temperature[node];
+    max_diff = math::max(max_diff, math::abs(u - predictor));
+    max_value = math::max(max_value, math::abs(u));
+  }
+  IParallelMng* pm = parallelMng();
+  max_diff = pm->reduce(Parallel::ReduceMax, max_diff);
+  max_value = pm->reduce(Parallel::ReduceMax, max_value);
+
+  // Ratio of the error constants. For BDF2 the constant step value is used.
+  Real error_constant = 0.5;
+  if (m_step_time_scheme == eTimeScheme::CrankNicolson)
+    error_constant = 1.0 / (3.0 * (1.0 + 1.0 / w));
+  else if (m_step_time_scheme == eTimeScheme::BDF2)
+    error_constant = 8.0 / 23.0;
+
+  return error_constant * max_diff / math::max(max_value, 1.0);
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*!
+ * \brief Check the error of the current time step and compute the next dt.
+ *
+ * \return true if the time step is accepted. Otherwise \a dt is reduced and
+ * the time step has to be computed again.
+ */
+bool FemModule::
+_adaptTimeStep(Int32 nb_rejection)
+{
+  Real error = _estimateTimeError();
+  if (error < 0.0) {
+    m_next_dt = dt;
+    return true;
+  }
+
+  const Real tolerance = options()->timeErrorTolerance();
+  const Real order = (m_step_time_scheme == eTimeScheme::BackwardEuler) ? 1.0 : 2.0;
+  Real factor = 0.9 * math::pow(tolerance / math::max(error, 1.0e-30), 1.0 / (order + 1.0));
+  factor = math::min(2.0, math::max(0.2, factor));
+  Real new_dt = math::min(m_dt_max, math::max(m_dt_min, dt * factor));
+
+  info() << "Time step error=" << error << " tolerance=" << tolerance << " dt=" << dt << " new_dt=" << new_dt;
+
+  if (error > tolerance) {
+    if (dt > m_dt_min && nb_rejection < options()->maxNbRejection()) {
+      info() << "Time step rejected nb_rejection=" << (nb_rejection + 1);
+      dt = new_dt;
+      return false;
+    }
+    pwarning() << "Time step accepted with error=" << error << " greater than tolerance=" << tolerance
+               << " (dt=" << dt << " nb_rejection=" << nb_rejection << ")";
+  }
+  m_next_dt = new_dt;
+  return true;
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*!
+ * \brief Compute the time derivative of the temperature at the new time.
+ *
+ * The derivative is consistent with the time scheme used for the time step.
+ */
+void FemModule::
+_updateTemperatureRate()
+{
+  const bool has_previous_rate = (m_nb_time_step > 0);
+  ENUMERATE_ (Node, inode, allNodes()) {
+    Node node = *inode;
+    Real u = m_node_temperature[node];
+    Real un = m_node_temperature_old[node];
+    Real rate = (u - un) / dt;
+    if (m_step_time_scheme == eTimeScheme::CrankNicolson && has_previous_rate)
+      rate = 2.0 * (u - un) / dt - m_node_temperature_rate[node];
+    else if (m_step_time_scheme == eTimeScheme::BDF2)
+      rate = (m_mass_coef * u - m_history_coef0 * un + m_history_coef1 * m_node_temperature_old2[node]) / dt;
+    m_node_temperature_rate_old[node] = m_node_temperature_rate[node];
+    m_node_temperature_rate[node] = rate;
+  }
 }
 
 /*---------------------------------------------------------------------------*/
@@ -184,9 +471,12 @@ _updateVariables()
   info() << "Update FEM variables";
 
   {
-    // Copy Node temperature to Node temperature old
-    ENUMERATE_ (Node, inode, ownNodes()) {
+    // Copy Node temperature to Node temperature old.
+    // Ghost nodes are also copied because the right hand side of
+    // CrankNicolson needs T(t) on all the nodes of a cell.
+    ENUMERATE_ (Node, inode, allNodes()) {
       Node node = *inode;
+      m_node_temperature_old2[node] = m_node_temperature_old[node];
       m_node_temperature_old[node] = m_node_temperature[node];
     }
   }
@@ -204,9 +494,14 @@ _initTemperature()
 
   {
     // Copy Node temperature to Node temperature old
-    ENUMERATE_ (Node, inode, ownNodes()) {
+    ENUMERATE_ (Node, inode, allNodes()) {
       Node node = *inode;
       m_node_temperature_old[node] = Tinit;
+      // The explicit part of CrankNicolson uses the temperature of
+      // the Dirichlet nodes
+      if (m_node_is_temperature_fixed[node])
+        m_node_temperature_old[node] = m_node_temperature[node];
+      m_node_temperature_old2[node] = m_node_temperature_old[node];
     }
   }
 }
@@ -221,10 +516,15 @@ _doStationarySolve()
   // # update BCs
   _updateBoundayConditions();
 
-  // Assemble the FEM bilinear operator (LHS - matrix A)
-  _assembleBilinearOperatorTRIA3();
-
-  _assembleBilinearOperatorEDGE2();
+  // Assemble the FEM bilinear operator (LHS - matrix A) if it is not
+  // kept from the previous time step
+  if (m_need_operator_assembly) {
+    info() << "Assembly of FEM bilinear operator dt=" << dt;
+    _assembleBilinearOperatorTRIA3();
+    _assembleBilinearOperatorEDGE2();
+  }
+  else
+    info() << "Reusing FEM bilinear operator of previous time step";
 
   // Assemble the FEM linear operator (RHS - vector b)
   _assembleLinearOperator();
@@ -232,8 +532,10 @@ _doStationarySolve()
   // # T=linalg.solve(K,RHS)
   _solve();
 
-  // Check results
-  _checkResultFile();
+  m_need_operator_assembly = false;
+  m_operator_dt = dt;
+  m_operator_mass_coef = m_mass_coef;
+  m_operator_stiffness_coef = m_stiffness_coef;
 }
 
 /*---------------------------------------------------------------------------*/
@@ -262,6 +564,9 @@ _getParameters()
       m_cell_lambda[cell] = value;
       }
     }
+
+  // The material parameters are used by the bilinear operator
+  m_need_operator_assembly = true;
 }
 
 /*---------------------------------------------------------------------------*/
@@ -373,7 +678,8 @@ _assembleLinearOperator()
       NodeLocalId node_id = *inode;
       if (m_node_is_temperature_fixed[node_id]) {
         DoFLocalId dof_id = node_dof.dofId(*inode, 0);
-        m_linear_system.matrixSetValue(dof_id, dof_id, Penalty);
+        if (m_need_operator_assembly)
+          m_linear_system.matrixSetValue(dof_id, dof_id, Penalty);
         Real temperature = Penalty * m_node_temperature[node_id];
         rhs_values[dof_id] = temperature;
       }
@@ -402,7 +708,9 @@ _assembleLinearOperator()
       NodeLocalId node_id = *inode;
       if (m_node_is_temperature_fixed[node_id]) {
         DoFLocalId dof_id = node_dof.dofId(*inode, 0);
-        m_linear_system.matrixAddValue(dof_id, dof_id, Penalty);
+        // The penalty is added only once to a kept operator
+        if (m_need_operator_assembly)
+          m_linear_system.matrixAddValue(dof_id, dof_id, Penalty);
         Real temperature = Penalty * m_node_temperature[node_id];
         rhs_values[dof_id] = temperature;
       }
@@ -486,13 +794,17 @@ _assembleLinearOperator()
   //----------------------------------------------
   ENUMERATE_ (Cell, icell, allCells()) {
     Cell cell = *icell;
-    Real area = _computeAreaTriangle3(cell);
+    Real area = m_geometry.cellMeasure(cell);
     for (Node node : cell.nodes()) {
       if (!(m_node_is_temperature_fixed[node]) && node.isOwn())
-        rhs_values[node_dof.dofId(node, 0)] += (m_node_temperature_old[node]/dt) * area / ElementNodes;
+        rhs_values[node_dof.dofId(node, 0)] += ((m_history_coef0 * m_node_temperature_old[node] - m_history_coef1 * m_node_temperature_old2[node])/dt) * area / ElementNodes;
     }
   }
 
+  // Explicit part of the time scheme (CrankNicolson)
+  if (m_explicit_coef != 0.0)
+    _addExplicitOperatorTerm(rhs_values);
+
   //----------------------------------------------
   // Constant flux term assembly
   //----------------------------------------------
@@ -506,7 +818,7 @@ _assembleLinearOperator()
     Real value = bs->value();
     ENUMERATE_ (Face, iface, group) {
       Face face = *iface;
-      Real length = _computeEdgeLength2(face);
+      Real length = m_geometry.faceMeasure(face);
       for (Node node : iface->nodes()) {
         if (!(m_node_is_temperature_fixed[node]) && node.isOwn())
           rhs_values[node_dof.dofId(node, 0)] += value * length / 2.;
@@ -527,7 +839,7 @@ _assembleLinearOperator()
     Text = bs->Text();
     ENUMERATE_ (Face, iface, group) {
       Face face = *iface;
-      Real length = _computeEdgeLength2(face);
+      Real length = m_geometry.faceMeasure(face);
       for (Node node : iface->nodes()) {
         if (!(m_node_is_temperature_fixed[node]) && node.isOwn())
           rhs_values[node_dof.dofId(node, 0)] += h * Text * length / 2.;
@@ -537,6 +849,56 @@ _assembleLinearOperator()
 
 }
 
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*!
+ * \brief Add the explicit part -e*K*T(t) of the time scheme to the RHS.
+ *
+ * K contains the conduction term lambda*(grad(u).grad(v)) on the cells
+ * and the convection term h*u*v on the convection boundaries.
+ */
+void FemModule::
+_addExplicitOperatorTerm(VariableDoFReal& rhs_values)
+{
+  auto node_dof(m_dofs_on_nodes.nodeDoFConnectivityView());
+
+  ENUMERATE_ (Cell, icell, allCells()) {
+    Cell cell = *icell;
+    Real coef = m_explicit_coef * m_cell_lambda[cell] * m_geometry.cellMeasure(cell);
+    Int32 n1_index = 0;
+    for (Node node1 : cell.nodes()) {
+      if (!(m_node_is_temperature_fixed[node1]) && node1.isOwn()) {
+        Real3 dphi1 = m_geometry.cellGradient(cell, n1_index);
+        Real v = 0.0;
+        Int32 n2_index = 0;
+        for (Node node2 : cell.nodes()) {
+          v += math::dot(dphi1, m_geometry.cellGradient(cell, n2_index)) * m_node_temperature_old[node2];
+          ++n2_index;
+        }
+        rhs_values[node_dof.dofId(node1, 0)] -= coef * v;
+      }
+      ++n1_index;
+    }
+  }
+
+  for (const auto& bs : options()->convectionBoundaryCondition()) {
+    FaceGroup group = bs->surface();
+    Real coef = m_explicit_coef * bs->h() / 6.;
+    ENUMERATE_ (Face, iface, group) {
+      Face face = *iface;
+      Real length = m_geometry.faceMeasure(face);
+      Real t0 = m_node_temperature_old[face.nodeId(0)];
+      Real t1 = m_node_temperature_old[face.nodeId(1)];
+      Node node0 = face.node(0);
+      Node node1 = face.node(1);
+      if (!(m_node_is_temperature_fixed[node0]) && node0.isOwn())
+        rhs_values[node_dof.dofId(node0, 0)] -= coef * length * (2. * t0 + t1);
+      if (!(m_node_is_temperature_fixed[node1]) && node1.isOwn())
+        rhs_values[node_dof.dofId(node1, 0)] -= coef * length * (t0 + 2. * t1);
+    }
+  }
+}
+
 /*---------------------------------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
 
@@ -602,29 +964,6 @@ _computeDxDyOfRealTRIA3(Cell cell)
 /*---------------------------------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
 
-Real FemModule::
-_computeAreaTriangle3(Cell cell)
-{
-  Real3 m0 = m_node_coord[cell.nodeId(0)];
-  Real3 m1 = m_node_coord[cell.nodeId(1)];
-  Real3 m2 = m_node_coord[cell.nodeId(2)];
-  return 0.5 * ((m1.x - m0.x) * (m2.y - m0.y) - (m2.x - m0.x) * (m1.y - m0.y));
-}
-
-/*---------------------------------------------------------------------------*/
-/*---------------------------------------------------------------------------*/
-
-Real FemModule::
-_computeEdgeLength2(Face face)
-{
-  Real3 m0 = m_node_coord[face.nodeId(0)];
-  Real3 m1 = m_node_coord[face.nodeId(1)];
-  return  math::sqrt((m1.x-m0.x)*(m1.x-m0.x) + (m1.y-m0.y)*(m1.y - m0.y));
-}
-
-/*---------------------------------------------------------------------------*/
-/*---------------------------------------------------------------------------*/
-
 FixedMatrix<2, 2> FemModule::
 _computeElementMatrixEDGE2(Face face)
 {
@@ -634,13 +973,7 @@ _computeElementMatrixEDGE2(Face face)
   //                   o . . . . o
   //
   //------------------------------------------------
-  Real3 m0 = m_node_coord[face.nodeId(0)];
-  Real3 m1 = m_node_coord[face.nodeId(1)];
-
-  Real area = _computeEdgeLength2(face);    // calculate length
-
-  Real2 dPhi0(m0.y - m1.y, m1.x - m0.x);
-  Real2 dPhi1(m1.y - m0.y, m0.x - m1.x);
+  Real area = m_geometry.faceMeasure(face);    // length of the face
 
   FixedMatrix<1, 2> b_matrix;
   FixedMatrix<2, 1> bT_matrix;
@@ -666,7 +999,7 @@ _computeElementMatrixEDGE2(Face face)
   for (Int32 i = 0; i<2; i++)
     int_UV(i,i) *= 2.;
 
-  int_UV.multInPlace(h);
+  int_UV.multInPlace(h * m_stiffness_coef);
   int_DOmega_i = matrixAddition( int_DOmega_i, int_UV);
 
   return int_DOmega_i;
@@ -686,15 +1019,12 @@ _computeElementMatrixTRIA3(Cell cell)
   //                 .     .
   //              1 o . . . o 2
   //------------------------------------------------
-  Real3 m0 = m_node_coord[cell.nodeId(0)];
-  Real3 m1 = m_node_coord[cell.nodeId(1)];
-  Real3 m2 = m_node_coord[cell.nodeId(2)];
-
-  Real area = _computeAreaTriangle3(cell);    // calculate area
+  Real area = m_geometry.cellMeasure(cell);    // area of the cell
 
-  Real2 dPhi0(m1.y - m2.y, m2.x - m1.x);
-  Real2 dPhi1(m2.y - m0.y, m0.x - m2.x);
-  Real2 dPhi2(m0.y - m1.y, m1.x - m0.x);
+  // dPhi_i = 2 * area * grad(Phi_i)
+  Real3 dPhi0 = m_geometry.cellGradient(cell, 0) * (2. * area);
+  Real3 dPhi1 = m_geometry.cellGradient(cell, 1) * (2. * area);
+  Real3 dPhi2 = m_geometry.cellGradient(cell, 2) * (2. * area);
 
   FixedMatrix<1, 3> b_matrix;
   FixedMatrix<3, 1> bT_matrix;
@@ -742,7 +1072,7 @@ _computeElementMatrixTRIA3(Cell cell)
   FixedMatrix<3, 3> int_dyUdyV = matrixMultiplication(bT_matrix, b_matrix);
   int_Omega_i = matrixAddition( int_Omega_i, int_dyUdyV);
 
-  int_Omega_i.multInPlace(lambda);
+  int_Omega_i.multInPlace(lambda * m_stiffness_coef);
 
   // uv //
   b_matrix(0, 0) = 1.;
@@ -762,7 +1092,7 @@ _computeElementMatrixTRIA3(Cell cell)
   for (Int32 i = 0; i<3; i++)
     int_UV(i,i) *= 2.;
 
-  int_UV.multInPlace(1./dt);
+  int_UV.multInPlace(m_mass_coef/dt);
 
   int_Omega_i = matrixAddition( int_Omega_i, int_UV);
 
@@ -861,8 +1191,7 @@ _solve()
       m_node_temperature[node] = v;
     }
 
-    m_node_temperature.synchronize();
-    m_node_temperature_old.synchronize();
+    synchronizeVariables(m_node_temperature, m_node_temperature_old);
 
     if(m_flux.tagValue("PostProcessing")=="1") {
       ENUMERATE_ (Cell, icell, allCells()) {
@@ -924,10 +1253,27 @@ _checkResultFile()
   info() << "CheckResultFile filename=" << filename;
   if (filename.empty())
     return;
-  const double epsilon = 1.0e-4;
+  const double epsilon = options()->resultEpsilon();
   checkNodeResultFile(traceMng(), filename, m_node_temperature, epsilon);
 }
 
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*!
+ * \brief Write the temperature in the file given by 'result-output-file'.
+ *
+ * The file can be used as the 'result-file' of another run, for example to
+ * compare the linear solvers.
+ */
+void FemModule::
+_writeResultFile()
+{
+  String filename = options()->resultOutputFile();
+  if (filename.empty())
+    return;
+  writeNodeResultFile(traceMng(), filename, m_node_temperature);
+}
+
 /*---------------------------------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
 
@@ -2352,9 +2352,7 @@ _doSolve(){
   // on all nodes
   _applyDirichletBoundaryConditions();// --- Check if it is required (re-apply paraxial conditions too?)
 
-  m_displ.synchronize();
-  m_vel.synchronize();
-  m_acc.synchronize();
+  synchronizeVariables(m_displ, m_vel, m_acc);
   const bool do_print = (allNodes().size() < 200);
   if (do_print) {
     int p = std::cout.precision();
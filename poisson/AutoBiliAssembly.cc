@@ -0,0 +1,163 @@
+﻿// -*- tab-width: 2; indent-tabs-mode: nil; coding: utf-8-with-signature -*-
+//-----------------------------------------------------------------------------
+// Copyright 2000-2024 CEA (www.cea.fr) IFPEN (www.ifpenergiesnouvelles.com)
+// See the top-level COPYRIGHT file for details.
+// SPDX-License-Identifier: Apache-2.0
+//-----------------------------------------------------------------------------
+/*---------------------------------------------------------------------------*/
+/* AutoBiliAssembly.cc                                         (C) 2022-2024 */
+/*                                                                           */
+/* Selection of the fastest bilinear assembly method at runtime.             */
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
+#include "FemModule.h"
+
+#include <arcane/utils/PlatformUtils.h>
+#include <arcane/IParallelMng.h>
+#include <arcane/accelerator/core/Runner.h>
+
+#include <sstream>
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*!
+ * \brief Set the flags so that only the assembly method \a name is used.
+ *
+ * \a name is the name of the command line flag of the method (LEGACY, COO, ...).
+ */
+void FemModule::
+_setAssemblyMethod(const String& name)
+{
+  m_use_legacy = (name == "LEGACY");
+  m_use_coo = (name == "COO");
+  m_use_coo_sort = (name == "COO_SORT");
+  m_use_csr = (name == "CSR");
+  m_use_csr_gpu = (name == "CSR_GPU");
+  m_use_nodewise_csr = (name == "NWCSR");
+  m_use_buildless_csr = (name == "BLCSR");
+  m_use_cusparse_add = false;
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*!
+ * \brief Key of the selected method in the cache file.
+ *
+ * The key contains the mesh type, the global number of cells, the number of
+ * sub-domains and the execution policy of the default runner.
+ */
+String FemModule::
+_autoAssemblyCacheKey()
+{
+  IParallelMng* pm = parallelMng();
+  Int64 nb_cell = pm->reduce(Parallel::ReduceSum, Int64(ownCells().size()));
+  std::ostringstream key;
+  key << options()->meshType() << " " << nb_cell << " " << pm->commSize()
+      << " " << acceleratorMng()->defaultRunner()->executionPolicy();
+  return String(key.str());
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*!
+ * \brief Select the fastest bilinear assembly method.
+ *
+ * If the cache file contains a method for the current key, this method is
+ * used. The cache file is read by the first sub-domain, which broadcasts the
+ * method to the others.
+ *
+ * Otherwise each available method assembles the matrix once without timing,
+ * to build its structure and warm the caches, then nb_trial times, without
+ * cache warming. The time of a method is the minimum over these trials, so
+ * a slow trial does not penalize it. The time of a trial is the maximum over
+ * the sub-domains so all of them select the same method. The selected method
+ * is appended to the cache file by the first sub-domain.
+ *
+ * The cusparse assembly is not a candidate because it does not fill the
+ * linear system used by the other methods.
+ */
+void FemModule::
+_selectAssemblyMethod()
+{
+  Timer::Action timer_action(m_time_stats, "AutoAssemblySelection");
+  m_use_auto_assembly = false;
+
+  UniqueArray<String> methods = { "LEGACY", "COO", "COO_SORT", "CSR", "NWCSR", "BLCSR" };
+#ifdef ARCANE_HAS_ACCELERATOR
+  methods.add("CSR_GPU");
+#endif
+
+  IParallelMng* pm = parallelMng();
+  String key = _autoAssemblyCacheKey();
+
+  if (!m_auto_assembly_cache_file.empty()) {
+    // Index in methods of the method found in the cache file
+    UniqueArray<Int32> cached_index(1, -1);
+    if (pm->commRank() == 0) {
+      std::ifstream cache_file(m_auto_assembly_cache_file.localstr());
+      std::string prefix = std::string(key.localstr()) + " ";
+      std::string line;
+      while (std::getline(cache_file, line)) {
+        if (line.compare(0, prefix.size(), prefix) != 0)
+          continue;
+        String method(line.substr(prefix.size()));
+        for (Int32 i = 0; i < methods.size() && cached_index[0] < 0; ++i)
+          if (methods[i] == method)
+            cached_index[0] = i;
+        if (cached_index[0] >= 0)
+          break;
+      }
+    }
+    pm->broadcast(cached_index.view(), 0);
+    if (cached_index[0] >= 0) {
+      const String& method = methods[cached_index[0]];
+      info() << "AUTO_ASSEMBLY: Using " << method << " found in '" << m_auto_assembly_cache_file << "' for '" << key << "'";
+      _setAssemblyMethod(method);
+      return;
+    }
+  }
+
+  const Integer cache_warming = m_cache_warming;
+  m_cache_warming = 1;
+
+  const Int32 nb_trial = 3;
+  String best_method;
+  Real best_time = 0.0;
+  for (const String& method : methods) {
+    _setAssemblyMethod(method);
+    // Untimed run to build the structure of the matrix and warm the caches
+    _assembleBilinearOperator();
+    Real time = 0.0;
+    for (Int32 trial = 0; trial < nb_trial; ++trial) {
+      Real t1 = platform::getRealTime();
+      {
+        Timer::Action timer_trial(m_time_stats, "AutoAssemblyTrial");
+        _assembleBilinearOperator();
+      }
+      Real t2 = platform::getRealTime();
+      Real trial_time = pm->reduce(Parallel::ReduceMax, t2 - t1);
+      if (trial == 0 || trial_time < time)
+        time = trial_time;
+    }
+    info() << "AUTO_ASSEMBLY: " << method << " time=" << time << " (minimum of " << nb_trial << " trials)";
+    if (best_method.empty() || time < best_time) {
+      best_method = method;
+      best_time = time;
+    }
+  }
+
+  m_cache_warming = cache_warming;
+  // The trials have changed the structure of m_csr_matrix
+  m_csr_structure_name = String();
+  _setAssemblyMethod(best_method);
+  info() << "AUTO_ASSEMBLY: Selected " << best_method << " (time=" << best_time << ") for '" << key << "'";
+
+  if (!m_auto_assembly_cache_file.empty() && pm->commRank() == 0) {
+    std::ofstream cache_file(m_auto_assembly_cache_file.localstr(), std::ios_base::app);
+    cache_file << key << " " << best_method << "\n";
+  }
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
@@ -257,6 +257,12 @@ void FemModule::_assembleBuildLessCsrBilinearOperatorTria3()
     _buildMatrixGpuBuildLessCsr();
   }
 
+  if (m_use_element_matrix_prepass) {
+    _computeElementMatrixPrePass(3);
+    _assembleBuildLessCsrFromElementMatrix(3);
+    return;
+  }
+
   RunQueue* queue = acceleratorMng()->defaultQueue();
 
   // Boucle sur les noeuds déportée sur accélérateur
@@ -356,6 +362,12 @@ void FemModule::_assembleBuildLessCsrBilinearOperatorTetra4()
     _buildMatrixGpuBuildLessCsr();
   }
 
+  if (m_use_element_matrix_prepass) {
+    _computeElementMatrixPrePass(4);
+    _assembleBuildLessCsrFromElementMatrix(4);
+    return;
+  }
+
   RunQueue* queue = acceleratorMng()->defaultQueue();
 
   // Boucle sur les noeuds déportée sur accélérateur
@@ -442,3 +454,51 @@ void FemModule::_assembleBuildLessCsrBilinearOperatorTetra4()
 
 /*---------------------------------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
+/*!
+ * \brief Node-wise BLCSR kernel using the element matrices computed by
+ * _computeElementMatrixPrePass().
+ */
+void FemModule::
+_assembleBuildLessCsrFromElementMatrix(Int32 nb_node_per_cell)
+{
+  RunQueue* queue = acceleratorMng()->defaultQueue();
+  auto command = makeCommand(queue);
+
+  auto node_dof(m_dofs_on_nodes.nodeDoFConnectivityView());
+  auto in_row_csr = ax::viewIn(command, m_csr_matrix.m_matrix_row);
+  Int32 row_csr_size = m_csr_matrix.m_matrix_row.dim1Size();
+  auto in_out_col_csr = ax::viewInOut(command, m_csr_matrix.m_matrix_column);
+  Int32 col_csr_size = m_csr_matrix.m_matrix_column.dim1Size();
+  auto in_out_val_csr = ax::viewInOut(command, m_csr_matrix.m_matrix_value);
+  auto in_element_matrix = ax::viewIn(command, m_cell_element_matrix);
+  auto in_node_index = ax::viewIn(command, m_node_index_in_cells);
+
+  UnstructuredMeshConnectivityView m_connectivity_view;
+  m_connectivity_view.setMesh(this->mesh());
+  auto ncc = m_connectivity_view.nodeCell();
+  auto cnc = m_connectivity_view.cellNode();
+
+  Timer::Action timer_blcsr_add_compute(m_time_stats, "BuildLessCsrAddAndCompute");
+
+  command << RUNCOMMAND_ENUMERATE(Node, inode, ownNodes())
+  {
+    Int32 row = node_dof.dofId(inode, 0).localId();
+    Int32 begin = in_row_csr[row];
+    Int32 end = (row == row_csr_size - 1) ? col_csr_size : in_row_csr[row + 1];
+    Int32 cell_index = 0;
+    for (auto cell : ncc.cells(inode)) {
+      Int32 inode_index = in_node_index(inode.localId(), cell_index);
+      Int32 i = 0;
+      for (NodeLocalId node2 : cnc.nodes(cell)) {
+        Real x = in_element_matrix(cell.localId(), _upperTriangularIndex(inode_index, i, nb_node_per_cell));
+        Int32 col = node_dof.dofId(node2, 0).localId();
+        _addValueToGlobalMatrixTria3Gpu(begin, end, col, in_out_col_csr, in_out_val_csr, x);
+        i++;
+      }
+      cell_index++;
+    }
+  };
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
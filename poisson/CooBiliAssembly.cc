@@ -36,9 +36,27 @@ _buildMatrix()
   }
   */
 
+  auto node_dof(m_dofs_on_nodes.nodeDoFConnectivityView());
+
+  // In 3D, the structure is computed from the node-cell connectivity
+  // (see _buildMatrixCsr()) so the edges of the mesh are not needed.
+  // The rows of the csr structure are sorted, as needed by indexValue().
+  if (options()->meshType == "TETRA4") {
+    RunQueue* queue = acceleratorMng()->defaultQueue();
+    CsrFormat csr_structure(subDomain());
+    csr_structure.computeSparsity(m_dof_family, mesh(), node_dof, 1, *queue);
+    m_coo_matrix.initialize(m_dof_family, csr_structure.m_nnz);
+    const Int32 nb_row = csr_structure.m_matrix_row.extent0();
+    for (Int32 row = 0; row < nb_row; ++row) {
+      const Int32 begin = csr_structure.m_matrix_row(row);
+      for (Int32 j = begin, end = begin + csr_structure.m_matrix_rows_nb_column(row); j < end; ++j)
+        m_coo_matrix.setCoordinates(DoFLocalId(row), DoFLocalId(csr_structure.m_matrix_column(j)));
+    }
+    return;
+  }
+
   Int32 nnz = nbFace() * 2 + nbNode();
   m_coo_matrix.initialize(m_dof_family, nnz);
-  auto node_dof(m_dofs_on_nodes.nodeDoFConnectivityView());
 
   //We iterate through the node, and we do not sort anymore : we assume the nodes ID are sorted, and we will iterate throught the column to avoid making < and > comparison
   ENUMERATE_NODE (inode, allNodes()) {
@@ -110,3 +128,40 @@ _assembleCooBilinearOperatorTRIA3()
 
 /*---------------------------------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
+
+void FemModule::
+_assembleCooBilinearOperatorTETRA4()
+{
+
+  Timer::Action timer_coo_bili(m_time_stats, "AssembleCooBilinearOperatorTetra4");
+
+  {
+    Timer::Action timer_coo_build(m_time_stats, "CooBuildMatrix");
+    // Build the coo matrix
+    _buildMatrix();
+  }
+
+  auto node_dof(m_dofs_on_nodes.nodeDoFConnectivityView());
+
+  ENUMERATE_ (Cell, icell, allCells()) {
+    Cell cell = *icell;
+
+    FixedMatrix<4, 4> K_e = _computeElementMatrixTETRA4(cell); // element stifness matrix
+
+    Int32 n1_index = 0;
+    for (Node node1 : cell.nodes()) {
+      Int32 n2_index = 0;
+      for (Node node2 : cell.nodes()) {
+        Real v = K_e(n1_index, n2_index);
+        if (node1.isOwn()) {
+          m_coo_matrix.matrixAddValue(node_dof.dofId(node1, 0), node_dof.dofId(node2, 0), v);
+        }
+        ++n2_index;
+      }
+      ++n1_index;
+    }
+  }
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
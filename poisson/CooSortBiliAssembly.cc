@@ -15,65 +15,98 @@
 #include "FemModule.h"
 
 /**
- * @brief Initialization of the coo matrix. It only works for p=1 since there is
- * one node per Edge.
- * 
- * 
+ * @brief Initialization of the coo matrix used with sorting.
+ *
+ * The structure of the matrix is not computed: each cell stores the 9 (or 16
+ * for TETRA4) values of its element matrix at its own place. The duplicates are merged after the
+ * assembly by CooFormat::sortAndReduce().
  */
 void FemModule::
 _buildMatrixSort()
 {
-  //Initialization of the coo matrix;
-  //This formula only works in p=1
-
-  /*
-  //Create a connection between nodes through the faces
-  //Useless here because we only need this information once
-  IItemFamily* node_family = mesh()->nodeFamily();
-  NodeGroup nodes = node_family->allItems();
-  auto idx_cn = mesh()->indexedConnectivityMng()->findOrCreateConnectivity(node_family, node_family, "NodeToNeighbourFaceNodes");
-  auto* cn = idx_cn->connectivity();
-  ENUMERATE_NODE (node, allNodes()) {
-  }
-  */
-
-  Int32 nnz = nbFace() * 2 + nbNode();
+  const Int32 nb_node_per_cell = (options()->meshType == "TETRA4") ? 4 : 3;
+  const Int32 nb_value_per_cell = nb_node_per_cell * nb_node_per_cell;
+  Int32 nnz = mesh()->cellFamily()->maxLocalId() * nb_value_per_cell;
   m_coo_matrix.initialize(m_dof_family, nnz);
-  auto node_dof(m_dofs_on_nodes.nodeDoFConnectivityView());
+  // Values which are not set (ghost rows) have a null row and are
+  // removed by sortAndReduce().
+  m_coo_matrix.m_matrix_row.fill(-1);
+}
 
-  //In this commented code, we begin by filling the diagonal before filling what's left by iterating through the nodes. It corresponds to the COO-sort method in the diagrams
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
 
-  //In this one, we begin by filling the diagonal before filling what's left by iterating through the nodes
+void FemModule::
+_assembleCooSortBilinearOperatorTRIA3()
+{
+
+  Timer::Action timer_coosort_bili(m_time_stats, "AssembleCooSortBilinearOperatorTria3");
 
-  //Fill the diagonal
-  ENUMERATE_NODE (inode, allNodes()) {
-    Node node = *inode;
-    m_coo_matrix.setCoordinates(node_dof.dofId(node, 0), node_dof.dofId(node, 0));
+  {
+    Timer::Action timer_build_coosort(m_time_stats, "BuildMatrixCooSort");
+    // Build the coo matrix
+    _buildMatrixSort();
   }
 
-  //Fill what is left
-  ENUMERATE_FACE (iface, allFaces()) {
-    Face face = *iface;
-    auto nodes = face.nodes();
-    for (Int32 i = 0; i < nodes.size() - i - 1; i++) {
-      m_coo_matrix.setCoordinates(node_dof.dofId(nodes[i], 0), node_dof.dofId(nodes[nodes.size() - i - 1], 0));
-      m_coo_matrix.setCoordinates(node_dof.dofId(nodes[nodes.size() - i - 1], 0), node_dof.dofId(nodes[i], 0));
-    }
+  RunQueue* queue = acceleratorMng()->defaultQueue();
+  {
+    auto command = makeCommand(queue);
+
+    auto node_dof(m_dofs_on_nodes.nodeDoFConnectivityView());
+    auto out_row_coo = ax::viewOut(command, m_coo_matrix.m_matrix_row);
+    auto out_col_coo = ax::viewOut(command, m_coo_matrix.m_matrix_column);
+    auto out_val_coo = ax::viewOut(command, m_coo_matrix.m_matrix_value);
+    UnstructuredMeshConnectivityView connectivity_view;
+    auto in_node_coord = ax::viewIn(command, m_node_coord);
+    connectivity_view.setMesh(this->mesh());
+    auto cnc = connectivity_view.cellNode();
+    Arcane::ItemGenericInfoListView nodes_infos(this->mesh()->nodeFamily());
+
+    command << RUNCOMMAND_ENUMERATE(Cell, icell, allCells())
+    {
+      Real K_e[9] = { 0 };
+
+      _computeElementMatrixTRIA3GPU(icell, cnc, in_node_coord, K_e); // element stifness matrix
+
+      //             # assemble elementary matrix into the global one
+      //             # elementary terms are positionned into K according
+      //             # to the rank of associated node in the mesh.nodes list
+      //             for node1 in elem.nodes:
+      //                 inode1=elem.nodes.index(node1) # get position of node1 in nodes list
+      //                 for node2 in elem.nodes:
+      //                     inode2=elem.nodes.index(node2)
+      //                     K[node1.rank,node2.rank]=K[node1.rank,node2.rank]+K_e[inode1,inode2]
+      Int32 index = icell.localId() * 9;
+      Int32 n1_index = 0;
+      for (NodeLocalId node1 : cnc.nodes(icell)) {
+        Int32 n2_index = 0;
+        for (NodeLocalId node2 : cnc.nodes(icell)) {
+          if (nodes_infos.isOwn(node1)) {
+            out_row_coo(index) = node_dof.dofId(node1, 0).localId();
+            out_col_coo(index) = node_dof.dofId(node2, 0).localId();
+            out_val_coo(index) = K_e[n1_index * 3 + n2_index];
+          }
+          ++index;
+          ++n2_index;
+        }
+        ++n1_index;
+      }
+    };
   }
 
-  //Sort the matrix
+  // Sort the matrix and merge the values with the same coordinates
   Timer::Action timer_action(m_time_stats, "SortingCooMatrix");
-  m_coo_matrix.sort();
+  m_coo_matrix.sortAndReduce(*queue);
 }
 
 /*---------------------------------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
 
 void FemModule::
-_assembleCooSortBilinearOperatorTRIA3()
+_assembleCooSortBilinearOperatorTETRA4()
 {
 
-  Timer::Action timer_coosort_bili(m_time_stats, "AssembleCooSortBilinearOperatorTria3");
+  Timer::Action timer_coosort_bili(m_time_stats, "AssembleCooSortBilinearOperatorTetra4");
 
   {
     Timer::Action timer_build_coosort(m_time_stats, "BuildMatrixCooSort");
@@ -81,42 +114,47 @@ _assembleCooSortBilinearOperatorTRIA3()
     _buildMatrixSort();
   }
 
-  auto node_dof(m_dofs_on_nodes.nodeDoFConnectivityView());
-
-  ENUMERATE_ (Cell, icell, allCells()) {
-    Cell cell = *icell;
-
-    FixedMatrix<3, 3> K_e;
+  RunQueue* queue = acceleratorMng()->defaultQueue();
+  {
+    auto command = makeCommand(queue);
+
+    auto node_dof(m_dofs_on_nodes.nodeDoFConnectivityView());
+    auto out_row_coo = ax::viewOut(command, m_coo_matrix.m_matrix_row);
+    auto out_col_coo = ax::viewOut(command, m_coo_matrix.m_matrix_column);
+    auto out_val_coo = ax::viewOut(command, m_coo_matrix.m_matrix_value);
+    UnstructuredMeshConnectivityView connectivity_view;
+    auto in_node_coord = ax::viewIn(command, m_node_coord);
+    connectivity_view.setMesh(this->mesh());
+    auto cnc = connectivity_view.cellNode();
+    Arcane::ItemGenericInfoListView nodes_infos(this->mesh()->nodeFamily());
+
+    command << RUNCOMMAND_ENUMERATE(Cell, icell, allCells())
     {
-      //Timer::Action timer_element_coosort(m_time_stats,"CooSortComputeElementMatrixTria3");
-
-      K_e = _computeElementMatrixTRIA3(cell); // element stifness matrix
-    }
-    //             # assemble elementary matrix into the global one
-    //             # elementary terms are positionned into K according
-    //             # to the rank of associated node in the mesh.nodes list
-    //             for node1 in elem.nodes:
-    //                 inode1=elem.nodes.index(node1) # get position of node1 in nodes list
-    //                 for node2 in elem.nodes:
-    //                     inode2=elem.nodes.index(node2)
-    //                     K[node1.rank,node2.rank]=K[node1.rank,node2.rank]+K_e[inode1,inode2]
-
-    //Timer::Action timer_coosort_add_compute(m_time_stats, "CooSortAddToGlobalMatrix");
-    Int32 n1_index = 0;
-    for (Node node1 : cell.nodes()) {
-      Int32 n2_index = 0;
-      for (Node node2 : cell.nodes()) {
-        // K[node1.rank,node2.rank]=K[node1.rank,node2.rank]+K_e[inode1,inode2]
-        Real v = K_e(n1_index, n2_index);
-        // m_k_matrix(node1.localId(), node2.localId()) += v;
-        if (node1.isOwn()) {
-          m_coo_matrix.matrixAddValue(node_dof.dofId(node1, 0), node_dof.dofId(node2, 0), v);
+      Real K_e[16] = { 0 };
+
+      _computeElementMatrixTETRA4GPU(icell, cnc, in_node_coord, K_e); // element stifness matrix
+
+      Int32 index = icell.localId() * 16;
+      Int32 n1_index = 0;
+      for (NodeLocalId node1 : cnc.nodes(icell)) {
+        Int32 n2_index = 0;
+        for (NodeLocalId node2 : cnc.nodes(icell)) {
+          if (nodes_infos.isOwn(node1)) {
+            out_row_coo(index) = node_dof.dofId(node1, 0).localId();
+            out_col_coo(index) = node_dof.dofId(node2, 0).localId();
+            out_val_coo(index) = K_e[n1_index * 4 + n2_index];
+          }
+          ++index;
+          ++n2_index;
         }
-        ++n2_index;
+        ++n1_index;
       }
-      ++n1_index;
-    }
+    };
   }
+
+  // Sort the matrix and merge the values with the same coordinates
+  Timer::Action timer_action(m_time_stats, "SortingCooMatrix");
+  m_coo_matrix.sortAndReduce(*queue);
 }
 
 /*---------------------------------------------------------------------------*/
@@ -13,80 +13,111 @@
 
 #include "FemModule.h"
 
+#include <arcane/IParallelMng.h>
+
 /**
- * @brief Initialization of the csr matrix. It only works for p=1 since there is
- * one node per Edge.
- * 
- * 
+ * @brief Initialization of the csr matrix.
+ *
+ * The structure is computed from the node-cell connectivity so it works for
+ * any type of cell and does not need the edges or the faces of the mesh.
+ * With the symmetric storage, only the values with column >= row are stored.
  */
 void FemModule::
 _buildMatrixCsr()
 {
-  //Initialization of the coo matrix;
-  //This formula only works in p=1
-
-  /*
-  //Create a connection between nodes through the faces
-  //Useless here because we only need this information once
-  IItemFamily* node_family = mesh()->nodeFamily();
-  NodeGroup nodes = node_family->allItems();
-  auto idx_cn = mesh()->indexedConnectivityMng()->findOrCreateConnectivity(node_family, node_family, "NodeToNeighbourFaceNodes");
-  auto* cn = idx_cn->connectivity();
-  ENUMERATE_NODE (node, allNodes()) {
+  auto node_dof(m_dofs_on_nodes.nodeDoFConnectivityView());
+  RunQueue* queue = acceleratorMng()->defaultQueue();
+  m_csr_matrix.computeSparsity(m_dof_family, mesh(), node_dof, 1, *queue, m_use_symmetric_storage);
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/**
+ * @brief Build the csr matrix and the cell value indexes if needed.
+ *
+ * The structure of the matrix and the indexes of the values of each cell
+ * are kept between two assemblies with the same method @a assembly_name.
+ * In this case only the values are reset.
+ *
+ * @return true if the structure has been kept.
+ */
+bool FemModule::
+_reuseCsrStructure(const String& assembly_name)
+{
+  if (m_csr_matrix.hasCellValueIndexes() && m_csr_structure_name == assembly_name) {
+    m_csr_matrix.clearValues();
+    return true;
+  }
+  m_csr_structure_name = assembly_name;
+  return false;
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/**
+ * @brief Check the product by the matrix stored with the symmetric storage.
+ *
+ * The product by the upper triangular part is compared to the product by
+ * the full matrix, which is assembled again without the symmetric storage.
+ * Only the own DoFs are compared. The symmetric matrix is then assembled
+ * again so the following steps are not modified.
+ */
+void FemModule::
+_checkSymmetricMultiply()
+{
+  RunQueue* queue = acceleratorMng()->defaultQueue();
+  const Int32 nb_dof = m_dof_family->maxLocalId();
+  NumArray<Real, MDDim1> x(nb_dof);
+  NumArray<Real, MDDim1> y_symmetric(nb_dof);
+  NumArray<Real, MDDim1> y_full(nb_dof);
+  ENUMERATE_ (DoF, idof, m_dof_family->allItems()) {
+    x(idof.itemLocalId()) = 1.0 + 0.1 * static_cast<Real>((*idof).uniqueId().asInt64() % 13);
   }
-  */
 
-  Int64   nedge;
-  Int64   nbnde = nbNode();
-  if (options()->meshType == "TETRA4")
-    nedge = nbEdge();
-  else if (options()->meshType == "TRIA3")
-    nedge = nbFace();
-  else
-    ARCANE_THROW(NotImplementedException, "");
+  m_csr_matrix.multiply(*queue, x.to1DSpan(), y_symmetric.to1DSpan());
 
-  Int32 nnz = nedge * 2 + nbnde;
+  m_use_symmetric_storage = false;
+  m_csr_structure_name = String();
+  _assembleBilinearOperator();
+  m_csr_matrix.multiply(*queue, x.to1DSpan(), y_full.to1DSpan());
 
-  m_csr_matrix.initialize(m_dof_family, nnz, nbNode());
-  auto node_dof(m_dofs_on_nodes.nodeDoFConnectivityView());
-  //We iterate through the node, and we do not sort anymore : we assume the nodes ID are sorted, and we will iterate throught the column to avoid making < and > comparison
-  if (options()->meshType == "TRIA3"){
-    ENUMERATE_NODE (inode, allNodes()) {
-      Node node = *inode;
-
-      //info() << "DEBUG Add:   (" << node_dof.dofId(node, 0) << ", " << node_dof.dofId(node, 0) << " )";
-      m_csr_matrix.setCoordinates(node_dof.dofId(node, 0), node_dof.dofId(node, 0));
-
-      for (Face face : node.faces()) {
-        if (face.nodeId(0) == node.localId()){
-          //info() << "DEBUG Add: 0 (" << node_dof.dofId(node, 0) << ", " << node_dof.dofId(face.nodeId(1), 0) << " )";
-          m_csr_matrix.setCoordinates(node_dof.dofId(node, 0), node_dof.dofId(face.nodeId(1), 0));
-        }else{
-          //info() << "DEBUG Add:   (" << node_dof.dofId(node, 0) << ", " << node_dof.dofId(face.nodeId(0), 0) << " )";
-          m_csr_matrix.setCoordinates(node_dof.dofId(node, 0), node_dof.dofId(face.nodeId(0), 0));
-        }
-      }
-    }
+  m_use_symmetric_storage = true;
+  m_csr_structure_name = String();
+  _assembleBilinearOperator();
+
+  Real max_y = 0.0;
+  Real max_diff = 0.0;
+  ENUMERATE_ (DoF, idof, m_dof_family->allItems().own()) {
+    const Int32 i = idof.itemLocalId();
+    max_y = math::max(max_y, math::abs(y_full(i)));
+    max_diff = math::max(max_diff, math::abs(y_full(i) - y_symmetric(i)));
   }
-  else if (options()->meshType == "TETRA"){
-    ENUMERATE_NODE (inode, allNodes()) {
-      Node node = *inode;
-
-      //info() << "DEBUG Add:   (" << node_dof.dofId(node, 0) << ", " << node_dof.dofId(node, 0) << " )";
-      m_csr_matrix.setCoordinates(node_dof.dofId(node, 0), node_dof.dofId(node, 0));
-
-      for (Edge edge : node.edges()) {
-        if (edge.nodeId(0) == node.localId()){
-          //info() << "DEBUG Add: 0 (" << node_dof.dofId(node, 0) << ", " << node_dof.dofId(edge.nodeId(1), 0) << " )";
-          m_csr_matrix.setCoordinates(node_dof.dofId(node, 0), node_dof.dofId(edge.nodeId(1), 0));
-        }else{
-          //info() << "DEBUG Add:   (" << node_dof.dofId(node, 0) << ", " << node_dof.dofId(edge.nodeId(0), 0) << " )";
-          m_csr_matrix.setCoordinates(node_dof.dofId(node, 0), node_dof.dofId(edge.nodeId(0), 0));
-        }
-      }
+  IParallelMng* pm = parallelMng();
+  max_y = pm->reduce(Parallel::ReduceMax, max_y);
+  max_diff = pm->reduce(Parallel::ReduceMax, max_diff);
+  info() << "CheckSymmetricMultiply max_y=" << max_y << " max_diff=" << max_diff;
+  if (max_diff > 1.0e-12 * max_y)
+    ARCANE_FATAL("Symmetric and full products are different max_diff={0} max_y={1}", max_diff, max_y);
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/**
+ * @brief Add the element matrix @a K_e of the cell @a cell to the csr matrix.
+ *
+ * The indexes of the values have been computed by computeCellValueIndexes()
+ * so there is no search in the rows of the matrix.
+ */
+template <int N> void FemModule::
+_addElementMatrixToCsr(CellLocalId cell, const FixedMatrix<N, N>& K_e)
+{
+  for (Int32 n1_index = 0; n1_index < N; ++n1_index) {
+    for (Int32 n2_index = 0; n2_index < N; ++n2_index) {
+      Int32 index = m_csr_matrix.m_cell_value_index(cell.localId(), n1_index * N + n2_index);
+      if (index >= 0)
+        m_csr_matrix.m_matrix_value(index) += K_e(n1_index, n2_index);
     }
   }
-
 }
 
 /*---------------------------------------------------------------------------*/
@@ -97,14 +128,15 @@ _assembleCsrBilinearOperatorTRIA3()
 {
 
   Timer::Action timer_csr_bili(m_time_stats, "AssembleCsrBilinearOperatorTria3");
-  {
+
+  auto node_dof(m_dofs_on_nodes.nodeDoFConnectivityView());
+  if (!_reuseCsrStructure("Csr")) {
     Timer::Action timer_csr_build(m_time_stats, "CsrBuildMatrix");
     // Build the csr matrix
     _buildMatrixCsr();
+    m_csr_matrix.computeCellValueIndexes(allCells(), node_dof);
   }
 
-  auto node_dof(m_dofs_on_nodes.nodeDoFConnectivityView());
-
   ENUMERATE_ (Cell, icell, allCells()) {
     Cell cell = *icell;
 
@@ -123,20 +155,7 @@ _assembleCsrBilinearOperatorTRIA3()
     //                     K[node1.rank,node2.rank]=K[node1.rank,node2.rank]+K_e[inode1,inode2]
 
     //Timer::Action timer_action(m_time_stats, "CsrAddToGlobalMatrix");
-    Int32 n1_index = 0;
-    for (Node node1 : cell.nodes()) {
-      Int32 n2_index = 0;
-      for (Node node2 : cell.nodes()) {
-        // K[node1.rank,node2.rank]=K[node1.rank,node2.rank]+K_e[inode1,inode2]
-        Real v = K_e(n1_index, n2_index);
-        // m_k_matrix(node1.localId(), node2.localId()) += v;
-        if (node1.isOwn()) {
-          m_csr_matrix.matrixAddValue(node_dof.dofId(node1, 0), node_dof.dofId(node2, 0), v);
-        }
-        ++n2_index;
-      }
-      ++n1_index;
-    }
+    _addElementMatrixToCsr(cell.itemLocalId(), K_e);
   }
 }
 
@@ -148,11 +167,13 @@ _assembleCsrBilinearOperatorTETRA4()
 {
 
   Timer::Action timer_csr_bili(m_time_stats, "AssembleCsrBilinearOperatorTetra4");
-  {
-    _buildMatrixCsr();
-  }
 
   auto node_dof(m_dofs_on_nodes.nodeDoFConnectivityView());
+  if (!_reuseCsrStructure("Csr")) {
+    Timer::Action timer_csr_build(m_time_stats, "CsrBuildMatrix");
+    _buildMatrixCsr();
+    m_csr_matrix.computeCellValueIndexes(allCells(), node_dof);
+  }
 
   ENUMERATE_ (Cell, icell, allCells()) {
     Cell cell = *icell;
@@ -163,20 +184,7 @@ _assembleCsrBilinearOperatorTETRA4()
     }
 
     //Timer::Action timer_action(m_time_stats, "CsrAddToGlobalMatrix");
-    Int32 n1_index = 0;
-    for (Node node1 : cell.nodes()) {
-      Int32 n2_index = 0;
-      for (Node node2 : cell.nodes()) {
-        // K[node1.rank,node2.rank]=K[node1.rank,node2.rank]+K_e[inode1,inode2]
-        Real v = K_e(n1_index, n2_index);
-        // m_k_matrix(node1.localId(), node2.localId()) += v;
-        if (node1.isOwn()) {
-          m_csr_matrix.matrixAddValue(node_dof.dofId(node1, 0), node_dof.dofId(node2, 0), v);
-        }
-        ++n2_index;
-      }
-      ++n1_index;
-    }
+    _addElementMatrixToCsr(cell.itemLocalId(), K_e);
   }
 
 }
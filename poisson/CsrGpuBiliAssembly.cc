@@ -37,9 +37,18 @@ _buildMatrixCsrGPU()
   }
   */
 
+  auto node_dof(m_dofs_on_nodes.nodeDoFConnectivityView());
+
+  // In 3D, the structure is computed from the node-cell connectivity
+  // (see _buildMatrixCsr()) so the edges of the mesh are not needed
+  if (options()->meshType == "TETRA4") {
+    RunQueue* queue = acceleratorMng()->defaultQueue();
+    m_csr_matrix.computeSparsity(m_dof_family, mesh(), node_dof, 1, *queue);
+    return;
+  }
+
   Int32 nnz = nbFace() * 2 + nbNode();
   m_csr_matrix.initialize(m_dof_family, nnz, nbNode());
-  auto node_dof(m_dofs_on_nodes.nodeDoFConnectivityView());
   //We iterate through the node, and we do not sort anymore : we assume the nodes ID are sorted, and we will iterate throught the column to avoid making < and > comparison
   ENUMERATE_NODE (inode, allNodes()) {
     Node node = *inode;
@@ -66,27 +75,23 @@ _assembleCsrGPUBilinearOperatorTRIA3()
 
   Timer::Action timer_gpu_bili(m_time_stats, "AssembleCsrGpuBilinearOperatorTria3");
 
-  {
+  if (!_reuseCsrStructure("CsrGpu")) {
     Timer::Action timer_gpu_build(m_time_stats, "CsrGpuBuildMatrix");
     // Build the csr matrix
     _buildMatrixCsrGPU();
+    m_csr_matrix.computeCellValueIndexes(allCells(), m_dofs_on_nodes.nodeDoFConnectivityView());
   }
 
   RunQueue* queue = acceleratorMng()->defaultQueue();
   // Boucle sur les mailles déportée sur accélérateur
   auto command = makeCommand(queue);
 
-  auto node_dof(m_dofs_on_nodes.nodeDoFConnectivityView());
-  auto in_row_csr = ax::viewIn(command, m_csr_matrix.m_matrix_row);
-  Int32 row_csr_size = m_csr_matrix.m_matrix_row.dim1Size();
-  auto in_col_csr = ax::viewIn(command, m_csr_matrix.m_matrix_column);
-  Int32 col_csr_size = m_csr_matrix.m_matrix_column.dim1Size();
+  auto in_cell_value_index = ax::viewIn(command, m_csr_matrix.m_cell_value_index);
   auto in_out_val_csr = ax::viewInOut(command, m_csr_matrix.m_matrix_value);
   UnstructuredMeshConnectivityView m_connectivity_view;
   auto in_node_coord = ax::viewIn(command, m_node_coord);
   m_connectivity_view.setMesh(this->mesh());
   auto cnc = m_connectivity_view.cellNode();
-  Arcane::ItemGenericInfoListView nodes_infos(this->mesh()->nodeFamily());
 
   Timer::Action timer_add_compute(m_time_stats, "CsrGpuAddComputeLoop");
 
@@ -104,33 +109,56 @@ _assembleCsrGPUBilinearOperatorTRIA3()
     //                 for node2 in elem.nodes:
     //                     inode2=elem.nodes.index(node2)
     //                     K[node1.rank,node2.rank]=K[node1.rank,node2.rank]+K_e[inode1,inode2]
-    Int32 n1_index = 0;
-    for (NodeLocalId node1 : cnc.nodes(icell)) {
-      Int32 n2_index = 0;
-      for (NodeLocalId node2 : cnc.nodes(icell)) {
-        // K[node1.rank,node2.rank]=K[node1.rank,node2.rank]+K_e[inode1,inode2]
-        double v = K_e[n1_index * 3 + n2_index];
-        // m_k_matrix(node1.localId(), node2.localId()) += v;
-        if (nodes_infos.isOwn(node1)) {
-
-          Int32 row = node_dof.dofId(node1, 0).localId();
-          Int32 col = node_dof.dofId(node2, 0).localId();
-          Int32 begin = in_row_csr[row];
-          Int32 end = (row == row_csr_size - 1) ? col_csr_size : in_row_csr[row + 1];
-
-          while (begin < end) {
-            if (in_col_csr[begin] == col) {
-              // t is necessary to get the right type for the atomicAdd (but that means that we have more operations ?)
-              // The Macro is there to avoid compilation error if not in c++ 20
-              ax::doAtomic<ax::eAtomicOperation::Add>(in_out_val_csr(begin), v);
-              break;
-            }
-            begin++;
-          }
-        }
-        ++n2_index;
-      }
-      ++n1_index;
+    // The indexes of the values in the csr matrix have been computed
+    // with computeCellValueIndexes(). Values of the rows of the
+    // ghost nodes have a null index.
+    for (Int32 i = 0; i < 9; ++i) {
+      Int32 index = in_cell_value_index(icell.localId(), i);
+      if (index >= 0)
+        ax::doAtomic<ax::eAtomicOperation::Add>(in_out_val_csr(index), K_e[i]);
+    }
+  };
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
+void FemModule::
+_assembleCsrGPUBilinearOperatorTETRA4()
+{
+
+  Timer::Action timer_gpu_bili(m_time_stats, "AssembleCsrGpuBilinearOperatorTetra4");
+
+  if (!_reuseCsrStructure("CsrGpu")) {
+    Timer::Action timer_gpu_build(m_time_stats, "CsrGpuBuildMatrix");
+    // Build the csr matrix
+    _buildMatrixCsrGPU();
+    m_csr_matrix.computeCellValueIndexes(allCells(), m_dofs_on_nodes.nodeDoFConnectivityView());
+  }
+
+  RunQueue* queue = acceleratorMng()->defaultQueue();
+  auto command = makeCommand(queue);
+
+  auto in_cell_value_index = ax::viewIn(command, m_csr_matrix.m_cell_value_index);
+  auto in_out_val_csr = ax::viewInOut(command, m_csr_matrix.m_matrix_value);
+  UnstructuredMeshConnectivityView m_connectivity_view;
+  auto in_node_coord = ax::viewIn(command, m_node_coord);
+  m_connectivity_view.setMesh(this->mesh());
+  auto cnc = m_connectivity_view.cellNode();
+
+  Timer::Action timer_add_compute(m_time_stats, "CsrGpuAddComputeLoop");
+
+  command << RUNCOMMAND_ENUMERATE(Cell, icell, allCells())
+  {
+    Real K_e[16] = { 0 };
+
+    _computeElementMatrixTETRA4GPU(icell, cnc, in_node_coord, K_e); // element stifness matrix
+
+    // See _assembleCsrGPUBilinearOperatorTRIA3()
+    for (Int32 i = 0; i < 16; ++i) {
+      Int32 index = in_cell_value_index(icell.localId(), i);
+      if (index >= 0)
+        ax::doAtomic<ax::eAtomicOperation::Add>(in_out_val_csr(index), K_e[i]);
     }
   };
 }
@@ -317,6 +317,14 @@ _handleFlags()
     m_use_legacy = false;
     info() << "CSR: The CSR datastructure and its associated methods will be used";
   }
+  if (parameter_list.getParameterOrNull("SYMMETRIC_STORAGE") == "TRUE" || options()->symmetricStorage()) {
+    m_use_symmetric_storage = true;
+    info() << "SYMMETRIC_STORAGE: Only the upper triangular part of the CSR matrix will be stored";
+  }
+  if (parameter_list.getParameterOrNull("CHECK_SYMMETRIC_MULTIPLY") == "TRUE" || options()->checkSymmetricMultiply()) {
+    m_check_symmetric_multiply = true;
+    info() << "CHECK_SYMMETRIC_MULTIPLY: The product of the symmetric CSR matrix is compared to the one of the full matrix";
+  }
 #ifdef ARCANE_HAS_ACCELERATOR
   if (parameter_list.getParameterOrNull("CSR_GPU") == "TRUE" || options()->csrGpu()) {
     m_use_csr_gpu = true;
@@ -334,6 +342,10 @@ _handleFlags()
     m_use_legacy = false;
     info() << "BLCSR: The Csr datastructure (GPU compatible) and its associated methods will be used with computation in a nodewise manner with the building phases incorporated in the computation";
   }
+  if (parameter_list.getParameterOrNull("ELEMENT_MATRIX_PREPASS") == "TRUE" || options()->elementMatrixPrepass()) {
+    m_use_element_matrix_prepass = true;
+    info() << "ELEMENT_MATRIX_PREPASS: The element matrices are computed once per cell before the NWCSR and BLCSR node-wise kernels";
+  }
 #ifdef ARCANE_HAS_ACCELERATOR
   if (parameter_list.getParameterOrNull("CUSPARSE_ADD") == "TRUE" || options()->cusparseAdd()) {
     m_use_cusparse_add = true;
@@ -341,6 +353,21 @@ _handleFlags()
     info() << "CUSPARSE_ADD: CUSPARSE and its associated methods will be used";
   }
 #endif
+  if (parameter_list.getParameterOrNull("AUTO_ASSEMBLY") == "TRUE" || options()->autoAssembly()) {
+    m_use_auto_assembly = true;
+    m_use_legacy = false;
+    info() << "AUTO_ASSEMBLY: The fastest assembly method will be selected by timing a trial of each method";
+  }
+  String auto_assembly_cache = parameter_list.getParameterOrNull("AUTO_ASSEMBLY_CACHE");
+  if (auto_assembly_cache != NULL)
+    m_auto_assembly_cache_file = auto_assembly_cache;
+  else if (options()->autoAssemblyCacheFile.isPresent())
+    m_auto_assembly_cache_file = options()->autoAssemblyCacheFile();
+  if (parameter_list.getParameterOrNull("MATRIX_FREE") == "TRUE" || options()->matrixFree()) {
+    m_use_matrix_free = true;
+    m_use_legacy = false;
+    info() << "MATRIX_FREE: No matrix will be built, the operator will be applied element by element in the solver";
+  }
   if (parameter_list.getParameterOrNull("LEGACY") == "TRUE" || m_use_legacy || options()->legacy()) {
     m_use_legacy = true;
     info() << "LEGACY: The Legacy datastructure and its associated methods will be used";
@@ -366,7 +393,49 @@ _doStationarySolve()
   // # get material parameters
   _getMaterialParameters();
 
+  if (m_use_matrix_free) {
+    _doMatrixFreeSolve();
+    _checkResultFile();
+    return;
+  }
+
+  if (m_use_auto_assembly)
+    _selectAssemblyMethod();
+
   // Assemble the FEM bilinear operator (LHS - matrix A)
+  _assembleBilinearOperator();
+  if (m_check_symmetric_multiply && m_use_csr && m_use_symmetric_storage)
+    _checkSymmetricMultiply();
+
+  // Assemble the FEM linear operator (RHS - vector b)
+  if (m_use_buildless_csr || m_use_csr_gpu || m_use_nodewise_csr || m_use_csr) {
+    m_linear_system.clearValues();
+    _assembleCsrGpuLinearOperator();
+    //_assembleCsrLinearOperator();
+    m_csr_matrix.translateToLinearSystem(m_linear_system);
+    _translateRhs();
+  }
+  else{
+    _assembleLinearOperator();
+  }
+
+  _solve();
+
+  // Check results
+  _checkResultFile();
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*!
+ * \brief Assemble the bilinear operator with the methods selected by the flags.
+ */
+void FemModule::
+_assembleBilinearOperator()
+{
+  // Suffix of the timer of the assembly methods for the mesh type
+  const String timer_suffix = (options()->meshType == "TETRA4") ? "Tetra4" : "Tria3";
+
   if (m_use_legacy) {
     m_linear_system.clearValues();
     if (options()->meshType == "TETRA4")
@@ -392,7 +461,7 @@ _doStationarySolve()
     else if (options()->meshType == "TETRA4")
       _assembleCsrBilinearOperatorTETRA4();
     if (m_cache_warming != 1) {
-      m_time_stats->resetStats("AssembleCsrBilinearOperatorTria3");
+      m_time_stats->resetStats(String("AssembleCsrBilinearOperator") + timer_suffix);
       for (cache_index = 1; cache_index < m_cache_warming; cache_index++) {
         m_linear_system.clearValues();
         if (options()->meshType == "TRIA3")
@@ -418,24 +487,36 @@ _doStationarySolve()
 #endif
   if (m_use_coo) {
     m_linear_system.clearValues();
-    _assembleCooBilinearOperatorTRIA3();
+    if (options()->meshType == "TRIA3")
+      _assembleCooBilinearOperatorTRIA3();
+    else if (options()->meshType == "TETRA4")
+      _assembleCooBilinearOperatorTETRA4();
     if (m_cache_warming != 1) {
-      m_time_stats->resetStats("AssembleCooBilinearOperatorTria3");
+      m_time_stats->resetStats(String("AssembleCooBilinearOperator") + timer_suffix);
       for (cache_index = 1; cache_index < m_cache_warming; cache_index++) {
         m_linear_system.clearValues();
-        _assembleCooBilinearOperatorTRIA3();
+        if (options()->meshType == "TRIA3")
+          _assembleCooBilinearOperatorTRIA3();
+        else if (options()->meshType == "TETRA4")
+          _assembleCooBilinearOperatorTETRA4();
       }
     }
     m_coo_matrix.translateToLinearSystem(m_linear_system);
   }
   if (m_use_coo_sort) {
     m_linear_system.clearValues();
-    _assembleCooSortBilinearOperatorTRIA3();
+    if (options()->meshType == "TRIA3")
+      _assembleCooSortBilinearOperatorTRIA3();
+    else if (options()->meshType == "TETRA4")
+      _assembleCooSortBilinearOperatorTETRA4();
     if (m_cache_warming != 1) {
-      m_time_stats->resetStats("AssembleCooSortBilinearOperatorTria3");
+      m_time_stats->resetStats(String("AssembleCooSortBilinearOperator") + timer_suffix);
       for (cache_index = 1; cache_index < m_cache_warming; cache_index++) {
         m_linear_system.clearValues();
-        _assembleCooSortBilinearOperatorTRIA3();
+        if (options()->meshType == "TRIA3")
+          _assembleCooSortBilinearOperatorTRIA3();
+        else if (options()->meshType == "TETRA4")
+          _assembleCooSortBilinearOperatorTETRA4();
       }
     }
     m_coo_matrix.translateToLinearSystem(m_linear_system);
@@ -451,12 +532,18 @@ _doStationarySolve()
 #ifdef ARCANE_HAS_ACCELERATOR
   if (m_use_csr_gpu) {
     m_linear_system.clearValues();
-    _assembleCsrGPUBilinearOperatorTRIA3();
+    if (options()->meshType == "TRIA3")
+      _assembleCsrGPUBilinearOperatorTRIA3();
+    else if (options()->meshType == "TETRA4")
+      _assembleCsrGPUBilinearOperatorTETRA4();
     if (m_cache_warming != 1) {
-      m_time_stats->resetStats("AssembleCsrGpuBilinearOperatorTria3");
+      m_time_stats->resetStats(String("AssembleCsrGpuBilinearOperator") + timer_suffix);
       for (cache_index = 1; cache_index < m_cache_warming; cache_index++) {
         m_linear_system.clearValues();
-        _assembleCsrGPUBilinearOperatorTRIA3();
+        if (options()->meshType == "TRIA3")
+          _assembleCsrGPUBilinearOperatorTRIA3();
+        else if (options()->meshType == "TETRA4")
+          _assembleCsrGPUBilinearOperatorTETRA4();
       }
     }
      m_csr_matrix.translateToLinearSystem(m_linear_system);
@@ -464,12 +551,18 @@ _doStationarySolve()
 #endif
   if (m_use_nodewise_csr) {
     m_linear_system.clearValues();
-    _assembleNodeWiseCsrBilinearOperatorTria3();
+    if (options()->meshType == "TRIA3")
+      _assembleNodeWiseCsrBilinearOperatorTria3();
+    else if (options()->meshType == "TETRA4")
+      _assembleNodeWiseCsrBilinearOperatorTetra4();
     if (m_cache_warming != 1) {
-      m_time_stats->resetStats("AssembleNodeWiseCsrBilinearOperatorTria3");
+      m_time_stats->resetStats(String("AssembleNodeWiseCsrBilinearOperator") + timer_suffix);
       for (cache_index = 1; cache_index < m_cache_warming; cache_index++) {
         m_linear_system.clearValues();
-        _assembleNodeWiseCsrBilinearOperatorTria3();
+        if (options()->meshType == "TRIA3")
+          _assembleNodeWiseCsrBilinearOperatorTria3();
+        else if (options()->meshType == "TETRA4")
+          _assembleNodeWiseCsrBilinearOperatorTetra4();
       }
     }
     m_csr_matrix.translateToLinearSystem(m_linear_system);
@@ -481,7 +574,7 @@ _doStationarySolve()
     if (options()->meshType == "TETRA4")
       _assembleBuildLessCsrBilinearOperatorTetra4();
     if (m_cache_warming != 1) {
-      m_time_stats->resetStats("AssembleBuildLessCsrBilinearOperatorTria3");
+      m_time_stats->resetStats(String("AssembleBuildLessCsrBilinearOperator") + timer_suffix);
       for (cache_index = 1; cache_index < m_cache_warming; cache_index++) {
         m_linear_system.clearValues();
         if (options()->meshType == "TRIA3")
@@ -492,23 +585,6 @@ _doStationarySolve()
     }
     m_csr_matrix.translateToLinearSystem(m_linear_system);
   }
-
-  // Assemble the FEM linear operator (RHS - vector b)
-  if (m_use_buildless_csr || m_use_csr_gpu || m_use_nodewise_csr || m_use_csr) {
-    m_linear_system.clearValues();
-    _assembleCsrGpuLinearOperator();
-    //_assembleCsrLinearOperator();
-    m_csr_matrix.translateToLinearSystem(m_linear_system);
-    _translateRhs();
-  }
-  else{
-    _assembleLinearOperator();
-  }
-
-  _solve();
-
-  // Check results
-  _checkResultFile();
 }
 
 /*---------------------------------------------------------------------------*/
@@ -755,8 +831,14 @@ _assembleLinearOperator()
 
     info() << "Applying Dirichlet boundary condition via "
            << options()->enforceDirichletMethod() << " method ";
-    // The same as before
-    // TODO
+
+    ENUMERATE_ (Node, inode, ownNodes()) {
+      NodeLocalId node_id = *inode;
+      if (m_u_dirichlet[node_id]) {
+        DoFLocalId dof_id = node_dof.dofId(*inode, 0);
+        m_linear_system.eliminateRow(dof_id, m_u[node_id]);
+      }
+    }
   }
   else if (options()->enforceDirichletMethod() == "RowColumnElimination") {
 
@@ -776,8 +858,13 @@ _assembleLinearOperator()
     info() << "Applying Dirichlet boundary condition via "
            << options()->enforceDirichletMethod() << " method ";
 
-    // The same as before
-    // TODO
+    ENUMERATE_ (Node, inode, ownNodes()) {
+      NodeLocalId node_id = *inode;
+      if (m_u_dirichlet[node_id]) {
+        DoFLocalId dof_id = node_dof.dofId(*inode, 0);
+        m_linear_system.eliminateRowColumn(dof_id, m_u[node_id]);
+      }
+    }
   }
   else {
 
@@ -33,6 +33,8 @@
 #include "FemUtils.h"
 #include "DoFLinearSystem.h"
 #include "FemDoFsOnNodes.h"
+#include "FemGeometryCache.h"
+#include "MatrixFreeP1Operator.h"
 
 #include <fstream>
 #include <iostream>
@@ -170,6 +172,8 @@ class FemModule
   , m_coo_matrix(mbi.subDomain())
   , m_csr_matrix(mbi.subDomain())
   , m_time_stats(mbi.subDomain()->timeStats())
+  , m_geometry(mbi.subDomain()->traceMng())
+  , m_matrix_free_operator(mbi.subDomain()->traceMng())
   {
     ICaseMng* cm = mbi.subDomain()->caseMng();
     cm->setTreatWarningAsError(true);
@@ -211,20 +215,37 @@ class FemModule
   bool m_use_coo = false;
   bool m_use_coo_sort = false;
   bool m_use_csr = false;
+  bool m_use_symmetric_storage = false;
+  bool m_check_symmetric_multiply = false;
   bool m_use_csr_gpu = false;
   bool m_use_nodewise_csr = false;
   bool m_use_buildless_csr = false;
+  bool m_use_element_matrix_prepass = false;
   bool m_use_cusparse_add = false;
   bool m_use_legacy = true;
+  bool m_use_matrix_free = false;
+  bool m_use_auto_assembly = false;
+  //! File where the assembly method selected by the auto mode is kept (no file if empty)
+  String m_auto_assembly_cache_file;
   bool m_running_on_gpu = false;
   ITimeStats* m_time_stats;
 
+  FemGeometryCache m_geometry;
+  MatrixFreeP1Operator m_matrix_free_operator;
+
   CooFormat m_coo_matrix;
 
   CsrFormat m_csr_matrix;
+  //! Name of the assembly method which has built the structure of m_csr_matrix
+  String m_csr_structure_name;
 
   NumArray<Real, MDDim1> m_rhs_vect;
 
+  //! Upper triangular part of the element matrix of each cell (see _computeElementMatrixPrePass())
+  NumArray<Real, MDDim2> m_cell_element_matrix;
+  //! Index of each node in each of its cells (see _computeElementMatrixPrePass())
+  NumArray<Int16, MDDim2> m_node_index_in_cells;
+
   std::ofstream logger;
   std::ofstream wbuild;
   std::ofstream timer;
@@ -237,12 +258,18 @@ class FemModule
 
   void _handleFlags();
   void _doStationarySolve();
+  void _assembleBilinearOperator();
+  void _selectAssemblyMethod();
+  String _autoAssemblyCacheKey();
+  void _setAssemblyMethod(const String& name);
   void _getMaterialParameters();
   void _updateBoundayConditions();
   void _checkCellType();
   void _assembleBilinearOperatorTRIA3();
   void _assembleBilinearOperatorTETRA4();
   void _solve();
+  void _doMatrixFreeSolve();
+  void _assembleMatrixFreeRhs();
   void _initBoundaryconditions();
   void _assembleLinearOperator();
   void _applyDirichletBoundaryConditions();
@@ -291,15 +318,20 @@ class FemModule
 #endif
   void _buildMatrix();
   void _assembleCooBilinearOperatorTRIA3();
+  void _assembleCooBilinearOperatorTETRA4();
 
   void _buildMatrixSort();
   void _assembleCooSortBilinearOperatorTRIA3();
+  void _assembleCooSortBilinearOperatorTETRA4();
 
  public:
 
   static ARCCORE_HOST_DEVICE void
   _computeElementMatrixTRIA3GPU(CellLocalId icell, IndexedCellNodeConnectivityView cnc,
                                 ax::VariableNodeReal3InView in_node_coord, Real K_e[9]);
+  static ARCCORE_HOST_DEVICE void
+  _computeElementMatrixTETRA4GPU(CellLocalId icell, IndexedCellNodeConnectivityView cnc,
+                                 ax::VariableNodeReal3InView in_node_coord, Real K_e[16]);
 
  private:
 
@@ -308,6 +340,7 @@ class FemModule
 
   void _buildMatrixCsrGPU();
   void _assembleCsrGPUBilinearOperatorTRIA3();
+  void _assembleCsrGPUBilinearOperatorTETRA4();
 
  private:
 
@@ -321,10 +354,29 @@ class FemModule
   void _assembleCsrBilinearOperatorTRIA3();
   void _assembleCsrBilinearOperatorTETRA4();
   void _buildMatrixCsr();
+  bool _reuseCsrStructure(const String& assembly_name);
+  void _checkSymmetricMultiply();
+  template <int N> void
+  _addElementMatrixToCsr(CellLocalId cell, const FixedMatrix<N, N>& K_e);
  public:
 
   void _buildMatrixNodeWiseCsr();
   void _assembleNodeWiseCsrBilinearOperatorTria3();
+  void _assembleNodeWiseCsrBilinearOperatorTetra4();
+  void _computeElementMatrixPrePass(Int32 nb_node_per_cell);
+  void _assembleNodeWiseCsrFromElementMatrix(Int32 nb_node_per_cell);
+  void _assembleBuildLessCsrFromElementMatrix(Int32 nb_node_per_cell);
+  //! Index of the entry (\a i,\a j) in the upper triangular part of a \a n x \a n symmetric matrix
+  static ARCCORE_HOST_DEVICE Int32
+  _upperTriangularIndex(Int32 i, Int32 j, Int32 n)
+  {
+    if (i > j) {
+      Int32 tmp = i;
+      i = j;
+      j = tmp;
+    }
+    return i * n - (i * (i - 1)) / 2 + (j - i);
+  }
 
   void _buildMatrixBuildLessCsr();
   void _buildMatrixGpuBuildLessCsr();
@@ -410,4 +462,33 @@ _computeElementMatrixTRIA3GPU(CellLocalId icell, IndexedCellNodeConnectivityView
   //return int_cdPi_dPj;
 }
 
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
+ARCCORE_HOST_DEVICE inline void FemModule::
+_computeElementMatrixTETRA4GPU(CellLocalId icell, IndexedCellNodeConnectivityView cnc,
+                               ax::VariableNodeReal3InView in_node_coord, Real K_e[16])
+{
+  // Same element matrix as _computeElementMatrixTETRA4()
+  Real3 m0 = in_node_coord[cnc.nodeId(icell, 0)];
+  Real3 m1 = in_node_coord[cnc.nodeId(icell, 1)];
+  Real3 m2 = in_node_coord[cnc.nodeId(icell, 2)];
+  Real3 m3 = in_node_coord[cnc.nodeId(icell, 3)];
+
+  Real volume = math::abs(math::dot(m1 - m0, math::cross(m2 - m0, m3 - m0))) / 6.0;
+
+  // Gradients of the shape functions multiplied by 6.volume
+  Real3 dPhi[4] = { math::cross(m2 - m1, m1 - m3), math::cross(m3 - m0, m0 - m2),
+                    math::cross(m1 - m0, m0 - m3), math::cross(m0 - m1, m1 - m2) };
+
+  Real mul = 1.0 / (6.0 * volume);
+  Real factor = mul * mul * volume;
+  for (Int32 i = 0; i < 4; ++i) {
+    for (Int32 j = i; j < 4; ++j) {
+      K_e[i * 4 + j] = math::dot(dPhi[i], dPhi[j]) * factor;
+      K_e[j * 4 + i] = K_e[i * 4 + j];
+    }
+  }
+}
+
 #endif
@@ -0,0 +1,144 @@
+﻿// -*- tab-width: 2; indent-tabs-mode: nil; coding: utf-8-with-signature -*-
+//-----------------------------------------------------------------------------
+// Copyright 2000-2024 CEA (www.cea.fr) IFPEN (www.ifpenergiesnouvelles.com)
+// See the top-level COPYRIGHT file for details.
+// SPDX-License-Identifier: Apache-2.0
+//-----------------------------------------------------------------------------
+/*---------------------------------------------------------------------------*/
+/* MatrixFreeSolve.cc                                          (C) 2022-2024 */
+/*                                                                           */
+/* Solve of the Poisson problem without building the global matrix.          */
+/* The conjugate gradient applies the operator element by element.           */
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
+#include "FemModule.h"
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+
+void FemModule::
+_doMatrixFreeSolve()
+{
+  Timer::Action timer_action(m_time_stats, "MatrixFreeSolve");
+
+  RunQueue* queue = acceleratorMng()->defaultQueue();
+
+  {
+    Timer::Action ta1(m_time_stats, "MatrixFreeSetup");
+    m_geometry.computeCellGeometry(allCells(), m_node_coord, *queue);
+    m_geometry.computeFaceGeometry(allFaces(), m_node_coord);
+
+    String scatter = options()->matrixFreeScatter();
+    if (scatter == "atomic")
+      m_matrix_free_operator.setScatter(eMatrixFreeScatter::Atomic);
+    else if (scatter == "gather")
+      m_matrix_free_operator.setScatter(eMatrixFreeScatter::Gather);
+    else
+      ARCANE_FATAL("Invalid value '{0}' for 'matrix-free-scatter'. Valid values are 'atomic' and 'gather'", scatter);
+
+    String preconditioner = options()->matrixFreePreconditioner();
+    if (preconditioner == "none")
+      m_matrix_free_operator.setPreconditioner(eMatrixFreePreconditioner::None);
+    else if (preconditioner == "jacobi")
+      m_matrix_free_operator.setPreconditioner(eMatrixFreePreconditioner::Jacobi);
+    else if (preconditioner == "chebyshev")
+      m_matrix_free_operator.setPreconditioner(eMatrixFreePreconditioner::Chebyshev);
+    else
+      ARCANE_FATAL("Invalid value '{0}' for 'matrix-free-preconditioner'. Valid values are 'none', 'jacobi' and 'chebyshev'",
+                   preconditioner);
+    m_matrix_free_operator.setChebyshevDegree(options()->chebyshevDegree());
+
+    // Poisson operator: K.u = F
+    m_matrix_free_operator.initialize(mesh(), m_geometry, 1.0, 0.0, *queue);
+    m_matrix_free_operator.setDirichletNodes(m_u_dirichlet, *queue);
+  }
+
+  _assembleMatrixFreeRhs();
+
+  {
+    Timer::Action ta1(m_time_stats, "MatrixFreeLinearSystemSolve");
+    // m_u already contains the Dirichlet values, which are kept by the solver
+    m_matrix_free_operator.solve(m_matrix_free_rhs, m_u, options()->matrixFreeEpsilon(),
+                                 options()->matrixFreeMaxIteration(), *queue);
+  }
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*!
+ * \brief Assemble the right hand side on the own nodes which are not Dirichlet.
+ *
+ * The source term f.|e|/(d+1) is gathered by each node from its cells, so
+ * no atomic operation is needed. The Neumann terms are added on the host.
+ */
+void FemModule::
+_assembleMatrixFreeRhs()
+{
+  Timer::Action timer_action(m_time_stats, "MatrixFreeRhsAssembly");
+
+  RunQueue* queue = acceleratorMng()->defaultQueue();
+  const Real source_factor = f / (mesh()->dimension() + 1);
+
+  {
+    auto command = makeCommand(queue);
+
+    UnstructuredMeshConnectivityView m_connectivity_view;
+    m_connectivity_view.setMesh(this->mesh());
+    auto nc = m_connectivity_view.nodeCell();
+
+    auto in_measure = ax::viewIn(command, m_geometry.m_cell_measure);
+    auto in_m_u_dirichlet = ax::viewIn(command, m_u_dirichlet);
+    auto out_rhs = ax::viewOut(command, m_matrix_free_rhs);
+
+    command << RUNCOMMAND_ENUMERATE(Node, node, ownNodes())
+    {
+      Real value = 0.0;
+      if (!in_m_u_dirichlet[node]) {
+        for (CellLocalId cell : nc.cells(node))
+          value += source_factor * math::abs(in_measure(cell.localId()));
+      }
+      out_rhs[node] = value;
+    };
+  }
+
+  //----------------------------------------------
+  // Constant flux term assembly
+  //----------------------------------------------
+  //
+  //  only for noded that are non-Dirichlet
+  //  $int_{dOmega_N}((q.n)*v^h)$
+  //----------------------------------------------
+  for (const auto& bs : options()->neumannBoundaryCondition()) {
+    FaceGroup group = bs->surface();
+    Real value = 0.0;
+    Real valueX = 0.0;
+    Real valueY = 0.0;
+    if (bs->value.isPresent())
+      value = bs->value();
+    else {
+      if (bs->valueX.isPresent())
+        valueX = bs->valueX();
+      if (bs->valueY.isPresent())
+        valueY = bs->valueY();
+    }
+    bool has_value = bs->value.isPresent();
+
+    ENUMERATE_ (Face, iface, group) {
+      Face face = *iface;
+      Real flux = value;
+      if (!has_value) {
+        Real3 normal = m_geometry.faceNormal(face);
+        flux = normal.x * valueX + normal.y * valueY;
+      }
+      Real node_flux = flux * m_geometry.faceMeasure(face) / face.nbNode();
+      for (Node node : face.nodes()) {
+        if (!(m_u_dirichlet[node]) && node.isOwn())
+          m_matrix_free_rhs[node] += node_flux;
+      }
+    }
+  }
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
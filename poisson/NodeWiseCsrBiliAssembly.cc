@@ -20,6 +20,14 @@ void FemModule::_buildMatrixNodeWiseCsr()
 
   auto node_dof(m_dofs_on_nodes.nodeDoFConnectivityView());
 
+  // In 3D, the structure is computed from the node-cell connectivity
+  // (see _buildMatrixCsr()) so the edges of the mesh are not needed
+  if (options()->meshType == "TETRA4") {
+    RunQueue* queue = acceleratorMng()->defaultQueue();
+    m_csr_matrix.computeSparsity(m_dof_family, mesh(), node_dof, 1, *queue);
+    return;
+  }
+
   // Compute the number of nnz and initialize the memory space
   Int32 nnz = nbFace() * 2 + nbNode();
   m_csr_matrix.initialize(m_dof_family, nnz, nbNode());
@@ -64,6 +72,12 @@ void FemModule::_assembleNodeWiseCsrBilinearOperatorTria3()
     _buildMatrixNodeWiseCsr();
   }
 
+  if (m_use_element_matrix_prepass) {
+    _computeElementMatrixPrePass(3);
+    _assembleNodeWiseCsrFromElementMatrix(3);
+    return;
+  }
+
   RunQueue* queue = acceleratorMng()->defaultQueue();
 
   // Boucle sur les noeuds déportée sur accélérateur
@@ -86,6 +100,7 @@ void FemModule::_assembleNodeWiseCsrBilinearOperatorTria3()
   Arcane::ItemGenericInfoListView cells_infos(this->mesh()->cellFamily());
 
   Timer::Action timer_blcsr_add_compute(m_time_stats, "NodeWiseCsrAddAndCompute");
+
   command << RUNCOMMAND_ENUMERATE(Node, inode, allNodes())
   {
     Int32 inode_index = 0;
@@ -158,3 +173,195 @@ void FemModule::_assembleNodeWiseCsrBilinearOperatorTria3()
 
 /*---------------------------------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
+void FemModule::_assembleNodeWiseCsrBilinearOperatorTetra4()
+{
+  Timer::Action timer_nwcsr_bili(m_time_stats, "AssembleNodeWiseCsrBilinearOperatorTetra4");
+  {
+    Timer::Action timer_nwcsr_build(m_time_stats, "NodeWiseCsrBuildMatrix");
+    // Build the csr matrix
+    _buildMatrixNodeWiseCsr();
+  }
+
+  if (m_use_element_matrix_prepass) {
+    _computeElementMatrixPrePass(4);
+    _assembleNodeWiseCsrFromElementMatrix(4);
+    return;
+  }
+
+  RunQueue* queue = acceleratorMng()->defaultQueue();
+  auto command = makeCommand(queue);
+
+  auto node_dof(m_dofs_on_nodes.nodeDoFConnectivityView());
+  auto in_row_csr = ax::viewIn(command, m_csr_matrix.m_matrix_row);
+  Int32 row_csr_size = m_csr_matrix.m_matrix_row.dim1Size();
+  auto in_col_csr = ax::viewIn(command, m_csr_matrix.m_matrix_column);
+  Int32 col_csr_size = m_csr_matrix.m_matrix_column.dim1Size();
+  auto in_out_val_csr = ax::viewInOut(command, m_csr_matrix.m_matrix_value);
+
+  auto in_node_coord = ax::viewIn(command, m_node_coord);
+
+  UnstructuredMeshConnectivityView m_connectivity_view;
+  m_connectivity_view.setMesh(this->mesh());
+  auto ncc = m_connectivity_view.nodeCell();
+  auto cnc = m_connectivity_view.cellNode();
+
+  Timer::Action timer_nwcsr_add_compute(m_time_stats, "NodeWiseCsrAddAndCompute");
+
+  command << RUNCOMMAND_ENUMERATE(Node, inode, ownNodes())
+  {
+    Int32 row = node_dof.dofId(inode, 0).localId();
+    Int32 begin = in_row_csr[row];
+    Int32 end = (row == row_csr_size - 1) ? col_csr_size : in_row_csr[row + 1];
+    for (auto cell : ncc.cells(inode)) {
+      Int32 inode_index = 0;
+      while (cnc.nodeId(cell, inode_index) != inode)
+        ++inode_index;
+
+      Real K_e[16] = { 0 };
+      _computeElementMatrixTETRA4GPU(cell, cnc, in_node_coord, K_e);
+
+      Int32 i = 0;
+      for (NodeLocalId node2 : cnc.nodes(cell)) {
+        Int32 col = node_dof.dofId(node2, 0).localId();
+        for (Int32 k = begin; k < end; ++k) {
+          if (in_col_csr[k] == col) {
+            in_out_val_csr[k] += K_e[inode_index * 4 + i];
+            break;
+          }
+        }
+        i++;
+      }
+    }
+  };
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*!
+ * \brief Node-wise NWCSR kernel using the element matrices computed by
+ * _computeElementMatrixPrePass().
+ */
+void FemModule::
+_assembleNodeWiseCsrFromElementMatrix(Int32 nb_node_per_cell)
+{
+  RunQueue* queue = acceleratorMng()->defaultQueue();
+  auto command = makeCommand(queue);
+
+  auto node_dof(m_dofs_on_nodes.nodeDoFConnectivityView());
+  auto in_row_csr = ax::viewIn(command, m_csr_matrix.m_matrix_row);
+  Int32 row_csr_size = m_csr_matrix.m_matrix_row.dim1Size();
+  auto in_col_csr = ax::viewIn(command, m_csr_matrix.m_matrix_column);
+  Int32 col_csr_size = m_csr_matrix.m_matrix_column.dim1Size();
+  auto in_out_val_csr = ax::viewInOut(command, m_csr_matrix.m_matrix_value);
+  auto in_element_matrix = ax::viewIn(command, m_cell_element_matrix);
+  auto in_node_index = ax::viewIn(command, m_node_index_in_cells);
+
+  UnstructuredMeshConnectivityView m_connectivity_view;
+  m_connectivity_view.setMesh(this->mesh());
+  auto ncc = m_connectivity_view.nodeCell();
+  auto cnc = m_connectivity_view.cellNode();
+
+  Timer::Action timer_nwcsr_add_compute(m_time_stats, "NodeWiseCsrAddAndCompute");
+
+  command << RUNCOMMAND_ENUMERATE(Node, inode, ownNodes())
+  {
+    Int32 row = node_dof.dofId(inode, 0).localId();
+    Int32 begin = in_row_csr[row];
+    Int32 end = (row == row_csr_size - 1) ? col_csr_size : in_row_csr[row + 1];
+    Int32 cell_index = 0;
+    for (auto cell : ncc.cells(inode)) {
+      Int32 inode_index = in_node_index(inode.localId(), cell_index);
+      Int32 i = 0;
+      for (NodeLocalId node2 : cnc.nodes(cell)) {
+        Real x = in_element_matrix(cell.localId(), _upperTriangularIndex(inode_index, i, nb_node_per_cell));
+        Int32 col = node_dof.dofId(node2, 0).localId();
+        for (Int32 k = begin; k < end; ++k) {
+          if (in_col_csr[k] == col) {
+            in_out_val_csr[k] += x;
+            break;
+          }
+        }
+        i++;
+      }
+      cell_index++;
+    }
+  };
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*!
+ * \brief Compute the element matrix of each cell once for the node-wise kernels.
+ *
+ * Without this pre-pass, the NWCSR and BLCSR kernels compute the element
+ * matrix of a cell for each of its nodes. Here the upper triangular part
+ * of the element matrix of each cell is stored in m_cell_element_matrix
+ * and the index of each node in each of its cells is stored in
+ * m_node_index_in_cells, so the node-wise kernels only have to gather the
+ * values. Each cell is written by only one thread so no atomic operation
+ * is needed.
+ *
+ * The node indexes only depend on the connectivity so they are computed
+ * only at the first call.
+ */
+void FemModule::
+_computeElementMatrixPrePass(Int32 nb_node_per_cell)
+{
+  Timer::Action timer_action(m_time_stats, "ElementMatrixPrePass");
+
+  RunQueue* queue = acceleratorMng()->defaultQueue();
+  const bool is_tetra = (nb_node_per_cell == 4);
+  const Int32 nb_value = (nb_node_per_cell * (nb_node_per_cell + 1)) / 2;
+
+  UnstructuredMeshConnectivityView connectivity_view;
+  connectivity_view.setMesh(this->mesh());
+  auto ncc = connectivity_view.nodeCell();
+  auto cnc = connectivity_view.cellNode();
+
+  m_cell_element_matrix.resize(mesh()->cellFamily()->maxLocalId(), nb_value);
+  {
+    auto command = makeCommand(queue);
+    auto in_node_coord = ax::viewIn(command, m_node_coord);
+    auto out_element_matrix = ax::viewOut(command, m_cell_element_matrix);
+
+    command << RUNCOMMAND_ENUMERATE(Cell, icell, allCells())
+    {
+      Real K_e[16] = { 0 };
+      if (is_tetra)
+        _computeElementMatrixTETRA4GPU(icell, cnc, in_node_coord, K_e);
+      else
+        _computeElementMatrixTRIA3GPU(icell, cnc, in_node_coord, K_e);
+      for (Int32 i = 0; i < nb_node_per_cell; ++i)
+        for (Int32 j = i; j < nb_node_per_cell; ++j)
+          out_element_matrix(icell.localId(), _upperTriangularIndex(i, j, nb_node_per_cell)) = K_e[i * nb_node_per_cell + j];
+    };
+  }
+
+  if (m_node_index_in_cells.extent0() == mesh()->nodeFamily()->maxLocalId())
+    return;
+
+  Int32 max_nb_cell = 0;
+  ENUMERATE_ (Node, inode, allNodes()) {
+    max_nb_cell = math::max(max_nb_cell, inode->nbCell());
+  }
+  m_node_index_in_cells.resize(mesh()->nodeFamily()->maxLocalId(), max_nb_cell);
+  {
+    auto command = makeCommand(queue);
+    auto out_node_index = ax::viewOut(command, m_node_index_in_cells);
+
+    command << RUNCOMMAND_ENUMERATE(Node, inode, allNodes())
+    {
+      Int32 cell_index = 0;
+      for (auto cell : ncc.cells(inode)) {
+        Int16 inode_index = 0;
+        while (cnc.nodeId(cell, inode_index) != inode)
+          ++inode_index;
+        out_node_index(inode.localId(), cell_index) = inode_index;
+        cell_index++;
+      }
+    };
+  }
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
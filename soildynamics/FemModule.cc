@@ -17,18 +17,33 @@
 #include <arcane/ItemGroup.h>
 #include <arcane/ICaseMng.h>
 #include <arcane/CaseTable.h>
+#include <arcane/IParallelMng.h>
+
+#include <limits>
+#include <algorithm>
+#include <vector>
+#include <fstream>
+
+#include <arcane/accelerator/core/IAcceleratorMng.h>
+#include <arcane/accelerator/RunCommandEnumerate.h>
+#include <arcane/accelerator/VariableViews.h>
+#include <arcane/accelerator/NumArrayViews.h>
 
 #include "IDoFLinearSystemFactory.h"
 #include "Fem_axl.h"
 #include "FemUtils.h"
 #include "DoFLinearSystem.h"
 #include "FemDoFsOnNodes.h"
+#include "FemGeometryCache.h"
+#include "CsrFormatMatrix.h"
+#include "CentralDifferenceIntegrator.h"
 
 /*---------------------------------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
 
 using namespace Arcane;
 using namespace Arcane::FemUtils;
+namespace ax = Arcane::Accelerator;
 
 /*---------------------------------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
@@ -43,6 +58,10 @@ class FemModule
   explicit FemModule(const ModuleBuildInfo& mbi)
   : ArcaneFemObject(mbi)
   , m_dofs_on_nodes(mbi.subDomain()->traceMng())
+  , m_geometry(mbi.subDomain()->traceMng())
+  , m_explicit_integrator(mbi.subDomain()->traceMng())
+  , m_rhs_mass_matrix(mbi.subDomain())
+  , m_rhs_damping_matrix(mbi.subDomain())
   {
     ICaseMng* cm = mbi.subDomain()->caseMng();
     cm->setTreatWarningAsError(true);
@@ -106,6 +125,38 @@ class FemModule
 
   DoFLinearSystem m_linear_system;
   FemDoFsOnNodes m_dofs_on_nodes;
+  FemGeometryCache m_geometry;
+  CentralDifferenceIntegrator m_explicit_integrator;
+
+  // True if the time discretization is the explicit central difference scheme
+  bool m_is_explicit = false;
+
+  // Constant operators of the right-hand side of the implicit schemes:
+  // the P1 mass matrix and the damping matrix (paraxial boundaries and PML).
+  // They are assembled once and applied to U, V and A at each time step.
+  // The mass matrix is the same for both components: it is stored only on
+  // the rows and columns of the first DoF of each node and applied to each
+  // component. The damping matrix only has values on the rows of the nodes
+  // of the paraxial boundaries and of the PML.
+  CsrFormat m_rhs_mass_matrix;
+  CsrFormat m_rhs_damping_matrix;
+  bool m_has_rhs_operators = false;
+  bool m_has_rhs_damping = false;
+  NumArray<Real, MDDim1> m_rhs_mass_input;
+  NumArray<Real, MDDim1> m_rhs_damping_input;
+  NumArray<Real, MDDim1> m_rhs_mass_output;
+  NumArray<Real, MDDim1> m_rhs_damping_output;
+
+  // Perfectly matched layer (PML)
+  bool m_has_pml = false;
+  // Cells of the layer
+  CellGroup m_pml_cells;
+  // Damping of each cell of the layer: (cell, 0) in x and (cell, 1) in y
+  NumArray<Real, MDDim2> m_pml_damping;
+  // Memory variables of each cell of the layer: (cell, 0) and (cell, 1) are
+  // the filtered x-derivatives of u1 and u2, (cell, 2) and (cell, 3) the
+  // filtered y-derivatives of u1 and u2
+  NumArray<Real, MDDim2> m_pml_psi;
 
   // Struct to make sure we are using a CaseTable associated
   // to the right file
@@ -122,24 +173,37 @@ class FemModule
  private:
 
   void _doStationarySolve();
+  void _doExplicitStep();
+  void _initExplicitScheme();
+  void _assembleExplicitExternalForce(Real time);
   void _getParameters();
   void _updateVariables();
   void _updateTime();
   void _assembleBilinearOperatorTRIA3();
   void _assembleBilinearOperatorEDGE2();
+  void _assembleBilinearOperatorPML();
   void _solve();
   void _assembleLinearOperator();
+  void _assembleRhsOperators();
+  void _computeRhsDampingSparsity();
+  void _addRhsOperatorTerms(VariableDoFReal& rhs_values);
+  void _initPml();
+  void _computeBoundingBox(Real3& box_min, Real3& box_max);
+  Real _computeInteriorEnergy(Real thickness);
+  void _checkInteriorEnergy();
+  void _addPmlTerms(VariableDoFReal& rhs_values);
+  void _updatePmlVariables();
+  Real2 _computePmlHistoryCoefficients(Real damping);
   void _applyDirichletBoundaryConditions();
   void _applyDoubleCoupleLinear();
   void _applyDoubleCoupleBilinear();
   void _checkResultFile();
+  void _writeResultFile();
+  void _doLastTimeStepChecks(bool is_last_time_step);
   void _readCaseTables();
   FixedMatrix<4, 4> _computeElementMatrixEDGE2(Face face);
   FixedMatrix<6, 6> _computeElementMatrixTRIA3(Cell cell);
-  Real _computeAreaTriangle3(Cell cell);
-  Real _computeEdgeLength2(Face face);
   Real2 _computeDxDyOfRealTRIA3(Cell cell);
-  Real2 _computeEdgeNormal2(Face face);
 };
 
 /*---------------------------------------------------------------------------*/
@@ -151,11 +215,19 @@ compute()
   info() << "Module Fem COMPUTE";
 
   // Stop code after computations
-  if (t >= tmax)
+  const bool is_last_time_step = (t >= tmax);
+  if (is_last_time_step)
     subDomain()->timeLoopMng()->stopComputeLoop(true);
 
   info() << "Time iteration at t : " << t << " (s) ";
 
+  if (m_is_explicit) {
+    _doExplicitStep();
+    _updateTime();
+    _doLastTimeStepChecks(is_last_time_step);
+    return;
+  }
+
   // Set if we want to keep the matrix structure between calls.
   // The matrix has to have the same structure (same structure for non-zero)
   bool keep_struct = true;
@@ -170,14 +242,11 @@ compute()
 
   _doStationarySolve();
   _updateVariables();
+  if (m_has_pml)
+    _updatePmlVariables();
   _updateTime();
 
-  // At the last time stepp check error
-  if (t > tmax + dt - 1e-8){
-    info() << "Perfroming check";
-    _checkResultFile();
-  }
-
+  _doLastTimeStepChecks(is_last_time_step);
 }
 
 /*---------------------------------------------------------------------------*/
@@ -190,6 +259,10 @@ startInit()
 
   m_dofs_on_nodes.initialize(mesh(), 2);
 
+  // The mesh does not move: the geometric factors are computed only once
+  m_geometry.computeCellGeometry(allCells(), m_node_coord, *acceleratorMng()->defaultQueue());
+  m_geometry.computeFaceGeometry(allFaces(), m_node_coord);
+
   // # get parameters
   _getParameters();
 
@@ -200,6 +273,11 @@ startInit()
   _readCaseTables();
 
   _applyDirichletBoundaryConditions();
+
+  _initPml();
+
+  if (m_is_explicit)
+    m_explicit_integrator.setFixedDoFs(m_u1_fixed, m_u2_fixed);
 }
 
 /*---------------------------------------------------------------------------*/
@@ -223,6 +301,8 @@ _doStationarySolve()
   if(t<=dt){
     _assembleBilinearOperatorTRIA3();
     _assembleBilinearOperatorEDGE2();
+    if (m_has_pml)
+      _assembleBilinearOperatorPML();
   }
 
   // Assemble the FEM linear operator (RHS - vector b)
@@ -233,6 +313,126 @@ _doStationarySolve()
 
 }
 
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*!
+ * \brief Initialize the explicit central difference scheme.
+ *
+ * Compute the lumped mass and choose the time step from the CFL condition.
+ * The time step given in the dataset is used only if it is smaller.
+ */
+void FemModule::
+_initExplicitScheme()
+{
+  RunQueue* queue = acceleratorMng()->defaultQueue();
+  m_is_explicit = true;
+  m_explicit_integrator.initialize(mesh(), m_geometry, rho, lambda, mu, *queue);
+  dt = m_explicit_integrator.computeTimeStep(dt, options()->cfl(), m_node_coord, 0.0, *queue);
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*!
+ * \brief Do one step of the explicit central difference scheme.
+ *
+ * At the beginning of the step m_U, m_V and m_A are known at t-dt. No linear
+ * system is used: the acceleration is the ratio of the nodal forces and of
+ * the lumped mass.
+ */
+void FemModule::
+_doExplicitStep()
+{
+  RunQueue* queue = acceleratorMng()->defaultQueue();
+  auto compute_external_force = [&](Real time) { _assembleExplicitExternalForce(time); };
+  m_explicit_integrator.doStep(t, dt, m_U, m_V, m_A, m_dU, m_explicit_force, 0.0, 0.0,
+                               *queue, compute_external_force);
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*!
+ * \brief Compute the nodal external force at time \a time for the explicit scheme.
+ *
+ * The body force and the traction are lumped on the nodes. The paraxial
+ * boundaries add a dashpot force computed with the velocity at the half step
+ * and the double-couple sources add nodal forces.
+ */
+void FemModule::
+_assembleExplicitExternalForce(Real time)
+{
+  m_explicit_force.fill(Real3::zero());
+
+  m_explicit_integrator.addLumpedBodyForce(allCells(), Real3(f1, f2, 0.0), m_explicit_force);
+
+  // Index of the boundary condition. Needed to associate a CaseTable
+  Int32 boundary_condition_index = 0;
+  for (const auto& bs : options()->tractionBoundaryCondition()) {
+    FaceGroup group = bs->surface();
+    const CaseTableInfo& case_table_info = m_traction_case_table_list[boundary_condition_index];
+    ++boundary_condition_index;
+
+    Real3 trac = Real3::zero(); // traction in x, y and z
+    if (bs->tractionInputFile.isPresent()) {
+      CaseTable* inn = case_table_info.case_table;
+      if (!inn)
+        ARCANE_FATAL("CaseTable is null. Maybe there is a missing call to _readCaseTables()");
+      inn->value(time, trac);
+      trac.z = 0.0;
+    }
+    else {
+      if (bs->t1.isPresent())
+        trac.x = bs->t1();
+      if (bs->t2.isPresent())
+        trac.y = bs->t2();
+    }
+
+    m_explicit_integrator.addLumpedTraction(group, trac, m_explicit_force);
+  }
+
+  // Paraxial (absorbing) boundaries: traction rho.(cp.(v.n)n + cs.(v.t)t)
+  for (const auto& bs : options()->paraxialBoundaryCondition()) {
+    FaceGroup group = bs->surface();
+    ENUMERATE_ (Face, iface, group) {
+      Face face = *iface;
+      Real length = m_geometry.faceMeasure(face);
+      Real3 normal = m_geometry.faceNormal(face);
+      Real3 tangent(-normal.y, normal.x, 0.0);
+      for (Node node : face.nodes()) {
+        Real3 v = m_V[node];
+        Real3 traction = rho * (cp * math::dot(v, normal) * normal + cs * math::dot(v, tangent) * tangent);
+        m_explicit_force[node] -= traction * length / 2.;
+      }
+    }
+  }
+
+  // Double-couple sources
+  Int32 boundary_condition_index_dc = 0;
+  for (const auto& bs : options()->doubleCouple()) {
+    const CaseTableInfo& case_table_dc_info = m_double_couple_case_table_list[boundary_condition_index_dc];
+    ++boundary_condition_index_dc;
+
+    CaseTable* dc_case_table_inn = case_table_dc_info.case_table;
+    if (!dc_case_table_inn)
+      ARCANE_FATAL("CaseTable is null. Maybe there is a missing call to _readCaseTables()");
+
+    Real dc_force; // double-couple force
+    dc_case_table_inn->value(time, dc_force);
+
+    ENUMERATE_ (Node, inode, bs->northNodeName()) {
+      m_explicit_force[inode].x += dc_force;
+    }
+    ENUMERATE_ (Node, inode, bs->southNodeName()) {
+      m_explicit_force[inode].x -= dc_force;
+    }
+    ENUMERATE_ (Node, inode, bs->eastNodeName()) {
+      m_explicit_force[inode].y -= dc_force;
+    }
+    ENUMERATE_ (Node, inode, bs->westNodeName()) {
+      m_explicit_force[inode].y += dc_force;
+    }
+  }
+}
+
 /*---------------------------------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
 
@@ -322,9 +522,17 @@ _getParameters()
 
     }
 
+  else if (options()->timeDiscretization == "Central-difference") {
+
+    info() << "Apply explicit time discretization via Central-difference ";
+
+    _initExplicitScheme();
+
+    }
+
   else {
 
-    ARCANE_FATAL("Only Newmark-beta | Generalized-alpha are supported for time-discretization ");
+    ARCANE_FATAL("Only Newmark-beta | Generalized-alpha | Central-difference are supported for time-discretization ");
 
     }
 }
@@ -670,7 +878,7 @@ _assembleLinearOperator()
   if ( options()->f1.isPresent()) {
     ENUMERATE_ (Cell, icell, allCells()) {
       Cell cell = *icell;
-      Real area = _computeAreaTriangle3(cell);
+      Real area = m_geometry.cellMeasure(cell);
       for (Node node : cell.nodes()) {
         if (!(m_u1_fixed[node]) && node.isOwn()) {
           DoFLocalId dof_id1 = node_dof.dofId(node, 0);
@@ -683,7 +891,7 @@ _assembleLinearOperator()
   if ( options()->f2.isPresent()) {
     ENUMERATE_ (Cell, icell, allCells()) {
       Cell cell = *icell;
-      Real area = _computeAreaTriangle3(cell);
+      Real area = m_geometry.cellMeasure(cell);
       for (Node node : cell.nodes()) {
         if (!(m_u2_fixed[node]) && node.isOwn()) {
           DoFLocalId dof_id2 = node_dof.dofId(node, 1);
@@ -693,59 +901,19 @@ _assembleLinearOperator()
     }
   }
 
-  ENUMERATE_ (Cell, icell, allCells()) {
-    Cell cell = *icell;
-    Real area = _computeAreaTriangle3(cell);
-
-    Real3 m0 = m_node_coord[cell.nodeId(0)];
-    Real3 m1 = m_node_coord[cell.nodeId(1)];
-    Real3 m2 = m_node_coord[cell.nodeId(2)];
-
-    Real Uold1 = m_U[cell.nodeId(0)].x + m_U[cell.nodeId(1)].x + m_U[cell.nodeId(2)].x;
-    Real Uold2 = m_U[cell.nodeId(0)].y + m_U[cell.nodeId(1)].y + m_U[cell.nodeId(2)].y;
-
-    Real Vold1 = m_V[cell.nodeId(0)].x + m_V[cell.nodeId(1)].x + m_V[cell.nodeId(2)].x;
-    Real Vold2 = m_V[cell.nodeId(0)].y + m_V[cell.nodeId(1)].y + m_V[cell.nodeId(2)].y;
-
-    Real Aold1 = m_A[cell.nodeId(0)].x + m_A[cell.nodeId(1)].x + m_A[cell.nodeId(2)].x;
-    Real Aold2 = m_A[cell.nodeId(0)].y + m_A[cell.nodeId(1)].y + m_A[cell.nodeId(2)].y;
-
-/*
-$$
-\int_{\Omega}(
-                    (U \cdot v) c_0
-                  + (V \cdot v) c_3
-                  + (A \cdot v) c_4
-               )
-$$
-*/
-
-    // Info: We could also use the following logic
-    //    cell.node(i).isOwn();
-    //    cell.node(i);
-    //    Node node = cell.node(i);
-    // Then we can loop 1:3
-    int i = 0;
-    for (Node node : cell.nodes()) {
-      if (node.isOwn()) {
-        DoFLocalId dof_id1 = node_dof.dofId(node, 0);
-        DoFLocalId dof_id2 = node_dof.dofId(node, 1);
-        
-        if (!(m_u1_fixed[node]))
-        rhs_values[dof_id1] +=   (Uold1 + m_U[node].x) * (area / 12.) * c0
-                               + (Vold1 + m_V[node].x) * (area / 12.) * c3
-                               + (Aold1 + m_A[node].x) * (area / 12.) * c4   // TODO add c5 and c6 contribution for Galpha
-                               ;
+  //----------------------------------------------
+  // Mass, paraxial and stiffness terms of the time discretization
+  //----------------------------------------------
+  //
+  //  $int_{Omega}((U.v) c0 + (V.v) c3 + (A.v) c4)$
+  //  $int_{dOmega_P}(c7 (.....))$
+  //  $-int_{Omega}((div(U) div(v)) c5 + (eps(U):eps(v)) c6)$
+  //  only for nodes that are non-Dirichlet
+  //----------------------------------------------
 
-        if (!(m_u2_fixed[node]))
-        rhs_values[dof_id2] +=   (Uold2 + m_U[node].y) * (area / 12.) * c0
-                               + (Vold2 + m_V[node].y) * (area / 12.) * c3
-                               + (Aold2 + m_A[node].y) * (area / 12.) * c4  // TODO add c5 and c6 contribution for Galpha
-                               ;
-      }
-      i++;
-    }
-  }
+  _addRhsOperatorTerms(rhs_values);
+  if (m_has_pml)
+    _addPmlTerms(rhs_values);
 
   //----------------------------------------------
   // Traction term assembly
@@ -786,7 +954,7 @@ $$
 
       ENUMERATE_ (Face, iface, group) {
         Face face = *iface;
-        Real length = _computeEdgeLength2(face);
+        Real length = m_geometry.faceMeasure(face);
         for (Node node : iface->nodes()) {
           if (!(m_u1_fixed[node]) && node.isOwn()) {
             DoFLocalId dof_id1 = node_dof.dofId(node, 0);
@@ -813,7 +981,7 @@ $$
       if( bs->t1.isPresent() && bs->t2.isPresent()) {
         ENUMERATE_ (Face, iface, group) {
           Face face = *iface;
-          Real length = _computeEdgeLength2(face);
+          Real length = m_geometry.faceMeasure(face);
           for (Node node : iface->nodes()) {
             if (!(m_u1_fixed[node]) && node.isOwn()) {
               DoFLocalId dof_id1 = node_dof.dofId(node, 0);
@@ -831,7 +999,7 @@ $$
       if( bs->t1.isPresent()) {
         ENUMERATE_ (Face, iface, group) {
           Face face = *iface;
-        Real length = _computeEdgeLength2(face);
+        Real length = m_geometry.faceMeasure(face);
           for (Node node : iface->nodes()) {
             if (!(m_u1_fixed[node]) && node.isOwn()) {
               DoFLocalId dof_id1 = node_dof.dofId(node, 0);
@@ -845,7 +1013,7 @@ $$
       if( bs->t2.isPresent()) {
         ENUMERATE_ (Face, iface, group) {
           Face face = *iface;
-          Real length = _computeEdgeLength2(face);
+          Real length = m_geometry.faceMeasure(face);
           for (Node node : iface->nodes()) {
             if (!(m_u2_fixed[node]) && node.isOwn()) {
               DoFLocalId dof_id2 = node_dof.dofId(node, 1);
@@ -859,106 +1027,6 @@ $$
     }
   }
 
-  //----------------------------------------------
-  // Paraxial term assembly
-  //----------------------------------------------
-  //
-  //  $int_{dOmega_P}  c7 (.....)
-  //  only for noded that are non-Dirichlet
-  //----------------------------------------------
-
-  for (const auto& bs : options()->paraxialBoundaryCondition()) {
-    FaceGroup group = bs->surface();
-
-    info() << "Applying constant paraxial boundary conditions for surface "<< group.name();
-
-    ENUMERATE_ (Face, iface, group) {
-      Face face = *iface;
-
-      Real  length = _computeEdgeLength2(face);
-      Real2 Normal = _computeEdgeNormal2(face);
-
-      Real f0 = m_U[face.nodeId(0)].x;
-      Real f1 = m_U[face.nodeId(1)].x;
-      Real Uold1 = f0 + f1;
-
-      f0 = m_U[face.nodeId(0)].y;
-      f1 = m_U[face.nodeId(1)].y;
-      Real Uold2 = f0 + f1;
-
-      f0 = m_V[face.nodeId(0)].x;
-      f1 = m_V[face.nodeId(1)].x;
-      Real Vold1 = f0 + f1;
-
-      f0 = m_V[face.nodeId(0)].y;
-      f1 = m_V[face.nodeId(1)].y;
-      Real Vold2 = f0 + f1;
-
-      f0 = m_A[face.nodeId(0)].x;
-      f1 = m_A[face.nodeId(1)].x;
-      Real Aold1 = f0 + f1;
-
-      f0 = m_A[face.nodeId(0)].y;
-      f1 = m_A[face.nodeId(1)].y;
-      Real Aold2 = f0 + f1;
-
-      for (Node node : iface->nodes()) {
-        if (node.isOwn()) {
-          if (!(m_u1_fixed[node])) {
-            DoFLocalId dof_id1 = node_dof.dofId(node, 0);
-             rhs_values[dof_id1] += (  c7*( cp*( Normal.x*Normal.x*(Uold1+m_U[node].x) + Normal.x*Normal.y*(Uold2+m_U[node].y) ) +
-                                           cs*( Normal.y*Normal.y*(Uold1+m_U[node].x) - Normal.x*Normal.y*(Uold2+m_U[node].y) )
-                                         )
-                                    - c8*( cp*( Normal.x*Normal.x*(Vold1+m_V[node].x) + Normal.x*Normal.y*(Vold2+m_V[node].y) ) +
-                                           cs*( Normal.y*Normal.y*(Vold1+m_V[node].x) - Normal.x*Normal.y*(Vold2+m_V[node].y) )
-                                         )
-                                    - c9*( cp*( Normal.x*Normal.x*(Aold1+m_A[node].x) + Normal.x*Normal.y*(Aold2+m_A[node].y) ) +
-                                           cs*( Normal.y*Normal.y*(Aold1+m_A[node].x) - Normal.x*Normal.y*(Aold2+m_A[node].y) )
-                                         )
-                                    ) * length / 6.;
-            /*
-            rhs_values[dof_id1] += (  c7*( cp*( Normal.x*Normal.x*m_U[node].x + Normal.x*Normal.y*m_U[node].y ) +
-                                           cs*( Normal.y*Normal.y*m_U[node].x - Normal.x*Normal.y*m_U[node].y )
-                                         )
-                                    - c8*( cp*( Normal.x*Normal.x*m_V[node].x + Normal.x*Normal.y*m_V[node].y ) +
-                                           cs*( Normal.y*Normal.y*m_V[node].x - Normal.x*Normal.y*m_V[node].y )
-                                         )
-                                    - c9*( cp*( Normal.x*Normal.x*m_A[node].x + Normal.x*Normal.y*m_A[node].y ) +
-                                           cs*( Normal.y*Normal.y*m_A[node].x - Normal.x*Normal.y*m_A[node].y )
-                                         )
-                                    ) * length / 2.;
-                                    */
-          }
-          if (!(m_u2_fixed[node])) {
-            DoFLocalId dof_id2 = node_dof.dofId(node, 1);
-             rhs_values[dof_id2] += (  c7*( cp*( Normal.x*Normal.y*(Uold1+m_U[node].x) + Normal.y*Normal.y*(Uold2+m_U[node].y)) +
-                                           cs*(-Normal.x*Normal.y*(Uold1+m_U[node].x) + Normal.x*Normal.x*(Uold2+m_U[node].y) )
-                                         )
-                                    - c8*( cp*( Normal.x*Normal.y*(Vold1+m_V[node].x) + Normal.y*Normal.y*(Vold2+m_V[node].y) ) +
-                                           cs*(-Normal.x*Normal.y*(Vold1+m_V[node].x) + Normal.x*Normal.x*(Vold2+m_V[node].y) )
-                                         )
-                                    - c9*( cp*( Normal.x*Normal.y*(Aold1+m_A[node].x) + Normal.y*Normal.y*(Aold2+m_A[node].y) ) +
-                                           cs*(-Normal.x*Normal.y*(Aold1+m_A[node].x) + Normal.x*Normal.x*(Aold2+m_A[node].y) )
-                                         )
-                                   ) * length / 6.;
-            /*
-            rhs_values[dof_id2] += (  c7*( cp*( Normal.x*Normal.y*m_U[node].x + Normal.y*Normal.y*m_U[node].y ) +
-                                           cs*(-Normal.x*Normal.y*m_U[node].x + Normal.x*Normal.x*m_U[node].y )
-                                         )
-                                    - c8*( cp*( Normal.x*Normal.y*m_V[node].x + Normal.y*Normal.y*m_V[node].y ) +
-                                           cs*(-Normal.x*Normal.y*m_V[node].x + Normal.x*Normal.x*m_V[node].y )
-                                         )
-                                    - c9*( cp*( Normal.x*Normal.y*m_A[node].x + Normal.y*Normal.y*m_A[node].y ) +
-                                           cs*(-Normal.x*Normal.y*m_A[node].x + Normal.x*Normal.x*m_A[node].y )
-                                         )
-                                   ) * length / 2.;
-                                   */
-          }
-        }
-      }
-    }
-  }
-
   //----------------------------------------------
   // Double-couple term assembly
   //----------------------------------------------
@@ -1019,42 +1087,526 @@ $$
 
 /*---------------------------------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
+/*!
+ * \brief Assemble the constant operators of the right-hand side.
+ *
+ * - the P1 mass matrix: $int_{Omega}(u.v)$ for one component,
+ * - the damping matrix: $int_{dOmega_P}((cp (u.n)n + cs (u.t)t).v)$ for the
+ *   paraxial boundaries and $int_{Omega_PML}((dx+dy) u.v)$ for the PML.
+ *
+ * Only the rows of the own nodes are filled.
+ */
+void FemModule::
+_assembleRhsOperators()
+{
+  info() << "Assembly of the right-hand side operators";
 
-Real FemModule::
-_computeAreaTriangle3(Cell cell)
+  RunQueue* queue = acceleratorMng()->defaultQueue();
+  IItemFamily* dof_family = m_dofs_on_nodes.dofFamily();
+  auto node_dof(m_dofs_on_nodes.nodeDoFConnectivityView());
+
+  // With one DoF per node, only the first DoF of each node is used
+  m_rhs_mass_matrix.computeSparsity(dof_family, mesh(), node_dof, 1, *queue);
+
+  ENUMERATE_ (Cell, icell, allCells()) {
+    Cell cell = *icell;
+    Real area = m_geometry.cellMeasure(cell);
+    for (Node node1 : cell.nodes()) {
+      if (!node1.isOwn())
+        continue;
+      DoFLocalId node1_dof1 = node_dof.dofId(node1, 0);
+      for (Node node2 : cell.nodes()) {
+        Real v = (node1 == node2) ? area / 6. : area / 12.;
+        m_rhs_mass_matrix.matrixAddValue(node1_dof1, node_dof.dofId(node2, 0), v);
+      }
+    }
+  }
+
+  m_has_rhs_damping = m_has_pml || options()->paraxialBoundaryCondition().size() > 0;
+  if (m_has_rhs_damping) {
+    _computeRhsDampingSparsity();
+
+    for (const auto& bs : options()->paraxialBoundaryCondition()) {
+      FaceGroup group = bs->surface();
+      ENUMERATE_ (Face, iface, group) {
+        Face face = *iface;
+        Real length = m_geometry.faceMeasure(face);
+        Real3 Normal = m_geometry.faceNormal(face);
+
+        Real b11 = cp * Normal.x * Normal.x + cs * Normal.y * Normal.y;
+        Real b12 = (cp - cs) * Normal.x * Normal.y;
+        Real b22 = cp * Normal.y * Normal.y + cs * Normal.x * Normal.x;
+
+        for (Node node1 : face.nodes()) {
+          if (!node1.isOwn())
+            continue;
+          DoFLocalId node1_dof1 = node_dof.dofId(node1, 0);
+          DoFLocalId node1_dof2 = node_dof.dofId(node1, 1);
+          for (Node node2 : face.nodes()) {
+            Real w = (node1 == node2) ? length / 3. : length / 6.;
+            DoFLocalId node2_dof1 = node_dof.dofId(node2, 0);
+            DoFLocalId node2_dof2 = node_dof.dofId(node2, 1);
+            m_rhs_damping_matrix.matrixAddValue(node1_dof1, node2_dof1, w * b11);
+            m_rhs_damping_matrix.matrixAddValue(node1_dof1, node2_dof2, w * b12);
+            m_rhs_damping_matrix.matrixAddValue(node1_dof2, node2_dof1, w * b12);
+            m_rhs_damping_matrix.matrixAddValue(node1_dof2, node2_dof2, w * b22);
+          }
+        }
+      }
+    }
+
+    // PML damping: $int_{Omega_PML}((dx+dy) u.v)$
+    if (m_has_pml) {
+      ENUMERATE_ (Cell, icell, m_pml_cells) {
+        Cell cell = *icell;
+        Real area = m_geometry.cellMeasure(cell);
+        Real d = m_pml_damping(cell.localId(), 0) + m_pml_damping(cell.localId(), 1);
+        for (Node node1 : cell.nodes()) {
+          if (!node1.isOwn())
+            continue;
+          DoFLocalId node1_dof1 = node_dof.dofId(node1, 0);
+          DoFLocalId node1_dof2 = node_dof.dofId(node1, 1);
+          for (Node node2 : cell.nodes()) {
+            Real v = (node1 == node2) ? d * area / 6. : d * area / 12.;
+            m_rhs_damping_matrix.matrixAddValue(node1_dof1, node_dof.dofId(node2, 0), v);
+            m_rhs_damping_matrix.matrixAddValue(node1_dof2, node_dof.dofId(node2, 1), v);
+          }
+        }
+      }
+    }
+  }
+
+  const Int32 nb_dof = dof_family->maxLocalId();
+  m_rhs_mass_input.resize(nb_dof);
+  m_rhs_damping_input.resize(nb_dof);
+  m_rhs_mass_output.resize(nb_dof);
+  m_rhs_damping_output.resize(nb_dof);
+  m_rhs_mass_input.fill(0.0);
+  m_rhs_damping_input.fill(0.0);
+
+  m_has_rhs_operators = true;
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*!
+ * \brief Compute the structure of the damping matrix.
+ *
+ * Only the rows of the own nodes of the paraxial faces and of the PML cells
+ * have values: there is a non-zero value between the DoFs of two nodes of
+ * the same face or cell. The other rows are empty.
+ */
+void FemModule::
+_computeRhsDampingSparsity()
 {
-  Real3 m0 = m_node_coord[cell.nodeId(0)];
-  Real3 m1 = m_node_coord[cell.nodeId(1)];
-  Real3 m2 = m_node_coord[cell.nodeId(2)];
-  return 0.5 * ((m1.x - m0.x) * (m2.y - m0.y) - (m2.x - m0.x) * (m1.y - m0.y));
+  IItemFamily* dof_family = m_dofs_on_nodes.dofFamily();
+  auto node_dof(m_dofs_on_nodes.nodeDoFConnectivityView());
+  const Int32 nb_dof = dof_family->maxLocalId();
+
+  // (row, column) of the non-zero values
+  std::vector<std::pair<Int32, Int32>> coordinates;
+  auto add_item = [&](ItemWithNodes item) {
+    for (Node node1 : item.nodes()) {
+      if (!node1.isOwn())
+        continue;
+      for (Node node2 : item.nodes())
+        for (Int32 i = 0; i < 2; ++i)
+          for (Int32 j = 0; j < 2; ++j)
+            coordinates.push_back({ node_dof.dofId(node1, i).localId(), node_dof.dofId(node2, j).localId() });
+    }
+  };
+  for (const auto& bs : options()->paraxialBoundaryCondition()) {
+    ENUMERATE_ (Face, iface, bs->surface()) {
+      add_item(*iface);
+    }
+  }
+  if (m_has_pml) {
+    ENUMERATE_ (Cell, icell, m_pml_cells) {
+      add_item(*icell);
+    }
+  }
+  std::sort(coordinates.begin(), coordinates.end());
+  coordinates.erase(std::unique(coordinates.begin(), coordinates.end()), coordinates.end());
+
+  const Int32 nnz = static_cast<Int32>(coordinates.size());
+  m_rhs_damping_matrix.initialize(dof_family, nnz, nb_dof);
+  Int32 index = 0;
+  for (Int32 row = 0; row < nb_dof; ++row) {
+    m_rhs_damping_matrix.m_matrix_row(row) = index;
+    Int32 begin = index;
+    for (; index < nnz && coordinates[index].first == row; ++index)
+      m_rhs_damping_matrix.m_matrix_column(index) = coordinates[index].second;
+    m_rhs_damping_matrix.m_matrix_rows_nb_column(row) = index - begin;
+  }
+  m_rhs_damping_matrix.m_last_value = nnz;
+  info() << "Damping matrix of the right-hand side nb_non_zero=" << nnz;
 }
 
 /*---------------------------------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
+/*!
+ * \brief Add the mass, paraxial and stiffness terms of the time discretization to \a rhs_values.
+ *
+ * rhs += M (c0 U + c3 V + c4 A) + C (c7 U - c8 V - c9 A) - K_alpha U
+ *
+ * where M is the mass matrix, C the damping matrix and K_alpha the stiffness
+ * matrix computed with c5 and c6 instead of lambda and 2 mu. The stiffness
+ * term is only used by Generalized-alpha (c5 and c6 are zero for
+ * Newmark-beta). It is computed cell by cell because K is not stored.
+ */
+void FemModule::
+_addRhsOperatorTerms(VariableDoFReal& rhs_values)
+{
+  if (!m_has_rhs_operators)
+    _assembleRhsOperators();
 
-Real FemModule::
-_computeEdgeLength2(Face face)
+  RunQueue* queue = acceleratorMng()->defaultQueue();
+  auto node_dof(m_dofs_on_nodes.nodeDoFConnectivityView());
+
+  // The scalar mass matrix is applied to each component
+  for (Int32 component = 0; component < 2; ++component) {
+    const Real m0 = c0, m1 = c3, m2 = c4;
+    {
+      auto command = makeCommand(queue);
+      auto in_u = ax::viewIn(command, m_U);
+      auto in_v = ax::viewIn(command, m_V);
+      auto in_a = ax::viewIn(command, m_A);
+      auto out_mass_input = ax::viewOut(command, m_rhs_mass_input);
+
+      command << RUNCOMMAND_ENUMERATE(Node, node, allNodes())
+      {
+        Real3 w_mass = m0 * in_u[node] + m1 * in_v[node] + m2 * in_a[node];
+        out_mass_input(node_dof.dofId(node, 0).localId()) = (component == 0) ? w_mass.x : w_mass.y;
+      };
+    }
+    m_rhs_mass_matrix.multiply(*queue, m_rhs_mass_input.to1DSpan(), m_rhs_mass_output.to1DSpan());
+
+    const VariableNodeBool& is_fixed = (component == 0) ? m_u1_fixed : m_u2_fixed;
+    ENUMERATE_ (Node, inode, ownNodes()) {
+      Node node = *inode;
+      if (!is_fixed[node])
+        rhs_values[node_dof.dofId(node, component)] += m_rhs_mass_output(node_dof.dofId(node, 0).localId());
+    }
+  }
+
+  if (m_has_rhs_damping) {
+    const Real p0 = c7, p1 = -c8, p2 = -c9;
+    {
+      auto command = makeCommand(queue);
+      auto in_u = ax::viewIn(command, m_U);
+      auto in_v = ax::viewIn(command, m_V);
+      auto in_a = ax::viewIn(command, m_A);
+      auto out_damping_input = ax::viewOut(command, m_rhs_damping_input);
+
+      command << RUNCOMMAND_ENUMERATE(Node, node, allNodes())
+      {
+        Real3 w_damping = p0 * in_u[node] + p1 * in_v[node] + p2 * in_a[node];
+        out_damping_input(node_dof.dofId(node, 0).localId()) = w_damping.x;
+        out_damping_input(node_dof.dofId(node, 1).localId()) = w_damping.y;
+      };
+    }
+    m_rhs_damping_matrix.multiply(*queue, m_rhs_damping_input.to1DSpan(), m_rhs_damping_output.to1DSpan());
+
+    ENUMERATE_ (Node, inode, ownNodes()) {
+      Node node = *inode;
+      if (!(m_u1_fixed[node])) {
+        DoFLocalId dof_id1 = node_dof.dofId(node, 0);
+        rhs_values[dof_id1] += m_rhs_damping_output(dof_id1.localId());
+      }
+      if (!(m_u2_fixed[node])) {
+        DoFLocalId dof_id2 = node_dof.dofId(node, 1);
+        rhs_values[dof_id2] += m_rhs_damping_output(dof_id2.localId());
+      }
+    }
+  }
+
+  if (c5 != 0.0 || c6 != 0.0) {
+    ENUMERATE_ (Cell, icell, allCells()) {
+      Cell cell = *icell;
+      Real area = math::abs(m_geometry.cellMeasure(cell));
+
+      // Gradient of each component of the displacement
+      Real3 du1 = Real3::zero();
+      Real3 du2 = Real3::zero();
+      for (Int32 k = 0; k < 3; ++k) {
+        Real3 gradient = m_geometry.cellGradient(cell, k);
+        Real3 u = m_U[cell.node(k)];
+        du1 += u.x * gradient;
+        du2 += u.y * gradient;
+      }
+      Real div_u = du1.x + du2.y;
+      Real eps_xy = 0.5 * (du1.y + du2.x);
+
+      for (Int32 i = 0; i < 3; ++i) {
+        Node node = cell.node(i);
+        if (!node.isOwn())
+          continue;
+        Real3 gradient = m_geometry.cellGradient(cell, i);
+        if (!(m_u1_fixed[node]))
+          rhs_values[node_dof.dofId(node, 0)] -= area * (c5 * div_u * gradient.x + c6 * (du1.x * gradient.x + eps_xy * gradient.y));
+        if (!(m_u2_fixed[node]))
+          rhs_values[node_dof.dofId(node, 1)] -= area * (c5 * div_u * gradient.y + c6 * (du2.y * gradient.y + eps_xy * gradient.x));
+      }
+    }
+  }
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*!
+ * \brief Initialize the perfectly matched layer.
+ *
+ * The layer is the band of width 'thickness' inside the bounding box of
+ * the mesh, on the selected sides. With the stretching s_x = 1 + dx/(i w)
+ * (and s_y), the equation of motion in the layer becomes
+ *
+ * rho (A + (dx+dy) V + dx dy U) = div(sigma(U))
+ *                                 + dx((dy-dx) Axx psi_x) + dy((dx-dy) Ayy psi_y)
+ *
+ * with Axx = diag(lambda+2mu, mu), Ayy = diag(mu, lambda+2mu) and the memory
+ * variables d(psi_x)/dt + dx psi_x = dx(U), d(psi_y)/dt + dy psi_y = dy(U).
+ * Outside the layer dx = dy = 0 and the usual equation is recovered.
+ *
+ * The damping profile is d(xi) = d0 (xi/L)^n where xi is the distance to
+ * the inner side of the layer, L the thickness and
+ * d0 = (n+1) cp ln(1/R) / (2L) with R the reflection coefficient.
+ */
+void FemModule::
+_initPml()
 {
-  Real3 m0 = m_node_coord[face.nodeId(0)];
-  Real3 m1 = m_node_coord[face.nodeId(1)];
-  return  math::sqrt((m1.x-m0.x)*(m1.x-m0.x) + (m1.y-m0.y)*(m1.y - m0.y));
+  if (options()->perfectlyMatchedLayer().size() == 0)
+    return;
+  if (options()->perfectlyMatchedLayer().size() > 1)
+    ARCANE_FATAL("Only one perfectly-matched-layer is allowed");
+  if (m_is_explicit)
+    ARCANE_FATAL("The perfectly-matched-layer is not supported with the Central-difference time discretization");
+
+  const auto& pml = options()->perfectlyMatchedLayer()[0];
+  const Real thickness = pml->thickness();
+  const Real order = pml->profileOrder();
+  const Real reflection = pml->reflectionCoefficient();
+  if (thickness <= 0.0)
+    ARCANE_FATAL("The thickness of the perfectly-matched-layer has to be positive (thickness={0})", thickness);
+  if (reflection <= 0.0 || reflection >= 1.0)
+    ARCANE_FATAL("The reflection coefficient has to be in ]0,1[ (value={0})", reflection);
+
+  Real d0 = (order + 1.) * cp * math::log(1. / reflection) / (2. * thickness);
+  if (pml->damping.isPresent())
+    d0 = pml->damping();
+
+  Real3 box_min;
+  Real3 box_max;
+  _computeBoundingBox(box_min, box_max);
+
+  auto profile = [&](Real distance) {
+    if (distance <= 0.0)
+      return 0.0;
+    return d0 * math::pow(math::min(distance / thickness, 1.0), order);
+  };
+
+  const Int32 nb_cell = mesh()->cellFamily()->maxLocalId();
+  m_pml_damping.resize(nb_cell, 2);
+  m_pml_damping.fill(0.0);
+  m_pml_psi.resize(nb_cell, 4);
+  m_pml_psi.fill(0.0);
+
+  UniqueArray<Int32> pml_cell_ids;
+  ENUMERATE_ (Cell, icell, allCells()) {
+    Cell cell = *icell;
+    Real3 center;
+    for (Node node : cell.nodes())
+      center += m_node_coord[node];
+    center /= cell.nbNode();
+
+    Real dx = 0.0;
+    Real dy = 0.0;
+    if (pml->left())
+      dx = math::max(dx, profile(box_min.x + thickness - center.x));
+    if (pml->right())
+      dx = math::max(dx, profile(center.x - (box_max.x - thickness)));
+    if (pml->bottom())
+      dy = math::max(dy, profile(box_min.y + thickness - center.y));
+    if (pml->top())
+      dy = math::max(dy, profile(center.y - (box_max.y - thickness)));
+
+    if (dx > 0.0 || dy > 0.0) {
+      m_pml_damping(cell.localId(), 0) = dx;
+      m_pml_damping(cell.localId(), 1) = dy;
+      pml_cell_ids.add(cell.localId());
+    }
+  }
+  m_pml_cells = mesh()->cellFamily()->createGroup("PmlCells", pml_cell_ids, true);
+  m_has_pml = true;
+
+  info() << "Perfectly matched layer: thickness=" << thickness << " order=" << order
+         << " d0=" << d0 << " nb_cell=" << m_pml_cells.size();
 }
 
 /*---------------------------------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
+/*!
+ * \brief Compute the bounding box of the mesh (in the plane z=0).
+ */
+void FemModule::
+_computeBoundingBox(Real3& box_min, Real3& box_max)
+{
+  const Real max_value = std::numeric_limits<Real>::max();
+  box_min = Real3(max_value, max_value, 0.0);
+  box_max = Real3(-max_value, -max_value, 0.0);
+  ENUMERATE_ (Node, inode, ownNodes()) {
+    Real3 coord = m_node_coord[inode];
+    box_min.x = math::min(box_min.x, coord.x);
+    box_min.y = math::min(box_min.y, coord.y);
+    box_max.x = math::max(box_max.x, coord.x);
+    box_max.y = math::max(box_max.y, coord.y);
+  }
+  IParallelMng* pm = subDomain()->parallelMng();
+  box_min.x = pm->reduce(Parallel::ReduceMin, box_min.x);
+  box_min.y = pm->reduce(Parallel::ReduceMin, box_min.y);
+  box_max.x = pm->reduce(Parallel::ReduceMax, box_max.x);
+  box_max.y = pm->reduce(Parallel::ReduceMax, box_max.y);
+}
 
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*!
+ * \brief Coefficients (a, b) of the update psi(n+1) = a psi(n) + b grad(U(n+1)).
+ *
+ * The memory equation d(psi)/dt + d psi = grad(U) is integrated exactly
+ * with grad(U) constant on the time step.
+ */
 Real2 FemModule::
-_computeEdgeNormal2(Face face)
+_computePmlHistoryCoefficients(Real damping)
 {
-  Real3 m0 = m_node_coord[face.nodeId(0)];
-  Real3 m1 = m_node_coord[face.nodeId(1)];
-  if (!face.isSubDomainBoundaryOutside())
-    std::swap(m0,m1);
-  Real2 N;
-  Real norm_N = math::sqrt( (m1.y - m0.y)*(m1.y - m0.y) + (m1.x - m0.x)*(m1.x - m0.x) );   // for normalizing
-  N.x = (m1.y - m0.y)/ norm_N;
-  N.y = (m0.x - m1.x)/ norm_N;
-  return  N;
+  if (damping * dt < 1.e-12)
+    return Real2(1.0, dt);
+  Real a = math::exp(-damping * dt);
+  return Real2(a, (1. - a) / damping);
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*!
+ * \brief Assemble the PML terms of the bilinear operator.
+ *
+ * $int_{Omega_PML}((c7 (dx+dy) + rho dx dy) u.v)$
+ * $+ int_{Omega_PML}(bx (dy-dx) Axx dx(u).dx(v) + by (dx-dy) Ayy dy(u).dy(v))$
+ *
+ * where c7 (dx+dy) is the Newmark coefficient of the PML damping and bx, by
+ * come from the update of the memory variables.
+ */
+void FemModule::
+_assembleBilinearOperatorPML()
+{
+  info() << "Assembly of the PML bilinear operator";
+
+  auto node_dof(m_dofs_on_nodes.nodeDoFConnectivityView());
+  const Real lambda_2mu = lambda + 2. * mu;
+
+  ENUMERATE_ (Cell, icell, m_pml_cells) {
+    Cell cell = *icell;
+    Real area = m_geometry.cellMeasure(cell);
+    Real dx = m_pml_damping(cell.localId(), 0);
+    Real dy = m_pml_damping(cell.localId(), 1);
+    Real bx = (dy - dx) * _computePmlHistoryCoefficients(dx).y;
+    Real by = (dx - dy) * _computePmlHistoryCoefficients(dy).y;
+    Real mass_coef = c7 * (dx + dy) + rho * dx * dy;
+
+    Int32 n1_index = 0;
+    for (Node node1 : cell.nodes()) {
+      if (node1.isOwn()) {
+        Real3 grad1 = m_geometry.cellGradient(cell, n1_index);
+        DoFLocalId node1_dof1 = node_dof.dofId(node1, 0);
+        DoFLocalId node1_dof2 = node_dof.dofId(node1, 1);
+        Int32 n2_index = 0;
+        for (Node node2 : cell.nodes()) {
+          Real3 grad2 = m_geometry.cellGradient(cell, n2_index);
+          Real m = mass_coef * ((node1 == node2) ? area / 6. : area / 12.);
+          Real kx = bx * area * grad1.x * grad2.x;
+          Real ky = by * area * grad1.y * grad2.y;
+          m_linear_system.matrixAddValue(node1_dof1, node_dof.dofId(node2, 0), m + lambda_2mu * kx + mu * ky);
+          m_linear_system.matrixAddValue(node1_dof2, node_dof.dofId(node2, 1), m + mu * kx + lambda_2mu * ky);
+          ++n2_index;
+        }
+      }
+      ++n1_index;
+    }
+  }
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*!
+ * \brief Add the contribution of the memory variables to the RHS.
+ *
+ * $-int_{Omega_PML}(ax (dy-dx) Axx psi_x.dx(v) + ay (dx-dy) Ayy psi_y.dy(v))$
+ */
+void FemModule::
+_addPmlTerms(VariableDoFReal& rhs_values)
+{
+  auto node_dof(m_dofs_on_nodes.nodeDoFConnectivityView());
+  const Real lambda_2mu = lambda + 2. * mu;
+
+  ENUMERATE_ (Cell, icell, m_pml_cells) {
+    Cell cell = *icell;
+    Int32 lid = cell.localId();
+    Real area = m_geometry.cellMeasure(cell);
+    Real dx = m_pml_damping(lid, 0);
+    Real dy = m_pml_damping(lid, 1);
+    Real ax = (dy - dx) * _computePmlHistoryCoefficients(dx).x;
+    Real ay = (dx - dy) * _computePmlHistoryCoefficients(dy).x;
+
+    // Stress-like vectors Axx psi_x and Ayy psi_y
+    Real3 sx(lambda_2mu * m_pml_psi(lid, 0), mu * m_pml_psi(lid, 1), 0.0);
+    Real3 sy(mu * m_pml_psi(lid, 2), lambda_2mu * m_pml_psi(lid, 3), 0.0);
+
+    Int32 n_index = 0;
+    for (Node node : cell.nodes()) {
+      if (node.isOwn()) {
+        Real3 grad = m_geometry.cellGradient(cell, n_index);
+        Real3 f = (ax * grad.x) * sx + (ay * grad.y) * sy;
+        if (!(m_u1_fixed[node]))
+          rhs_values[node_dof.dofId(node, 0)] -= area * f.x;
+        if (!(m_u2_fixed[node]))
+          rhs_values[node_dof.dofId(node, 1)] -= area * f.y;
+      }
+      ++n_index;
+    }
+  }
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*!
+ * \brief Update the memory variables of the PML with the new displacement.
+ *
+ * This is done for all the cells of the layer (own and ghost) because the
+ * displacement is synchronized.
+ */
+void FemModule::
+_updatePmlVariables()
+{
+  ENUMERATE_ (Cell, icell, m_pml_cells) {
+    Cell cell = *icell;
+    Int32 lid = cell.localId();
+    Real2 coef_x = _computePmlHistoryCoefficients(m_pml_damping(lid, 0));
+    Real2 coef_y = _computePmlHistoryCoefficients(m_pml_damping(lid, 1));
+
+    Real3 grad_u1;
+    Real3 grad_u2;
+    Int32 n_index = 0;
+    for (Node node : cell.nodes()) {
+      Real3 grad = m_geometry.cellGradient(cell, n_index);
+      grad_u1 += m_U[node].x * grad;
+      grad_u2 += m_U[node].y * grad;
+      ++n_index;
+    }
+
+    m_pml_psi(lid, 0) = coef_x.x * m_pml_psi(lid, 0) + coef_x.y * grad_u1.x;
+    m_pml_psi(lid, 1) = coef_x.x * m_pml_psi(lid, 1) + coef_x.y * grad_u2.x;
+    m_pml_psi(lid, 2) = coef_y.x * m_pml_psi(lid, 2) + coef_y.y * grad_u1.y;
+    m_pml_psi(lid, 3) = coef_y.x * m_pml_psi(lid, 3) + coef_y.y * grad_u2.y;
+  }
 }
 
 /*---------------------------------------------------------------------------*/
@@ -1071,15 +1623,12 @@ _computeElementMatrixTRIA3(Cell cell)
   //                 .     .
   //              1 o . . . o 2
   //------------------------------------------------
-  Real3 m0 = m_node_coord[cell.nodeId(0)];
-  Real3 m1 = m_node_coord[cell.nodeId(1)];
-  Real3 m2 = m_node_coord[cell.nodeId(2)];
+  Real area = m_geometry.cellMeasure(cell);    // area of the cell
 
-  Real area = _computeAreaTriangle3(cell);    // calculate area
-
-  Real2 dPhi0(m1.y - m2.y, m2.x - m1.x);
-  Real2 dPhi1(m2.y - m0.y, m0.x - m2.x);
-  Real2 dPhi2(m0.y - m1.y, m1.x - m0.x);
+  // dPhi_i = 2 * area * grad(Phi_i)
+  Real3 dPhi0 = m_geometry.cellGradient(cell, 0) * (2. * area);
+  Real3 dPhi1 = m_geometry.cellGradient(cell, 1) * (2. * area);
+  Real3 dPhi2 = m_geometry.cellGradient(cell, 2) * (2. * area);
 
   FixedMatrix<1, 6> b_matrix;
   FixedMatrix<6, 1> bT_matrix;
@@ -1411,11 +1960,8 @@ _computeElementMatrixEDGE2(Face face)
   //                   o . . . . o
   //
   //------------------------------------------------
-  Real3 m0 = m_node_coord[face.nodeId(0)];
-  Real3 m1 = m_node_coord[face.nodeId(1)];
-
-  Real area = _computeEdgeLength2(face);    // calculate length
-  Real2 N   = _computeEdgeNormal2(face);
+  Real area = m_geometry.faceMeasure(face);    // length of the face
+  Real3 N    = m_geometry.faceNormal(face);
 
   FixedMatrix<1, 4> b_matrix;
   FixedMatrix<4, 1> bT_matrix;
@@ -1634,10 +2180,7 @@ _solve()
   // Re-Apply boundary conditions because the solver has modified the value
   _applyDirichletBoundaryConditions();  // ************ CHECK
 
-  m_dU.synchronize();
-  m_U.synchronize();
-  m_V.synchronize();
-  m_A.synchronize();
+  synchronizeVariables(m_dU, m_U, m_V, m_A);
 
   const bool do_print = (allNodes().size() < 200);
   if (do_print) {
@@ -1665,7 +2208,129 @@ _checkResultFile()
   if (filename.empty())
     return;
   const double epsilon = 1.0e-4;
-  Arcane::FemUtils::checkNodeResultFile(traceMng(), filename, m_dU, epsilon);
+  Arcane::FemUtils::checkNodeResultFile(traceMng(), filename, m_U, epsilon);
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*!
+ * \brief Write the displacement in the file given by 'result-output-file'.
+ *
+ * The file can be used as the 'result-file' of another run, for example to
+ * compare the results of the explicit scheme in sequential and in parallel.
+ */
+void FemModule::
+_writeResultFile()
+{
+  String filename = options()->resultOutputFile();
+  if (filename.empty())
+    return;
+  Arcane::FemUtils::writeNodeResultFile(traceMng(), filename, m_U);
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*!
+ * \brief Write and check the displacement at the end of the last time step.
+ *
+ * For the implicit schemes m_U is updated from the solution of the linear
+ * system by _updateVariables().
+ */
+void FemModule::
+_doLastTimeStepChecks(bool is_last_time_step)
+{
+  if (!is_last_time_step)
+    return;
+  _writeResultFile();
+  _checkResultFile();
+  _checkInteriorEnergy();
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*!
+ * \brief Energy of the cells at a distance greater than \a thickness from
+ * the boundary of the bounding box of the mesh.
+ *
+ * It is the sum of the kinetic energy, computed with the lumped mass, and of
+ * the elastic energy. When the sources are switched off, this energy comes
+ * from the waves reflected by the absorbing boundaries (paraxial or PML).
+ */
+Real FemModule::
+_computeInteriorEnergy(Real thickness)
+{
+  Real3 box_min;
+  Real3 box_max;
+  _computeBoundingBox(box_min, box_max);
+
+  Real energy = 0.0;
+  ENUMERATE_ (Cell, icell, ownCells()) {
+    Cell cell = *icell;
+    const Int32 nb_node = cell.nbNode();
+    Real3 center;
+    for (Node node : cell.nodes())
+      center += m_node_coord[node];
+    center /= nb_node;
+    if (center.x < box_min.x + thickness || center.x > box_max.x - thickness ||
+        center.y < box_min.y + thickness || center.y > box_max.y - thickness)
+      continue;
+
+    Real area = math::abs(m_geometry.cellMeasure(cell));
+    Real3 du1 = Real3::zero();
+    Real3 du2 = Real3::zero();
+    Real kinetic = 0.0;
+    for (Int32 k = 0; k < nb_node; ++k) {
+      Node node = cell.node(k);
+      Real3 gradient = m_geometry.cellGradient(cell, k);
+      du1 += m_U[node].x * gradient;
+      du2 += m_U[node].y * gradient;
+      kinetic += math::dot(m_V[node], m_V[node]);
+    }
+    Real eps_xx = du1.x;
+    Real eps_yy = du2.y;
+    Real eps_xy = 0.5 * (du1.y + du2.x);
+    Real div_u = eps_xx + eps_yy;
+    Real elastic = lambda * div_u * div_u + 2. * mu * (eps_xx * eps_xx + eps_yy * eps_yy + 2. * eps_xy * eps_xy);
+    energy += 0.5 * area * (rho * kinetic / nb_node + elastic);
+  }
+  return parallelMng()->reduce(Parallel::ReduceSum, energy);
+}
+
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*!
+ * \brief Write and check the interior energy at the end of the computation.
+ *
+ * The check fails if the energy is greater than the one of the file
+ * 'interior-energy-reference-file', which is usually written by a run with
+ * another absorbing boundary.
+ */
+void FemModule::
+_checkInteriorEnergy()
+{
+  if (!options()->interiorEnergyThickness.isPresent())
+    return;
+  Real energy = _computeInteriorEnergy(options()->interiorEnergyThickness());
+  info() << "Interior energy=" << energy;
+
+  String output_filename = options()->interiorEnergyOutputFile();
+  if (!output_filename.empty() && parallelMng()->isMasterIO()) {
+    std::ofstream ofile(output_filename.localstr());
+    ofile.precision(17);
+    ofile << energy << "\n";
+  }
+
+  String reference_filename = options()->interiorEnergyReferenceFile();
+  if (reference_filename.empty())
+    return;
+  std::ifstream ifile(reference_filename.localstr());
+  Real reference_energy = 0.0;
+  if (!(ifile >> reference_energy))
+    ARCANE_FATAL("Can not read the interior energy in file '{0}'", reference_filename);
+  info() << "Reference interior energy=" << reference_energy;
+  if (energy > reference_energy)
+    ARCANE_FATAL("The interior energy ({0}) is greater than the one of '{1}' ({2})",
+                 energy, reference_filename, reference_energy);
 }
 
 /*---------------------------------------------------------------------------*/